@@ -19,6 +19,7 @@
 #include "Joystick.h"
 #include "RGBLeds.h"
 #include "LCDLib.h"
+#include "BusStats.h"
 #include "cc3100_usage.h"
 
 /********************************** Public Functions **************************************/
@@ -0,0 +1,171 @@
+/*
+ * BusStats.h
+ *
+ * Traffic accounting for the board's SPI and I2C buses
+ *  - The drivers count every byte they move and the time they spend moving
+ *    it (DWT cycle counter, started by BusStats_Init): SPISendRecvByte and the
+ *    DMA transfers on the LCD bus, writeI2C, readI2C and readBurstI2C on the
+ *    sensor bus, LP3943_LedModeSet on the LED bus
+ *  - Traffic is charged to the thread that made it, as told by the thread
+ *    hook; before the hook is set (and for threads past BUSSTATS_MAX_THREADS)
+ *    it is charged to BUSSTATS_NO_THREAD
+ *  - A span (BusStats_Begin / BusStats_End) charges what its thread moved in
+ *    between to a named operation, e.g. one LCD_DrawRectangle or one sensor
+ *    read. Spans nest, an outer span includes the inner ones, and a thread
+ *    preempted inside a span is not charged for what other threads moved
+ *  - Operations are told apart by the address of their name and the thread,
+ *    so names should be string constants
+ *  - Counting from interrupt handlers charges the interrupted thread
+ *  - Adding a thread or operation, copying a record and BusStats_Reset hold
+ *    off interrupts up to the kernel ceiling, like G8RTOS critical sections;
+ *    higher priority interrupts (I2C, CC3100) keep running
+ */
+
+#ifndef BUSSTATS_H_
+#define BUSSTATS_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include "msp.h"
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+/* Threads and (operation, thread) pairs counted separately */
+#define BUSSTATS_MAX_THREADS        16
+#define BUSSTATS_MAX_OPERATIONS     24
+
+/* SRAM the counters may take, counted in the application's RAM budget (checked in BusStats.c) */
+#define BUSSTATS_RAM_BYTES          2688
+
+/* Interrupts at or below this priority are held off while a record is added or copied;
+ * must equal KERNEL_CEILING_PRIORITY (checked by G8RTOS_Scheduler.c) */
+#define BUSSTATS_CEILING_PRIORITY   1
+#define BUSSTATS_CEILING_BASEPRI    (BUSSTATS_CEILING_PRIORITY << (8 - __NVIC_PRIO_BITS))
+
+/* Thread traffic is charged to before the thread hook is set */
+#define BUSSTATS_NO_THREAD          0xFFFFFFFF
+
+/* Cycle count drivers take before a transfer and pass to BusStats_Count after it */
+#define BUSSTATS_NOW()              (DWT->CYCCNT)
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*
+ * Buses counted
+ */
+typedef enum
+{
+    BUS_LCD_SPI = 0,    // EUSCI_B3: LCD and touch panel
+    BUS_SENSOR_I2C,     // EUSCI_B1: BMI160, BME280, OPT3001, TMP007
+    BUS_LED_I2C,        // EUSCI_B2: LP3943s
+    BUS_COUNT
+} bus_t;
+
+/*
+ * Traffic on one bus
+ */
+typedef struct
+{
+    uint32_t bytes;     // bytes on the wire, I2C addresses and register pointers included
+    uint32_t us;        // time the drivers spent on them
+} bus_traffic_t;
+
+/*
+ * Traffic of one thread
+ */
+typedef struct
+{
+    uint32_t thread;
+    bus_traffic_t bus[BUS_COUNT];
+} bus_thread_stats_t;
+
+/*
+ * Traffic of one operation, in one thread
+ */
+typedef struct
+{
+    const char* name;
+    uint32_t thread;
+    uint32_t calls;     // spans ended
+    uint32_t worstUs;   // slowest span, all buses together
+    bus_traffic_t bus[BUS_COUNT];
+} bus_operation_stats_t;
+
+/*
+ * Copy of every counter (see BusStats_Snapshot)
+ */
+typedef struct
+{
+    bus_traffic_t total[BUS_COUNT];
+    uint8_t threadCount;
+    uint8_t operationCount;
+    uint32_t droppedSpans;  // spans of operations that found no free slot
+    bus_thread_stats_t threads[BUSSTATS_MAX_THREADS];
+    bus_operation_stats_t operations[BUSSTATS_MAX_OPERATIONS];
+} busstats_snapshot_t;
+
+/*
+ * A span in progress, kept by the caller (usually on its stack)
+ */
+typedef struct
+{
+    const char* name;
+    uint32_t generation;
+    uint32_t bytes[BUS_COUNT];
+    uint64_t cycles[BUS_COUNT];
+} bus_span_t;
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+/*
+ * Starts the DWT cycle counter and clears every counter
+ * Param "cpuHz": frequency of the cycle counter, to turn cycles into us
+ */
+void BusStats_Init(uint32_t cpuHz);
+
+/*
+ * Sets how the running thread is found
+ * Param "thread": returns the id of the running thread (e.g. G8RTOS_GetThreadId), or NULL
+ */
+void BusStats_SetThreadHook(uint32_t (*thread)(void));
+
+/*
+ * Counts a transfer, called by the drivers once it is done
+ * Param "bus": bus it went over
+ * Param "bytes": bytes it moved
+ * Param "start": BUSSTATS_NOW() taken before it started
+ */
+void BusStats_Count(bus_t bus, uint32_t bytes, uint32_t start);
+
+/*
+ * Starts charging the running thread's traffic to an operation
+ * Param "span": span to start, passed to BusStats_End
+ * Param "name": operation, a string constant
+ */
+void BusStats_Begin(bus_span_t* span, const char* name);
+
+/*
+ * Charges the traffic since BusStats_Begin to the operation
+ * Param "span": span started by the same thread
+ */
+void BusStats_End(bus_span_t* span);
+
+/*
+ * Copies every counter at once
+ * Param "snapshot": receives the counters
+ */
+void BusStats_Snapshot(busstats_snapshot_t* snapshot);
+
+/*
+ * Clears every counter; spans already started are not charged when they end
+ */
+void BusStats_Reset();
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* BUSSTATS_H_ */
@@ -34,6 +34,31 @@
 #define SPI_CS_TP_LOW P10OUT &= ~BIT5
 #define SPI_CS_TP_HIGH P10OUT |= BIT5
 
+/* DMA transfers to the LCD
+ *  - Fills shorter than LCD_DMA_MIN_PIXELS are written by polling
+ *  - A fill repeats a LCD_DMA_FILL_BYTES colour pattern, a pixel buffer is
+ *    sent in chunks of at most LCD_DMA_MAX_BYTES (the uDMA transfer limit)
+ *  - The completion interrupt runs at LCD_DMA_PRIORITY, below the G8RTOS
+ *    kernel ceiling so it may signal a semaphore */
+#define LCD_DMA_MIN_PIXELS  32
+#define LCD_DMA_FILL_BYTES  256
+#define LCD_DMA_MAX_BYTES   1024
+#define LCD_DMA_PRIORITY    3
+
+/* Bitmap flags, see Bitmap */
+#define LCD_BITMAP_INDEXED      0x01    /* one byte per pixel, a palette index */
+#define LCD_BITMAP_RLE          0x02    /* pixels stored as runs */
+#define LCD_BITMAP_TRANSPARENT  0x04    /* pixels equal to transparent are left alone */
+
+/* Scrolling console (LCD_ConsoleInit)
+ *  - The ILI9325 scrolls along its 320 gate lines, which run along x in this
+ *    landscape setup, so console lines are 16 pixel columns of rotated text,
+ *    read with the board turned a quarter turn clockwise (left edge on top)
+ *  - Once all rows are used, each new line overwrites the oldest and the
+ *    scroll register (GATE_SCAN_CONTROL_0X6A) moves it to the bottom */
+#define LCD_CONSOLE_COLUMNS     (MAX_SCREEN_Y / 8)
+#define LCD_CONSOLE_ROWS        (MAX_SCREEN_X / 16)
+
 /* XPT2046 registers definition for X and Y coordinate retrieval */
 #define CHX         0x90
 #define CHY         0xD0
@@ -115,6 +140,24 @@ typedef struct Point {
     uint16_t x;
     uint16_t y;
 }Point;
+
+/* Image for LCD_DrawBitmap, meant to be const so it stays in flash
+ *  - Pixels go left to right, then top to bottom, either as RGB565 colours
+ *    (two bytes, high byte first) or, with LCD_BITMAP_INDEXED, as one byte
+ *    indexing palette
+ *  - With LCD_BITMAP_RLE, data is a list of runs, each a header byte n then:
+ *    if n & 0x80, one pixel repeated (n & 0x7F) + 1 times,
+ *    otherwise n + 1 pixels stored one after another; runs may cross rows
+ *  - With LCD_BITMAP_TRANSPARENT, pixels whose stored value (colour or
+ *    index) equals transparent are not drawn */
+typedef struct Bitmap {
+    uint16_t width;
+    uint16_t height;
+    uint8_t flags;
+    uint16_t transparent;
+    const uint16_t* palette;
+    const uint8_t* data;
+}Bitmap;
 /********************************** Structures ******************************************/
 
 /************************************ Public Functions  *******************************************/
@@ -125,10 +168,123 @@ typedef struct Point {
  * Input          : xStart, xEnd, yStart, yEnd, Color
  * Output         : None
  * Return         : None
- * Attention      : None
+ * Attention      : Large rectangles are filled by DMA, see LCD_SetDMAHooks
  *******************************************************************************/
 void LCD_DrawRectangle(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, uint16_t Color);
 
+/*******************************************************************************
+ * Function Name  : LCD_DrawPixels
+ * Description    : Copy a pixel buffer into a rectangle
+ * Input          : xStart, xEnd, yStart, yEnd
+ *                  - pixels: colours, two bytes each (high byte first),
+ *                    left to right then top to bottom
+ * Output         : None
+ * Return         : None
+ * Attention      : Streamed by DMA, the buffer must stay valid until return
+ *******************************************************************************/
+void LCD_DrawPixels(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, const uint8_t* pixels);
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawBitmap
+ * Description    : Draw a bitmap with its top left corner at a point
+ * Input          : - Xpos, Ypos: top left corner
+ *                  - bitmap: image to draw, see Bitmap
+ * Output         : None
+ * Return         : None
+ * Attention      : Clipped at the screen edge. Decoded straight into one GRAM
+ *                  window; transparent pixels only move the GRAM cursor.
+ *******************************************************************************/
+void LCD_DrawBitmap(uint16_t Xpos, uint16_t Ypos, const Bitmap* bitmap);
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawHLine
+ * Description    : Draw a horizontal line through one GRAM window
+ * Input          : xStart, xEnd, y, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Ends may come in either order; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawHLine(int16_t xStart, int16_t xEnd, int16_t y, uint16_t Color);
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawVLine
+ * Description    : Draw a vertical line through one GRAM window
+ * Input          : x, yStart, yEnd, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Ends may come in either order; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawVLine(int16_t x, int16_t yStart, int16_t yEnd, uint16_t Color);
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawLine
+ * Description    : Draw a line between two points, both included (Bresenham)
+ * Input          : x0, y0, x1, y1, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Each run of pixels along the major axis is one GRAM window,
+ *                  so shallow and steep lines cost far fewer windows than
+ *                  pixels; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t Color);
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawCircle
+ * Description    : Draw a circle outline or disc (midpoint algorithm)
+ * Input          : - xCenter, yCenter: center
+ *                  - radius: radius, 0 draws the center pixel
+ *                  - Color: circle color
+ *                  - filled: fill the disc instead of drawing the outline
+ * Output         : None
+ * Return         : None
+ * Attention      : Drawn as horizontal and vertical spans, one GRAM window each;
+ *                  clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawCircle(int16_t xCenter, int16_t yCenter, uint16_t radius, uint16_t Color, bool filled);
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsoleInit
+ * Description    : Clears the screen and starts the scrolling console
+ * Input          : Color, bkColor: text and background colors
+ * Output         : None
+ * Return         : None
+ * Attention      : Everything else drawn while the console is open is moved
+ *                  by its scrolling, see LCD_ConsoleClose
+ *******************************************************************************/
+void LCD_ConsoleInit(uint16_t Color, uint16_t bkColor);
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsolePrint
+ * Description    : Prints a string on new console lines
+ * Input          : - str: string to print
+ * Output         : None
+ * Return         : None
+ * Attention      : Each '\n' and each LCD_CONSOLE_COLUMNS characters start a
+ *                  new line; only the new lines are written
+ *******************************************************************************/
+void LCD_ConsolePrint(const char* str);
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsoleClose
+ * Description    : Stops the console and puts the screen back in place
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : The console text is left on screen, unscrolled
+ *******************************************************************************/
+void LCD_ConsoleClose();
+
+/*******************************************************************************
+ * Function Name  : LCD_SetDMAHooks
+ * Description    : Sets how callers wait for LCD DMA transfers
+ * Input          : - wait: blocks the calling thread until complete is called
+ *                  - complete: called from the DMA interrupt when a transfer is done
+ * Output         : None
+ * Return         : None
+ * Attention      : With no hooks (NULL) callers spin until the transfer is done
+ *******************************************************************************/
+void LCD_SetDMAHooks(void (*wait)(void), void (*complete)(void));
+
 /******************************************************************************
 * Function Name  : PutChar
 * Description    : Lcd screen displays a character
@@ -136,11 +292,12 @@ void LCD_DrawRectangle(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t
 *                  - Ypos: Vertical coordinate
 *                  - ASCI: Displayed character
 *                  - charColor: Character color
+*                  - bkColor: Background color
 * Output         : None
 * Return         : None
-* Attention      : None
+* Attention      : 256 pixels through one GRAM window
 *******************************************************************************/
-inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charColor);
+inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charColor, uint16_t bkColor);
 
 /******************************************************************************
 * Function Name  : LCD_Text
@@ -148,12 +305,13 @@ inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charCo
 * Input          : - Xpos: Horizontal coordinate
 *                  - Ypos: Vertical coordinate
 *                  - str: Displayed string
-*                  - charColor: Character color
+*                  - Color: Character color
+*                  - bkColor: Background color
 * Output         : None
 * Return         : None
-* Attention      : None
+* Attention      : Each line of the string is drawn through one GRAM window
 *******************************************************************************/
-void LCD_Text(uint16_t Xpos, uint16_t Ypos, uint8_t *str,uint16_t Color);
+void LCD_Text(uint16_t Xpos, uint16_t Ypos, uint8_t *str, uint16_t Color, uint16_t bkColor);
 
 /*******************************************************************************
 * Function Name  : LCD_Write_Data_Only
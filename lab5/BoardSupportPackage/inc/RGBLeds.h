@@ -28,6 +28,7 @@ void LP3943_ColorSet(uint32_t unit, uint32_t PWM_DATA);
  * LP3943_LedModeSet
  * This function will set each of the LEDs to the desired operating
  * mode. The operating modes are on, off, PWM1 and PWM2.
+ * Its bus traffic is charged to the "LP3943_LedModeSet" operation (see BusStats.h).
  */
 void LP3943_LedModeSet(uint32_t unit, uint16_t LED_DATA);
 
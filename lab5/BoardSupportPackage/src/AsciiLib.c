@@ -433,6 +433,20 @@ void GetASCIICode(unsigned char* pBuffer,unsigned char ASCII)
    }
 }
 
+/*******************************************************************************
+* Function Name  : GetASCIIGlyph
+* Description    : get ASCII code data without copying it
+* Input          : - ASCII: Input ASCII code
+* Output         : None
+* Return         : 16 rows of the character, bit 7 is the leftmost pixel
+* Attention		 : Codes without a glyph return the blank (space) glyph
+*******************************************************************************/
+const unsigned char* GetASCIIGlyph(unsigned char ASCII)
+{
+   if (ASCII < 32 || ASCII > 126) ASCII = ' ';
+   return AsciiLib[(ASCII - 32)];
+}
+
 
 /*********************************************************************************************************
       END FILE
@@ -21,6 +21,9 @@ void BSP_InitBoard(bool LCD_usingTP, playerType wifi_hostOrClient)
 	/* Initialize Clock */
 	ClockSys_SetMaxFreq();
 
+	/* Count bus traffic from here on */
+	BusStats_Init(ClockSys_GetSysFreq());
+
 	/* Init i2c */
 	initI2C();
 	DelayMs(50);
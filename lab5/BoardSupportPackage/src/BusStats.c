@@ -0,0 +1,339 @@
+/*
+ * BusStats.c
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "msp.h"
+#include "BusStats.h"
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*
+ * Running count on one bus, in cycles so each transfer costs no division
+ */
+typedef struct
+{
+    uint32_t bytes;
+    uint64_t cycles;
+} bus_counter_t;
+
+/*
+ * Traffic of one thread; only that thread adds to it
+ */
+typedef struct
+{
+    uint32_t thread;
+    bus_counter_t bus[BUS_COUNT];
+} thread_record_t;
+
+/*
+ * Traffic of one (operation, thread) pair; only that thread adds to it
+ */
+typedef struct
+{
+    const char* name;
+    uint32_t thread;
+    uint32_t calls;
+    uint64_t worstCycles;
+    bus_counter_t bus[BUS_COUNT];
+} operation_record_t;
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*
+ * Threads seen so far; slot 0 is BUSSTATS_NO_THREAD and takes the overflow
+ */
+static thread_record_t threads[BUSSTATS_MAX_THREADS];
+static volatile uint8_t ThreadCount;
+
+/*
+ * Operations seen so far, and spans that found no free slot
+ */
+static operation_record_t operations[BUSSTATS_MAX_OPERATIONS];
+static volatile uint8_t OperationCount;
+static uint32_t DroppedSpans;
+
+/* The records have to fit BUSSTATS_RAM_BYTES */
+typedef char busstats_ram_check[(sizeof(threads) + sizeof(operations) <= BUSSTATS_RAM_BYTES) ? 1 : -1];
+
+/*
+ * Record the last count went to, so a thread moving many bytes in a row finds its own at once
+ */
+static thread_record_t* volatile LastThread = &threads[0];
+
+/*
+ * Returns the running thread's id, NULL until the kernel runs
+ */
+static uint32_t (*ThreadHook)(void);
+
+static uint32_t CyclesPerUs = 1;
+
+/*
+ * Bumped by BusStats_Reset, spans started before it are dropped
+ */
+static volatile uint32_t Generation;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Holds off interrupts at or below BUSSTATS_CEILING_PRIORITY (never lowers BASEPRI)
+ * Returns: the previous BASEPRI
+ */
+static uint32_t StartCritical()
+{
+    uint32_t basepri = __get_BASEPRI();
+    if (basepri == 0 || basepri > BUSSTATS_CEILING_BASEPRI) __set_BASEPRI(BUSSTATS_CEILING_BASEPRI);
+    return basepri;
+}
+
+static void EndCritical(uint32_t basepri)
+{
+    __set_BASEPRI(basepri);
+}
+
+/*
+ * Returns the record of a thread among the first "count", or NULL
+ */
+static thread_record_t* FindThread(uint32_t thread, uint8_t count)
+{
+    for (int i = 1; i < count; ++i)
+    {
+        if (threads[i].thread == thread) return &threads[i];
+    }
+    return NULL;
+}
+
+/*
+ * Returns the record of an operation among the first "count", or NULL
+ */
+static operation_record_t* FindOperation(const char* name, uint32_t thread, uint8_t count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (operations[i].name == name && operations[i].thread == thread) return &operations[i];
+    }
+    return NULL;
+}
+
+/*
+ * Returns the running thread's record, adding it if it is new
+ *  - Records are filled in before the count takes them in, so the lookup needs no lock;
+ *    only adding one does, so two threads never take the same slot
+ */
+static thread_record_t* ThreadRecord()
+{
+    uint32_t thread = (ThreadHook != NULL) ? ThreadHook() : BUSSTATS_NO_THREAD;
+
+    thread_record_t* record = LastThread;
+    if (record->thread == thread) return record;
+
+    uint8_t count = ThreadCount;
+    record = FindThread(thread, count);
+    if (record == NULL && thread != BUSSTATS_NO_THREAD && count < BUSSTATS_MAX_THREADS)
+    {
+        uint32_t basepri = StartCritical();
+
+        // another thread may have added records since the lookup
+        record = FindThread(thread, ThreadCount);
+        if (record == NULL && ThreadCount < BUSSTATS_MAX_THREADS)
+        {
+            record = &threads[ThreadCount];
+            record->thread = thread;
+            __DMB();  // the record is complete before the count takes it in
+            ++ThreadCount;
+        }
+
+        EndCritical(basepri);
+    }
+    if (record == NULL) record = &threads[0];
+
+    LastThread = record;
+    return record;
+}
+
+/*
+ * Returns the record of an operation in a thread, adding it if it is new, or NULL if there is no room
+ */
+static operation_record_t* OperationRecord(const char* name, uint32_t thread)
+{
+    uint8_t count = OperationCount;
+    operation_record_t* record = FindOperation(name, thread, count);
+    if (record != NULL || count == BUSSTATS_MAX_OPERATIONS) return record;
+
+    uint32_t basepri = StartCritical();
+
+    record = FindOperation(name, thread, OperationCount);
+    if (record == NULL && OperationCount < BUSSTATS_MAX_OPERATIONS)
+    {
+        record = &operations[OperationCount];
+        record->name = name;
+        record->thread = thread;
+        __DMB();  // the record is complete before the count takes it in
+        ++OperationCount;
+    }
+
+    EndCritical(basepri);
+    return record;
+}
+
+static void ToTraffic(bus_traffic_t* traffic, const bus_counter_t* counter)
+{
+    traffic->bytes = counter->bytes;
+    traffic->us = counter->cycles / CyclesPerUs;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Starts the cycle counter, clears every counter and sets the cycle counter frequency
+ */
+void BusStats_Init(uint32_t cpuHz)
+{
+    // Start the cycle counter here, so board bring-up is timed too (G8RTOS_Init only zeroes it)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    CyclesPerUs = (cpuHz >= 1000000) ? cpuHz / 1000000 : 1;
+    BusStats_Reset();
+}
+
+/*
+ * Sets how the running thread is found
+ */
+void BusStats_SetThreadHook(uint32_t (*thread)(void))
+{
+    ThreadHook = thread;
+}
+
+/*
+ * Counts a transfer on a bus, charged to the running thread
+ */
+void BusStats_Count(bus_t bus, uint32_t bytes, uint32_t start)
+{
+    uint32_t cycles = BUSSTATS_NOW() - start;
+    thread_record_t* record = ThreadRecord();
+
+    record->bus[bus].bytes += bytes;
+    record->bus[bus].cycles += cycles;
+}
+
+/*
+ * Marks where the running thread's counters stand
+ */
+void BusStats_Begin(bus_span_t* span, const char* name)
+{
+    thread_record_t* record = ThreadRecord();
+
+    span->name = name;
+    span->generation = Generation;
+    for (int i = 0; i < BUS_COUNT; ++i)
+    {
+        span->bytes[i] = record->bus[i].bytes;
+        span->cycles[i] = record->bus[i].cycles;
+    }
+}
+
+/*
+ * Charges what the running thread moved since BusStats_Begin to the span's operation
+ */
+void BusStats_End(bus_span_t* span)
+{
+    if (span->generation != Generation) return;
+
+    thread_record_t* record = ThreadRecord();
+    operation_record_t* operation = OperationRecord(span->name, record->thread);
+    if (operation == NULL)
+    {
+        ++DroppedSpans;
+        return;
+    }
+
+    uint64_t cycles = 0;
+    for (int i = 0; i < BUS_COUNT; ++i)
+    {
+        uint64_t spanCycles = record->bus[i].cycles - span->cycles[i];
+        operation->bus[i].bytes += record->bus[i].bytes - span->bytes[i];
+        operation->bus[i].cycles += spanCycles;
+        cycles += spanCycles;
+    }
+
+    ++operation->calls;
+    if (cycles > operation->worstCycles) operation->worstCycles = cycles;
+}
+
+/*
+ * Copies every counter
+ *  - Each record is copied whole with interrupts held off, and turned into us after
+ */
+void BusStats_Snapshot(busstats_snapshot_t* snapshot)
+{
+    bus_counter_t total[BUS_COUNT];
+    memset(total, 0, sizeof(total));
+
+    uint8_t count = ThreadCount;
+    snapshot->threadCount = count;
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t basepri = StartCritical();
+        thread_record_t record = threads[i];
+        EndCritical(basepri);
+
+        snapshot->threads[i].thread = record.thread;
+        for (int bus = 0; bus < BUS_COUNT; ++bus)
+        {
+            ToTraffic(&snapshot->threads[i].bus[bus], &record.bus[bus]);
+            total[bus].bytes += record.bus[bus].bytes;
+            total[bus].cycles += record.bus[bus].cycles;
+        }
+    }
+    for (int bus = 0; bus < BUS_COUNT; ++bus) ToTraffic(&snapshot->total[bus], &total[bus]);
+
+    count = OperationCount;
+    snapshot->operationCount = count;
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t basepri = StartCritical();
+        operation_record_t record = operations[i];
+        EndCritical(basepri);
+
+        snapshot->operations[i].name = record.name;
+        snapshot->operations[i].thread = record.thread;
+        snapshot->operations[i].calls = record.calls;
+        snapshot->operations[i].worstUs = record.worstCycles / CyclesPerUs;
+        for (int bus = 0; bus < BUS_COUNT; ++bus) ToTraffic(&snapshot->operations[i].bus[bus], &record.bus[bus]);
+    }
+
+    snapshot->droppedSpans = DroppedSpans;
+}
+
+/*
+ * Forgets every thread and operation
+ */
+void BusStats_Reset()
+{
+    uint32_t basepri = StartCritical();
+
+    memset(threads, 0, sizeof(threads));
+    memset(operations, 0, sizeof(operations));
+    threads[0].thread = BUSSTATS_NO_THREAD;
+    ThreadCount = 1;
+    OperationCount = 0;
+    DroppedSpans = 0;
+    LastThread = &threads[0];
+    ++Generation;
+
+    EndCritical(basepri);
+}
+
+/*********************************************** Public Functions *********************************************************************/
@@ -5,10 +5,47 @@
  *      Author: Danny
  */
 
+#include <stdlib.h>
 #include "LCDLib.h"
 #include "msp.h"
 #include "driverlib.h"
 #include "AsciiLib.h"
+#include "BusStats.h"
+
+/************************************  Private Variables  *******************************************/
+
+/* uDMA channel control table, the controller needs it aligned to its size */
+#pragma DATA_ALIGN(dmaControlTable, 256)
+static uint8_t dmaControlTable[256];
+
+/* Colour bytes of a fill, repeated (high byte first, the order the LCD takes them);
+ * also holds decoded bitmap pixels until they are sent */
+static uint8_t dmaFillPattern[LCD_DMA_FILL_BYTES];
+
+/* Decoded bitmap pixels waiting in dmaFillPattern */
+static uint16_t bitmapPending;
+
+/* Console colours, rows written since it was opened, and the scroll offset in gate lines */
+static uint16_t consoleColor;
+static uint16_t consoleBkColor;
+static uint16_t consoleRows;
+static uint16_t consoleScroll;
+
+/* Transfer in progress: next source byte, bytes not yet handed to the channel,
+ * and whether the source is the fill pattern (restarted for every chunk) */
+static const uint8_t* volatile dmaSource;
+static volatile uint32_t dmaRemaining;
+static volatile bool dmaFilling;
+
+/* Cleared by the DMA interrupt when the last chunk has been written to TXBUF */
+static volatile bool dmaBusy;
+
+/* Blocks the caller until a transfer completes, and is signalled by the DMA interrupt on completion */
+static void (*dmaWait)(void);
+static void (*dmaComplete)(void);
+
+/************************************  Private Variables  *******************************************/
+
 
 /************************************  Private Functions  *******************************************/
 
@@ -67,6 +104,154 @@ static void LCD_initSPI()
     EUSCI_B3->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;
 }
 
+/*******************************************************************************
+ * Function Name  : LCD_initDMA
+ * Description    : Configures uDMA channel 6 to feed the EUSCI_B3 TX buffer
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : Channel 6 completion interrupts on DMA_INT1
+ *******************************************************************************/
+static void LCD_initDMA()
+{
+    DMA_enableModule();
+    DMA_setControlBase(dmaControlTable);
+
+    // Channel 6 is triggered by the EUSCI_B3 TX flag, one byte per request
+    DMA_assignChannel(DMA_CH6_EUSCIB3TX0);
+    DMA_disableChannelAttribute(DMA_CHANNEL_6,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH6_EUSCIB3TX0,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_1);
+
+    DMA_assignInterrupt(DMA_INT1, DMA_CHANNEL_6);
+    DMA_clearInterruptFlag(DMA_CHANNEL_6);
+    NVIC_SetPriority(DMA_INT1_IRQn, LCD_DMA_PRIORITY);
+    DMA_enableInterrupt(DMA_INT1);
+
+    dmaBusy = false;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_DMAStartChunk
+ * Description    : Hands the next chunk of the transfer to the DMA channel
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : TXBUF must be empty
+ *******************************************************************************/
+static void LCD_DMAStartChunk()
+{
+    uint32_t limit = dmaFilling ? LCD_DMA_FILL_BYTES : LCD_DMA_MAX_BYTES;
+    uint32_t bytes = (dmaRemaining > limit) ? limit : dmaRemaining;
+
+    DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH6_EUSCIB3TX0, UDMA_MODE_BASIC,
+                           (void*)dmaSource,
+                           (void*)SPI_getTransmitBufferAddressForDMA(EUSCI_B3_BASE),
+                           bytes);
+    dmaRemaining -= bytes;
+    if (!dmaFilling) dmaSource += bytes;
+
+    /* The channel is requested by the TX flag. Clearing it before enabling the
+     * channel and setting it after gives exactly one fresh request */
+    EUSCI_B3->IFG &= ~EUSCI_B_IFG_TXIFG0;
+    DMA_enableChannel(DMA_CHANNEL_6);
+    EUSCI_B3->IFG |= EUSCI_B_IFG_TXIFG0;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_WriteDMA
+ * Description    : Streams bytes to the LCD through the DMA channel
+ * Input          : - source: bytes to send, or the fill pattern
+ *                  - bytes: number of bytes to send
+ *                  - filling: whether source is the fill pattern
+ * Output         : None
+ * Return         : None
+ * Attention      : Blocks until the last byte has left the shift register.
+ *                  RX is not read, so the receive overrun flag is left set.
+ *                  Counted as one transfer, timed until the last byte is out.
+ *******************************************************************************/
+static void LCD_WriteDMA(const uint8_t* source, uint32_t bytes, bool filling)
+{
+    uint32_t start = BUSSTATS_NOW();
+
+    dmaSource = source;
+    dmaRemaining = bytes;
+    dmaFilling = filling;
+    dmaBusy = true;
+
+    while(SPI_isBusy(EUSCI_B3_BASE));
+    LCD_DMAStartChunk();
+
+    if (dmaWait != NULL)
+    {
+        dmaWait();
+    }
+    else
+    {
+        while (dmaBusy);
+    }
+
+    /* The interrupt fires once the last byte is in TXBUF, wait for it to go out */
+    while(SPI_isBusy(EUSCI_B3_BASE));
+
+    BusStats_Count(BUS_LCD_SPI, bytes, start);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_FillPixels
+ * Description    : Writes the same colour to a number of GRAM pixels
+ * Input          : - Color: pixel colour
+ *                  - pixels: number of pixels
+ * Output         : None
+ * Return         : None
+ * Attention      : GRAM write must already be started with CS low
+ *******************************************************************************/
+static void LCD_FillPixels(uint16_t Color, uint32_t pixels)
+{
+    /* Setting up the channel costs more than a few polled pixels */
+    if (pixels < LCD_DMA_MIN_PIXELS)
+    {
+        for (uint32_t i = 0; i < pixels; ++i)
+        {
+            LCD_Write_Data_Only(Color);
+        }
+        return;
+    }
+
+    for (int i = 0; i < LCD_DMA_FILL_BYTES; i += 2)
+    {
+        dmaFillPattern[i] = Color >> 8;
+        dmaFillPattern[i + 1] = Color & 0xFF;
+    }
+
+    LCD_WriteDMA(dmaFillPattern, pixels * 2, true);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_SetWindow
+ * Description    : Sets the GRAM window and starts a GRAM write at its top left
+ * Input          : xStart, xEnd, yStart, yEnd
+ * Output         : None
+ * Return         : None
+ * Attention      : Window must be on screen
+ *******************************************************************************/
+static void LCD_SetWindow(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd)
+{
+    /* Set window area for high-speed RAM write */
+    LCD_WriteReg(HOR_ADDR_START_POS, yStart);     /* Horizontal GRAM Start Address */
+    LCD_WriteReg(HOR_ADDR_END_POS, yEnd); /* Horizontal GRAM End Address */
+    LCD_WriteReg(VERT_ADDR_START_POS, xStart);    /* Vertical GRAM Start Address */
+    LCD_WriteReg(VERT_ADDR_END_POS, xEnd); /* Vertical GRAM Start Address */
+
+    /* Set cursor */
+    LCD_SetCursor(xStart, yStart);
+
+    /* Set index to GRAM */
+    LCD_WriteIndex(DATA_IN_GRAM);
+}
+
 /*******************************************************************************
  * Function Name  : LCD_reset
  * Description    : Resets LCD
@@ -85,6 +270,272 @@ static void LCD_reset()
     P10OUT |= BIT0;  // high
 }
 
+/*******************************************************************************
+ * Function Name  : LCD_DrawGlyphs
+ * Description    : Draws a run of characters on one line through one GRAM window
+ * Input          : - Xpos, Ypos: top left of the first character
+ *                  - str: characters to draw
+ *                  - count: number of characters
+ *                  - Color, bkColor: character and background colors
+ * Output         : None
+ * Return         : None
+ * Attention      : Reads the font table in place; clipped at the screen edge
+ *******************************************************************************/
+static void LCD_DrawGlyphs(uint16_t Xpos, uint16_t Ypos, const uint8_t* str, uint16_t count, uint16_t Color, uint16_t bkColor)
+{
+    const unsigned char* glyphs[MAX_SCREEN_X / 8 + 1];
+
+    if (count == 0 || Xpos >= MAX_SCREEN_X || Ypos >= MAX_SCREEN_Y) return;
+
+    uint32_t columns = (uint32_t)count * 8;
+    if (columns > MAX_SCREEN_X - Xpos) columns = MAX_SCREEN_X - Xpos;
+    uint16_t rows = (Ypos > MAX_SCREEN_Y - 16) ? MAX_SCREEN_Y - Ypos : 16;
+
+    for (uint16_t i = 0; i < (columns + 7) / 8; ++i)
+    {
+        glyphs[i] = GetASCIIGlyph(str[i]);
+    }
+
+    LCD_SetWindow(Xpos, Xpos + columns - 1, Ypos, Ypos + rows - 1);
+
+    /* GRAM fills left to right, then top to bottom, so each pixel row
+     * crosses every glyph of the run */
+    SPI_CS_LCD_LOW;
+    LCD_Write_Data_Start();
+    for (uint16_t row = 0; row < rows; ++row)
+    {
+        for (uint32_t column = 0; column < columns; ++column)
+        {
+            uint8_t bits = glyphs[column >> 3][row];
+            LCD_Write_Data_Only(((bits << (column & 7)) & 0x80) ? Color : bkColor);
+        }
+    }
+    SPI_CS_LCD_HIGH;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_BitmapFlush
+ * Description    : Sends the decoded bitmap pixels waiting in dmaFillPattern
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : GRAM write must already be started with CS low
+ *******************************************************************************/
+static void LCD_BitmapFlush()
+{
+    if (bitmapPending < LCD_DMA_MIN_PIXELS)
+    {
+        for (uint16_t i = 0; i < bitmapPending * 2; i += 2)
+        {
+            LCD_Write_Data_Only((dmaFillPattern[i] << 8) | dmaFillPattern[i + 1]);
+        }
+    }
+    else
+    {
+        LCD_WriteDMA(dmaFillPattern, bitmapPending * 2, false);
+    }
+
+    bitmapPending = 0;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_BitmapRead
+ * Description    : Reads the next stored pixel value of a bitmap
+ * Input          : - bitmap: bitmap being drawn
+ *                  - data: next byte of the bitmap's data
+ *                  - run: pixels left in the current RLE run
+ *                  - repeat: whether the current RLE run repeats value
+ *                  - value: pixel value of a repeating run
+ * Output         : data, run, repeat and value are advanced
+ * Return         : Colour, or palette index with LCD_BITMAP_INDEXED
+ * Attention      : None
+ *******************************************************************************/
+static uint16_t LCD_BitmapRead(const Bitmap* bitmap, const uint8_t** data, uint16_t* run, bool* repeat, uint16_t* value)
+{
+    const uint8_t* next = *data;
+
+    if (bitmap->flags & LCD_BITMAP_RLE)
+    {
+        if (*run == 0)
+        {
+            uint8_t header = *next++;
+            *repeat = (header & 0x80) != 0;
+            *run = (header & 0x7F) + 1;
+            if (*repeat)
+            {
+                if (bitmap->flags & LCD_BITMAP_INDEXED) *value = *next++;
+                else
+                {
+                    *value = (next[0] << 8) | next[1];
+                    next += 2;
+                }
+            }
+        }
+
+        --*run;
+        if (*repeat)
+        {
+            *data = next;
+            return *value;
+        }
+    }
+
+    uint16_t pixel;
+    if (bitmap->flags & LCD_BITMAP_INDEXED) pixel = *next++;
+    else
+    {
+        pixel = (next[0] << 8) | next[1];
+        next += 2;
+    }
+
+    *data = next;
+    return pixel;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_FillSpan
+ * Description    : Fills a rectangle that may reach off screen
+ * Input          : xStart, xEnd, yStart, yEnd (inclusive, xStart <= xEnd and
+ *                  yStart <= yEnd), Color
+ * Output         : None
+ * Return         : None
+ * Attention      : None
+ *******************************************************************************/
+static void LCD_FillSpan(int16_t xStart, int16_t xEnd, int16_t yStart, int16_t yEnd, uint16_t Color)
+{
+    if (xStart < MIN_SCREEN_X) xStart = MIN_SCREEN_X;
+    if (yStart < MIN_SCREEN_Y) yStart = MIN_SCREEN_Y;
+    if (xEnd >= MAX_SCREEN_X) xEnd = MAX_SCREEN_X - 1;
+    if (yEnd >= MAX_SCREEN_Y) yEnd = MAX_SCREEN_Y - 1;
+
+    if (xStart > xEnd || yStart > yEnd) return;
+
+    LCD_DrawRectangle(xStart, xEnd, yStart, yEnd, Color);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_CircleRun
+ * Description    : Draws the pixels of a circle for one run of the first octant
+ * Input          : - xCenter, yCenter, Color: the circle
+ *                  - xStart, xEnd: offsets along x of the run (0 <= xStart <= xEnd)
+ *                  - y: offset along y of the run (y >= xEnd)
+ *                  - filled: whether the circle is filled
+ * Output         : None
+ * Return         : None
+ * Attention      : Mirrors the run into all eight octants
+ *******************************************************************************/
+static void LCD_CircleRun(int16_t xCenter, int16_t yCenter, int16_t xStart, int16_t xEnd, int16_t y, uint16_t Color, bool filled)
+{
+    if (filled)
+    {
+        /* The rows at +-y only widen at the end of a run... */
+        LCD_FillSpan(xCenter - xEnd, xCenter + xEnd, yCenter - y, yCenter - y, Color);
+        if (y != 0) LCD_FillSpan(xCenter - xEnd, xCenter + xEnd, yCenter + y, yCenter + y, Color);
+
+        /* ...while every x of the run has its own rows at +-x, all y wide */
+        for (int16_t x = xStart; x <= xEnd && x < y; ++x)
+        {
+            LCD_FillSpan(xCenter - y, xCenter + y, yCenter - x, yCenter - x, Color);
+            if (x != 0) LCD_FillSpan(xCenter - y, xCenter + y, yCenter + x, yCenter + x, Color);
+        }
+        return;
+    }
+
+    /* Top and bottom octants: the run is horizontal */
+    if (xStart == 0)
+    {
+        LCD_FillSpan(xCenter - xEnd, xCenter + xEnd, yCenter - y, yCenter - y, Color);
+        LCD_FillSpan(xCenter - xEnd, xCenter + xEnd, yCenter + y, yCenter + y, Color);
+    }
+    else
+    {
+        LCD_FillSpan(xCenter - xEnd, xCenter - xStart, yCenter - y, yCenter - y, Color);
+        LCD_FillSpan(xCenter + xStart, xCenter + xEnd, yCenter - y, yCenter - y, Color);
+        LCD_FillSpan(xCenter - xEnd, xCenter - xStart, yCenter + y, yCenter + y, Color);
+        LCD_FillSpan(xCenter + xStart, xCenter + xEnd, yCenter + y, yCenter + y, Color);
+    }
+
+    /* Left and right octants: the same run turned vertical */
+    if (xStart == 0)
+    {
+        LCD_FillSpan(xCenter - y, xCenter - y, yCenter - xEnd, yCenter + xEnd, Color);
+        LCD_FillSpan(xCenter + y, xCenter + y, yCenter - xEnd, yCenter + xEnd, Color);
+    }
+    else
+    {
+        LCD_FillSpan(xCenter - y, xCenter - y, yCenter - xEnd, yCenter - xStart, Color);
+        LCD_FillSpan(xCenter - y, xCenter - y, yCenter + xStart, yCenter + xEnd, Color);
+        LCD_FillSpan(xCenter + y, xCenter + y, yCenter - xEnd, yCenter - xStart, Color);
+        LCD_FillSpan(xCenter + y, xCenter + y, yCenter + xStart, yCenter + xEnd, Color);
+    }
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsoleLine
+ * Description    : Writes a console line into the next row, scrolling if all are used
+ * Input          : - str: characters of the line
+ *                  - count: number of characters, at most LCD_CONSOLE_COLUMNS
+ * Output         : None
+ * Return         : None
+ * Attention      : The text is written through one GRAM window, the rest of the
+ *                  row is filled with the background
+ *******************************************************************************/
+static void LCD_ConsoleLine(const char* str, uint16_t count)
+{
+    const unsigned char* glyphs[LCD_CONSOLE_COLUMNS];
+
+    /* Until every row is used, rows fill from the top; after that the oldest
+     * row, shown at the top, is rewritten and then scrolled to the bottom */
+    uint16_t xStart;
+    bool scroll = consoleRows == LCD_CONSOLE_ROWS;
+    if (scroll)
+    {
+        xStart = consoleScroll;
+    }
+    else
+    {
+        xStart = consoleRows * 16;
+        ++consoleRows;
+    }
+
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        glyphs[i] = GetASCIIGlyph(str[i]);
+    }
+
+    /* Text reads from the bottom of the screen up, so the part past it is at the top */
+    uint16_t yText = MAX_SCREEN_Y - count * 8;
+    if (yText > 0)
+    {
+        LCD_DrawRectangle(xStart, xStart + 15, 0, yText - 1, consoleBkColor);
+    }
+
+    if (count > 0)
+    {
+        LCD_SetWindow(xStart, xStart + 15, yText, MAX_SCREEN_Y - 1);
+
+        /* GRAM fills along x (a glyph row) first, then along y (back along the line) */
+        SPI_CS_LCD_LOW;
+        LCD_Write_Data_Start();
+        for (uint16_t y = yText; y < MAX_SCREEN_Y; ++y)
+        {
+            uint16_t column = MAX_SCREEN_Y - 1 - y;
+            const unsigned char* glyph = glyphs[column >> 3];
+            for (uint16_t row = 0; row < 16; ++row)
+            {
+                LCD_Write_Data_Only(((glyph[row] << (column & 7)) & 0x80) ? consoleColor : consoleBkColor);
+            }
+        }
+        SPI_CS_LCD_HIGH;
+    }
+
+    if (scroll)
+    {
+        consoleScroll = (consoleScroll + 16) % MAX_SCREEN_X;
+        LCD_WriteReg(GATE_SCAN_CONTROL_0X6A, consoleScroll);
+    }
+}
+
 /************************************  Private Functions  *******************************************/
 
 
@@ -111,29 +562,331 @@ void LCD_DrawRectangle(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t
     if (xStart > xEnd || yStart > yEnd ||
         yEnd >= MAX_SCREEN_Y || xEnd >= MAX_SCREEN_X) return;
 
-    /* Set window area for high-speed RAM write */
-    LCD_WriteReg(HOR_ADDR_START_POS, yStart);     /* Horizontal GRAM Start Address */
-    LCD_WriteReg(HOR_ADDR_END_POS, yEnd); /* Horizontal GRAM End Address */
-    LCD_WriteReg(VERT_ADDR_START_POS, xStart);    /* Vertical GRAM Start Address */
-    LCD_WriteReg(VERT_ADDR_END_POS, xEnd); /* Vertical GRAM Start Address */
+    LCD_SetWindow(xStart, xEnd, yStart, yEnd);
 
-    /* Set cursor */
-    LCD_SetCursor(xStart, yStart);
+    /* Send out data only to the entire area */
+    SPI_CS_LCD_LOW;
+    LCD_Write_Data_Start();
+    LCD_FillPixels(Color, (xEnd-xStart+1) * (yEnd-yStart+1));
+    SPI_CS_LCD_HIGH;
+}
 
-    /* Set index to GRAM */
-    LCD_WriteIndex(DATA_IN_GRAM);
+/*******************************************************************************
+ * Function Name  : LCD_DrawPixels
+ * Description    : Copy a pixel buffer into a rectangle
+ * Input          : xStart, xEnd, yStart, yEnd
+ *                  - pixels: colours, two bytes each (high byte first),
+ *                    left to right then top to bottom
+ * Output         : None
+ * Return         : None
+ * Attention      : Streamed by DMA, the buffer must stay valid until return
+ *******************************************************************************/
+void LCD_DrawPixels(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, const uint8_t* pixels)
+{
+    if (xStart > xEnd || yStart > yEnd ||
+        yEnd >= MAX_SCREEN_Y || xEnd >= MAX_SCREEN_X) return;
+
+    LCD_SetWindow(xStart, xEnd, yStart, yEnd);
 
-    /* Send out data only to the entire area */
     SPI_CS_LCD_LOW;
     LCD_Write_Data_Start();
-    int pixels = (xEnd-xStart+1) * (yEnd-yStart+1);
-    for (int i = 0; i < pixels; ++i)
+    LCD_WriteDMA(pixels, (uint32_t)(xEnd-xStart+1) * (yEnd-yStart+1) * 2, false);
+    SPI_CS_LCD_HIGH;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawBitmap
+ * Description    : Draw a bitmap with its top left corner at a point
+ * Input          : - Xpos, Ypos: top left corner
+ *                  - bitmap: image to draw, see Bitmap
+ * Output         : None
+ * Return         : None
+ * Attention      : Clipped at the screen edge. Decoded straight into one GRAM
+ *                  window; transparent pixels only move the GRAM cursor.
+ *******************************************************************************/
+void LCD_DrawBitmap(uint16_t Xpos, uint16_t Ypos, const Bitmap* bitmap)
+{
+    if (Xpos >= MAX_SCREEN_X || Ypos >= MAX_SCREEN_Y ||
+        bitmap->width == 0 || bitmap->height == 0) return;
+
+    uint16_t xEnd = (bitmap->width > MAX_SCREEN_X - Xpos) ? MAX_SCREEN_X - 1 : Xpos + bitmap->width - 1;
+    uint16_t yEnd = (bitmap->height > MAX_SCREEN_Y - Ypos) ? MAX_SCREEN_Y - 1 : Ypos + bitmap->height - 1;
+
+    /* Plain colours that fit already are a pixel buffer */
+    if (bitmap->flags == 0 && xEnd - Xpos + 1 == bitmap->width)
     {
-        LCD_Write_Data_Only(Color);
+        LCD_DrawPixels(Xpos, xEnd, Ypos, yEnd, bitmap->data);
+        return;
     }
+
+    const uint8_t* data = bitmap->data;
+    uint16_t run = 0;
+    bool repeat = false;
+    uint16_t value = 0;
+    bool skipped = false;
+
+    LCD_SetWindow(Xpos, xEnd, Ypos, yEnd);
+
+    SPI_CS_LCD_LOW;
+    LCD_Write_Data_Start();
+    for (uint16_t y = Ypos; y <= yEnd; ++y)
+    {
+        for (uint16_t column = 0; column < bitmap->width; ++column)
+        {
+            uint16_t pixel = LCD_BitmapRead(bitmap, &data, &run, &repeat, &value);
+
+            /* Off screen pixels are not sent, the window wraps to the next row by itself */
+            uint16_t x = Xpos + column;
+            if (x > xEnd) continue;
+
+            if ((bitmap->flags & LCD_BITMAP_TRANSPARENT) && pixel == bitmap->transparent)
+            {
+                skipped = true;
+                continue;
+            }
+
+            /* Leave the skipped pixels as they are by moving the cursor past them */
+            if (skipped)
+            {
+                LCD_BitmapFlush();
+                SPI_CS_LCD_HIGH;
+                LCD_SetCursor(x, y);
+                LCD_WriteIndex(DATA_IN_GRAM);
+                SPI_CS_LCD_LOW;
+                LCD_Write_Data_Start();
+                skipped = false;
+            }
+
+            if (bitmap->flags & LCD_BITMAP_INDEXED) pixel = bitmap->palette[pixel];
+            dmaFillPattern[bitmapPending * 2] = pixel >> 8;
+            dmaFillPattern[bitmapPending * 2 + 1] = pixel & 0xFF;
+            if (++bitmapPending == LCD_DMA_FILL_BYTES / 2) LCD_BitmapFlush();
+        }
+    }
+    LCD_BitmapFlush();
     SPI_CS_LCD_HIGH;
 }
 
+/*******************************************************************************
+ * Function Name  : LCD_DrawHLine
+ * Description    : Draw a horizontal line through one GRAM window
+ * Input          : xStart, xEnd, y, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Ends may come in either order; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawHLine(int16_t xStart, int16_t xEnd, int16_t y, uint16_t Color)
+{
+    if (xStart > xEnd) LCD_FillSpan(xEnd, xStart, y, y, Color);
+    else LCD_FillSpan(xStart, xEnd, y, y, Color);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawVLine
+ * Description    : Draw a vertical line through one GRAM window
+ * Input          : x, yStart, yEnd, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Ends may come in either order; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawVLine(int16_t x, int16_t yStart, int16_t yEnd, uint16_t Color)
+{
+    if (yStart > yEnd) LCD_FillSpan(x, x, yEnd, yStart, Color);
+    else LCD_FillSpan(x, x, yStart, yEnd, Color);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawLine
+ * Description    : Draw a line between two points, both included (Bresenham)
+ * Input          : x0, y0, x1, y1, Color
+ * Output         : None
+ * Return         : None
+ * Attention      : Each run of pixels along the major axis is one GRAM window,
+ *                  so shallow and steep lines cost far fewer windows than
+ *                  pixels; clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t Color)
+{
+    /* Walk along the major axis; a run ends whenever the minor axis steps */
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    int16_t major0 = steep ? y0 : x0, minor0 = steep ? x0 : y0;
+    int16_t major1 = steep ? y1 : x1, minor1 = steep ? x1 : y1;
+
+    if (major0 > major1)
+    {
+        int16_t swap = major0; major0 = major1; major1 = swap;
+        swap = minor0; minor0 = minor1; minor1 = swap;
+    }
+
+    int32_t dMajor = major1 - major0;
+    int32_t dMinor = abs(minor1 - minor0);
+    int16_t minorStep = (minor1 > minor0) ? 1 : -1;
+    int32_t error = dMajor / 2;
+
+    int16_t minor = minor0;
+    int16_t runStart = major0;
+    for (int16_t major = major0; major <= major1; ++major)
+    {
+        error -= dMinor;
+        if (error < 0 || major == major1)
+        {
+            if (steep) LCD_FillSpan(minor, minor, runStart, major, Color);
+            else LCD_FillSpan(runStart, major, minor, minor, Color);
+
+            runStart = major + 1;
+        }
+        if (error < 0)
+        {
+            minor += minorStep;
+            error += dMajor;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_DrawCircle
+ * Description    : Draw a circle outline or disc (midpoint algorithm)
+ * Input          : - xCenter, yCenter: center
+ *                  - radius: radius, 0 draws the center pixel
+ *                  - Color: circle color
+ *                  - filled: fill the disc instead of drawing the outline
+ * Output         : None
+ * Return         : None
+ * Attention      : Drawn as horizontal and vertical spans, one GRAM window each;
+ *                  clipped at the screen edge
+ *******************************************************************************/
+void LCD_DrawCircle(int16_t xCenter, int16_t yCenter, uint16_t radius, uint16_t Color, bool filled)
+{
+    /* Walk the first octant (x from 0 while x <= y), where y only ever
+     * steps down, and draw each run of equal y once it ends */
+    int16_t x = 0;
+    int16_t y = radius;
+    int32_t decision = 1 - (int32_t)radius;
+    int16_t runStart = 0;
+
+    while (x <= y)
+    {
+        int16_t nextY = y;
+        if (decision < 0)
+        {
+            decision += 2 * x + 3;
+        }
+        else
+        {
+            decision += 2 * (x - y) + 5;
+            --nextY;
+        }
+
+        if (nextY != y || x + 1 > nextY)
+        {
+            LCD_CircleRun(xCenter, yCenter, runStart, x, y, Color, filled);
+            runStart = x + 1;
+        }
+
+        ++x;
+        y = nextY;
+    }
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsoleInit
+ * Description    : Clears the screen and starts the scrolling console
+ * Input          : Color, bkColor: text and background colors
+ * Output         : None
+ * Return         : None
+ * Attention      : Everything else drawn while the console is open is moved
+ *                  by its scrolling, see LCD_ConsoleClose
+ *******************************************************************************/
+void LCD_ConsoleInit(uint16_t Color, uint16_t bkColor)
+{
+    consoleColor = Color;
+    consoleBkColor = bkColor;
+    consoleRows = 0;
+    consoleScroll = 0;
+
+    LCD_WriteReg(GATE_SCAN_CONTROL_0X6A, 0);
+    LCD_WriteReg(GATE_SCAN_CONTROL_0X61, 0x0003); /* VLE: scrolling on, REV kept */
+    LCD_Clear(bkColor);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsolePrint
+ * Description    : Prints a string on new console lines
+ * Input          : - str: string to print
+ * Output         : None
+ * Return         : None
+ * Attention      : Each '\n' and each LCD_CONSOLE_COLUMNS characters start a
+ *                  new line; only the new lines are written
+ *******************************************************************************/
+void LCD_ConsolePrint(const char* str)
+{
+    do
+    {
+        uint16_t count = 0;
+        while (count < LCD_CONSOLE_COLUMNS && str[count] != 0 && str[count] != '\n') ++count;
+
+        LCD_ConsoleLine(str, count);
+        str += count;
+
+        /* A newline ends this line; a line cut at the width just continues */
+        if (*str == '\n') ++str;
+    } while (*str != 0);
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_ConsoleClose
+ * Description    : Stops the console and puts the screen back in place
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : The console text is left on screen, unscrolled
+ *******************************************************************************/
+void LCD_ConsoleClose()
+{
+    LCD_WriteReg(GATE_SCAN_CONTROL_0X6A, 0);
+    LCD_WriteReg(GATE_SCAN_CONTROL_0X61, 0x0001); /* NDL,VLE, REV */
+    consoleScroll = 0;
+}
+
+/*******************************************************************************
+ * Function Name  : LCD_SetDMAHooks
+ * Description    : Sets how callers wait for LCD DMA transfers
+ * Input          : - wait: blocks the calling thread until complete is called
+ *                  - complete: called from the DMA interrupt when a transfer is done
+ * Output         : None
+ * Return         : None
+ * Attention      : With no hooks (NULL) callers spin until the transfer is done
+ *******************************************************************************/
+void LCD_SetDMAHooks(void (*wait)(void), void (*complete)(void))
+{
+    dmaWait = wait;
+    dmaComplete = complete;
+}
+
+/*******************************************************************************
+ * Function Name  : DMA_INT1_IRQHandler
+ * Description    : Completion of a DMA chunk, starts the next or ends the transfer
+ * Input          : None
+ * Output         : None
+ * Return         : None
+ * Attention      : None
+ *******************************************************************************/
+void DMA_INT1_IRQHandler(void)
+{
+    DMA_clearInterruptFlag(DMA_CHANNEL_6);
+
+    if (dmaRemaining > 0)
+    {
+        /* The last byte of the chunk may still be waiting in TXBUF */
+        while (!(EUSCI_B3->IFG & EUSCI_B_IFG_TXIFG0));
+        LCD_DMAStartChunk();
+        return;
+    }
+
+    dmaBusy = false;
+    if (dmaComplete != NULL) dmaComplete();
+}
+
 /******************************************************************************
  * Function Name  : PutChar
  * Description    : Lcd screen displays a character
@@ -141,26 +894,14 @@ void LCD_DrawRectangle(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t
  *                  - Ypos: Vertical coordinate
  *                  - ASCI: Displayed character
  *                  - charColor: Character color
+ *                  - bkColor: Background color
  * Output         : None
  * Return         : None
- * Attention      : None
+ * Attention      : 256 pixels through one GRAM window
  *******************************************************************************/
-inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charColor)
+inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charColor, uint16_t bkColor)
 {
-    uint16_t i, j;
-    uint8_t buffer[16], tmp_char;
-    GetASCIICode(buffer,ASCI);  /* get font data */
-    for( i=0; i<16; i++ )
-    {
-        tmp_char = buffer[i];
-        for( j=0; j<8; j++ )
-        {
-            if( (tmp_char >> 7 - j) & 0x01 == 0x01 )
-            {
-                LCD_SetPoint( Xpos + j, Ypos + i, charColor );  /* Character color */
-            }
-        }
-    }
+    LCD_DrawGlyphs(Xpos, Ypos, &ASCI, 1, charColor, bkColor);
 }
 
 /******************************************************************************
@@ -169,40 +910,29 @@ inline void PutChar( uint16_t Xpos, uint16_t Ypos, uint8_t ASCI, uint16_t charCo
  * Input          : - Xpos: Horizontal coordinate
  *                  - Ypos: Vertical coordinate
  *                  - str: Displayed string
- *                  - charColor: Character color
+ *                  - Color: Character color
+ *                  - bkColor: Background color
  * Output         : None
  * Return         : None
- * Attention      : None
+ * Attention      : Each line of the string is drawn through one GRAM window
  *******************************************************************************/
-void LCD_Text(uint16_t Xpos, uint16_t Ypos, uint8_t *str, uint16_t Color)
+void LCD_Text(uint16_t Xpos, uint16_t Ypos, uint8_t *str, uint16_t Color, uint16_t bkColor)
 {
-    uint8_t TempChar;
-
-    /* Set area back to span the entire LCD */
-    LCD_WriteReg(HOR_ADDR_START_POS, 0x0000);     /* Horizontal GRAM Start Address */
-    LCD_WriteReg(HOR_ADDR_END_POS, (MAX_SCREEN_Y - 1));  /* Horizontal GRAM End Address */
-    LCD_WriteReg(VERT_ADDR_START_POS, 0x0000);    /* Vertical GRAM Start Address */
-    LCD_WriteReg(VERT_ADDR_END_POS, (MAX_SCREEN_X - 1)); /* Vertical GRAM Start Address */
-    do
+    while (*str != 0)
     {
-        TempChar = *str++;
-        PutChar( Xpos, Ypos, TempChar, Color);
-        if( Xpos < MAX_SCREEN_X - 8)
-        {
-            Xpos += 8;
-        }
-        else if ( Ypos < MAX_SCREEN_X - 16)
-        {
-            Xpos = 0;
-            Ypos += 16;
-        }
-        else
-        {
-            Xpos = 0;
-            Ypos = 0;
-        }
+        /* The characters that fit on the rest of the line go out as one run
+         * (at least one, clipped at the screen edge) */
+        uint16_t fit = (Xpos <= MAX_SCREEN_X - 8) ? (MAX_SCREEN_X - Xpos) / 8 : 1;
+        uint16_t count = 0;
+        while (count < fit && str[count] != 0) ++count;
+
+        LCD_DrawGlyphs(Xpos, Ypos, str, count, Color, bkColor);
+        str += count;
+
+        /* Continue on the next line, or back at the top */
+        Xpos = 0;
+        Ypos = (Ypos < MAX_SCREEN_Y - 16) ? Ypos + 16 : 0;
     }
-    while ( *str != 0 );
 }
 
 
@@ -231,10 +961,7 @@ void LCD_Clear(uint16_t Color)
     /* Start data transmission */
     SPI_CS_LCD_LOW;
     LCD_Write_Data_Start();
-    for (int i = 0; i < SCREEN_SIZE; ++i)
-    {
-        LCD_Write_Data_Only(Color);
-    }
+    LCD_FillPixels(Color, SCREEN_SIZE);
     SPI_CS_LCD_HIGH;
 }
 
@@ -338,16 +1065,20 @@ inline void LCD_WriteIndex(uint16_t index)
  * Input          : uint8_t: byte
  * Output         : None
  * Return         : Recieved value
- * Attention      : None
+ * Attention      : Counted in BusStats, LCD and touch panel alike
  *******************************************************************************/
 inline uint8_t SPISendRecvByte(uint8_t byte)
 {
+    uint32_t start = BUSSTATS_NOW();
+
     /* Send byte of data */
     SPI_transmitData(EUSCI_B3_BASE, byte);
 
     /* Wait as long as busy */ 
     while(SPI_isBusy(EUSCI_B3_BASE));
 
+    BusStats_Count(BUS_LCD_SPI, 1, start);
+
     /* Return received value*/
     return SPI_receiveData(EUSCI_B3_BASE);
 }
@@ -438,6 +1169,7 @@ inline void LCD_SetCursor(uint16_t Xpos, uint16_t Ypos)
 void LCD_Init(bool usingTP)
 {
     LCD_initSPI();
+    LCD_initDMA();
 
     /* Configure low true interrupt on P4.0 for TP */
     if (usingTP)
@@ -6,6 +6,7 @@
  */
 
 #include <RGBLeds.h>
+#include "BusStats.h"
 
 void LP3943_ColorSet(uint32_t unit, uint32_t PWM_DATA)
 {
@@ -43,6 +44,11 @@ void LP3943_LedModeSet(uint32_t unit, uint16_t LED_DATA)
     for (i = 0; i < 4; ++i) LS2_data |= ((LED_DATA >> (8+i) ) & 0x1) << i*2;
     for (i = 0; i < 4; ++i) LS3_data |= ((LED_DATA >> (12+i)) & 0x1) << i*2;
 
+    // Charge the transfer to this call; 6 bytes: address, register, LS0-LS3
+    bus_span_t span;
+    BusStats_Begin(&span, "LP3943_LedModeSet");
+    uint32_t start = BUSSTATS_NOW();
+
     // Calculate slave address from unit no.
     // First 7 bits -> slave address
     // 8th bit -> R/~W
@@ -81,6 +87,9 @@ void LP3943_LedModeSet(uint32_t unit, uint16_t LED_DATA)
     // Generate STOP condition and wait for the STOP bit to go low
     EUSCI_B2->CTLW0 |= EUSCI_B_CTLW0_TXSTP;
     while(EUSCI_B2->CTLW0 & EUSCI_B_CTLW0_TXSTP);
+
+    BusStats_Count(BUS_LED_I2C, 6, start);
+    BusStats_End(&span);
 }
 
 void init_RGBLEDS()
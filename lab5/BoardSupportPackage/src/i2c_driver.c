@@ -36,6 +36,7 @@
 #include "msp432.h"
 #include "i2c_driver.h"
 #include "driverlib.h"
+#include "BusStats.h"
 
 //*****************************************************************************
 //
@@ -117,6 +118,8 @@ void initI2C(void)
 */
 bool writeI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCount)
 {
+	uint32_t ui32Start = BUSSTATS_NOW();
+
 	/* Wait until ready to write */
     while (MAP_I2C_isBusBusy(EUSCI_B1_BASE));
 
@@ -164,6 +167,9 @@ bool writeI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCou
 			EUSCI_B_I2C_NAK_INTERRUPT + EUSCI_B_I2C_TRANSMIT_INTERRUPT0);
     MAP_Interrupt_disableInterrupt(INT_EUSCIB1);
 
+	/* Address, register and data bytes */
+	BusStats_Count(BUS_SENSOR_I2C, ui8ByteCount + 2, ui32Start);
+
 	if(ui8Status == eUSCI_NACK)
 	{
 		return(false);
@@ -179,6 +185,8 @@ bool writeI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCou
 */
 bool readI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCount)
 {
+	uint32_t ui32Start = BUSSTATS_NOW();
+
 	/* Todo: Put a delay */
 	/* Wait until ready */
     while (MAP_I2C_isBusBusy(EUSCI_B1_BASE));
@@ -250,6 +258,9 @@ bool readI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCoun
 			EUSCI_B_I2C_NAK_INTERRUPT + EUSCI_B_I2C_RECEIVE_INTERRUPT0);
     MAP_Interrupt_disableInterrupt(INT_EUSCIB1);
 
+	/* Address, register, address again after the restart, and data bytes */
+	BusStats_Count(BUS_SENSOR_I2C, ui8ByteCount + 3, ui32Start);
+
 	if(ui8Status == eUSCI_NACK)
 	{
 		return(false);
@@ -265,6 +276,8 @@ bool readI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCoun
 */
 bool readBurstI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint32_t ui32ByteCount)
 {
+	uint32_t ui32Start = BUSSTATS_NOW();
+
 	/* Todo: Put a delay */
 	/* Wait until ready */
     while (MAP_I2C_isBusBusy(EUSCI_B1_BASE));
@@ -337,6 +350,9 @@ bool readBurstI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint32_t ui32B
 			EUSCI_B_I2C_NAK_INTERRUPT + EUSCI_B_I2C_RECEIVE_INTERRUPT0);
     MAP_Interrupt_disableInterrupt(INT_EUSCIB1);
 
+	/* Address, register, address again after the restart, and data bytes */
+	BusStats_Count(BUS_SENSOR_I2C, ui32ByteCount + 3, ui32Start);
+
 	if(ui8Status == eUSCI_NACK)
 	{
 		return(false);
@@ -10,5 +10,7 @@
 #include "G8RTOS_Scheduler.h"
 #include "G8RTOS_Semaphores.h"
 #include "G8RTOS_IPC.h"
+#include "G8RTOS_Coroutines.h"
+#include "G8RTOS_Profiler.h"
 
 #endif /* G8RTOS_H_ */
@@ -0,0 +1,215 @@
+/*
+ * G8RTOS_Config.h
+ *
+ * Compile-time configuration of G8RTOS
+ *  - Sizes every kernel table, so all kernel RAM is allocated statically
+ *  - Compiles out the features an application does not use
+ *  - Checks the configuration (and, in G8RTOS_Scheduler.c, the kernel RAM budget) at compile time
+ * Only preprocessor definitions belong here, the file is also pulled into the assembly files.
+ */
+
+#ifndef G8RTOS_CONFIG_H_
+#define G8RTOS_CONFIG_H_
+
+
+/*********************************************** Features *****************************************************************************/
+
+/* Periodic events (G8RTOS_AddPeriodicEvent) and their dispatch thread */
+#define G8RTOS_USE_PTHREADS 0
+
+/* FIFOs (G8RTOS_IPC) */
+#define G8RTOS_USE_FIFOS 1
+
+/* Stackless coroutines (G8RTOS_Coroutines) */
+#define G8RTOS_USE_COROUTINES 1
+
+/* Periodic thread timing statistics (G8RTOS_SetPeriodic and friends) */
+#define G8RTOS_USE_TIMING 1
+
+/* Sampling profiler (G8RTOS_Profiler) */
+#define G8RTOS_USE_PROFILER 0
+
+/* Run the kernel hot path from SRAM (.TI.ramfunc) instead of flash
+ *  - Flash runs with 2 wait states at 48 MHz, SRAM with none
+ *  - Covers PendSV, SysTick, the scheduler and the critical section helpers;
+ *    the linker command file copies .TI.ramfunc to SRAM_CODE at boot */
+#define G8RTOS_USE_RAMFUNCS 1
+
+/* Kernel cycle count benchmark (G8RTOS_KernelBenchmark), also times every SysTick */
+#define G8RTOS_USE_BENCHMARK 0
+
+/* Save the FPU registers of threads on a context switch
+ *  - When 0, automatic FPU state preservation is turned off, so exception
+ *    frames stay the basic size and threads must not share the FPU */
+#define G8RTOS_USE_FPU 0
+
+/*********************************************** Features *****************************************************************************/
+
+
+/*********************************************** Scheduler ****************************************************************************/
+
+#define MAX_THREADS 20
+#define STACK_SIZE 512
+#define MAX_NAME_LENGTH 16
+#define PENDSV_PRIORITY 7
+#define SYSTICK_PRIORITY 7
+
+/*
+ * Kernel interrupt priority ceiling
+ *  - Critical sections mask every interrupt with a priority number greater
+ *    than or equal to this value (0 is the highest priority)
+ *  - Interrupts above the ceiling (e.g. the priority 0 EUSCIB1 I2C and
+ *    CC3100 host interrupts) keep running, so they must never call the kernel
+ */
+#define KERNEL_CEILING_PRIORITY 1
+
+/* Default round-robin quantum in SysTick ticks; threads of equal priority
+ * only take turns when the running thread's quantum expires */
+#define TIME_SLICE_TICKS 1
+
+/* Priority a thread over its CPU budget runs at under BUDGET_DEMOTE */
+#define BUDGET_DEMOTED_PRIORITY 255
+
+/*********************************************** Scheduler ****************************************************************************/
+
+
+/*********************************************** Periodic Events **********************************************************************/
+
+#define MAX_PTHREADS 3
+
+/* When 1, periodic event handlers run in a kernel thread woken by SysTick
+ * instead of inside the SysTick handler itself */
+#define PERIODIC_DISPATCH_THREAD 1
+#define PERIODIC_DISPATCH_PRIORITY 0
+
+/*********************************************** Periodic Events **********************************************************************/
+
+
+/*********************************************** Timing Statistics ********************************************************************/
+
+/* Number of threads that can register as periodic at once */
+#define MAX_PERIODIC_THREADS 8
+
+/* Response time histogram bins; the last bin holds responses at or past the deadline */
+#define TIMING_HISTOGRAM_BINS 8
+
+/*********************************************** Timing Statistics ********************************************************************/
+
+
+/*********************************************** FIFOs ********************************************************************************/
+
+#define FIFO_SIZE 16
+#define MAX_NUMBER_OF_FIFOS 8
+#define NUMBER_OF_INDEXED_FIFOS 4
+
+/* Upper bound on the control block of one FIFO, used for the RAM budget */
+#define FIFO_CONTROL_BYTES 64
+
+/*********************************************** FIFOs ********************************************************************************/
+
+
+/*********************************************** Reader-Writer Locks ******************************************************************/
+
+/* Locks the kernel tracks, so a killed or restarted thread gives back the ones it holds */
+#define MAX_RWLOCKS 4
+
+/*********************************************** Reader-Writer Locks ******************************************************************/
+
+
+/*********************************************** Coroutines ***************************************************************************/
+
+#define MAX_COROUTINES 128
+
+/* Longest time the host thread sleeps when no coroutine is due */
+#define COROUTINE_IDLE_SLEEP 10
+
+/*********************************************** Coroutines ***************************************************************************/
+
+
+/*********************************************** Profiler *****************************************************************************/
+
+/* Samples captured before the profiler waits for a dump */
+#define PROFILER_SAMPLES 256
+
+/* Default sample rate, kept off multiples of the 1 kHz SysTick so samples do not alias with it */
+#define PROFILER_RATE_HZ 2003
+
+/* The sampling interrupt runs above the kernel ceiling so kernel critical sections are sampled too;
+ * it never calls into the kernel */
+#define PROFILER_PRIORITY 0
+
+/*********************************************** Profiler *****************************************************************************/
+
+
+/*********************************************** Benchmark ****************************************************************************/
+
+/* Measurements taken of each operation; the benchmark reports the fastest */
+#define BENCHMARK_ITERATIONS 64
+
+/*********************************************** Benchmark ****************************************************************************/
+
+
+/*********************************************** Memory Budget ************************************************************************/
+
+/* SRAM of the MSP432P401R */
+#define G8RTOS_SRAM_BYTES (64 * 1024)
+
+/* C system stack and heap (--stack_size and --heap_size in the project's linker options) */
+#define G8RTOS_SYSTEM_RAM_BYTES (512 + 1024)
+
+/* SRAM left to the application and the drivers; the application checks its statics fit (lab5: main.c) */
+#define G8RTOS_APP_RAM_BYTES (14 * 1024)
+
+/* SRAM set aside for the functions in .TI.ramfunc */
+#define G8RTOS_RAMFUNC_BYTES 1024
+
+/* SRAM the kernel's tables and thread stacks may use: what the system and the application leave */
+#define G8RTOS_RAM_BUDGET (G8RTOS_SRAM_BYTES - G8RTOS_SYSTEM_RAM_BYTES - G8RTOS_APP_RAM_BYTES)
+
+/*********************************************** Memory Budget ************************************************************************/
+
+
+/*********************************************** Configuration Checks *****************************************************************/
+
+/* Fails to compile if "condition" is false */
+#define G8RTOS_STATIC_ASSERT(condition, name) typedef char g8rtos_static_assert_##name[(condition) ? 1 : -1]
+
+/* Reader-writer locks track readers in a 32 bit mask indexed by TCB */
+#if MAX_THREADS > 32
+#error "MAX_THREADS must be at most 32"
+#endif
+
+/* A stack has to hold at least the initial context (16 words, 17 with the FPU) */
+#if STACK_SIZE < 64
+#error "STACK_SIZE is too small"
+#endif
+
+/* Kernel interrupts run at the lowest priority, below the ceiling */
+#if PENDSV_PRIORITY < KERNEL_CEILING_PRIORITY || SYSTICK_PRIORITY < KERNEL_CEILING_PRIORITY
+#error "PendSV and SysTick must be masked by kernel critical sections"
+#endif
+
+#if KERNEL_CEILING_PRIORITY < 1 || KERNEL_CEILING_PRIORITY > 7
+#error "KERNEL_CEILING_PRIORITY must be between 1 and 7"
+#endif
+
+#if TIMING_HISTOGRAM_BINS < 2
+#error "TIMING_HISTOGRAM_BINS must be at least 2"
+#endif
+
+#if NUMBER_OF_INDEXED_FIFOS > MAX_NUMBER_OF_FIFOS
+#error "The indexed FIFOs come out of the FIFO pool"
+#endif
+
+#if BENCHMARK_ITERATIONS < 1
+#error "BENCHMARK_ITERATIONS must be at least 1"
+#endif
+
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD && MAX_THREADS < 2
+#error "The periodic event dispatch thread needs a TCB of its own"
+#endif
+
+/*********************************************** Configuration Checks *****************************************************************/
+
+
+#endif /* G8RTOS_CONFIG_H_ */
@@ -0,0 +1,128 @@
+/*
+ * G8RTOS_Coroutines.c
+ */
+
+#include <stdint.h>
+#include "msp.h"
+#include "G8RTOS_Coroutines.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS_CriticalSection.h"
+
+#if G8RTOS_USE_COROUTINES
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Coroutines
+ *  - Every coroutine is a few words of state instead of a TCB and a thread stack
+ */
+static coroutine_t coroutines[MAX_COROUTINES];
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*
+ * Current number of coroutines alive
+ */
+static uint32_t NumberOfCoroutines;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Adds a coroutine to be run by the coroutine host thread
+ * Param "handler": coroutine body, written between CO_BEGIN and CO_END
+ * Param "context": state the coroutine keeps across resumes (may be NULL)
+ * Returns: the new coroutine, or NULL if MAX_COROUTINES are already alive
+ */
+coroutine_t* G8RTOS_AddCoroutine(G8RTOS_Coroutine_Status (*handler)(coroutine_t* co), void* context)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    for (int i = 0; i < MAX_COROUTINES; ++i)
+    {
+        if (!coroutines[i].alive)
+        {
+            coroutines[i].handler = handler;
+            coroutines[i].context = context;
+            coroutines[i].wake_time = SystemTime;
+            coroutines[i].resume_point = 0;
+            coroutines[i].alive = true;
+
+            ++NumberOfCoroutines;
+
+            EndCriticalSection(IBit_State);
+            return &coroutines[i];
+        }
+    }
+
+    EndCriticalSection(IBit_State);
+    return NULL;
+}
+
+/*
+ * Ends every coroutine without resuming it again
+ */
+void G8RTOS_KillAllCoroutines()
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    for (int i = 0; i < MAX_COROUTINES; ++i) coroutines[i].alive = false;
+    NumberOfCoroutines = 0;
+
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Returns the number of coroutines currently alive
+ */
+uint32_t G8RTOS_NumberOfCoroutines()
+{
+    return NumberOfCoroutines;
+}
+
+/*
+ * Coroutine Host Thread
+ *  - Runs every due coroutine on this thread's stack, then sleeps until the next one is due
+ */
+void G8RTOS_CoroutineHost()
+{
+    while (1)
+    {
+        uint32_t nextWakeTime = SystemTime + COROUTINE_IDLE_SLEEP;
+
+        for (int i = 0; i < MAX_COROUTINES; ++i)
+        {
+            coroutine_t* co = &coroutines[i];
+            if (!co->alive) continue;
+
+            // resume the coroutine if it is due (wrap safe comparison)
+            if ((int32_t)(SystemTime - co->wake_time) >= 0 && (co->handler)(co) == COROUTINE_EXITED)
+            {
+                // free the slot (unless G8RTOS_KillAllCoroutines already did)
+                int32_t IBit_State = StartCriticalSection();
+                if (co->alive)
+                {
+                    co->alive = false;
+                    --NumberOfCoroutines;
+                }
+                EndCriticalSection(IBit_State);
+                continue;
+            }
+
+            // track the earliest time a coroutine is due again
+            if ((int32_t)(co->wake_time - nextWakeTime) < 0) nextWakeTime = co->wake_time;
+        }
+
+        // sleep until the next coroutine is due, but always give up the CPU for at least a tick
+        int32_t sleepTime = (int32_t)(nextWakeTime - SystemTime);
+        G8RTOS_Sleep(sleepTime > 0 ? sleepTime : 1);
+    }
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_USE_COROUTINES */
@@ -0,0 +1,104 @@
+/*
+ * G8RTOS_Coroutines.h
+ */
+
+#ifndef G8RTOS_COROUTINES_H_
+#define G8RTOS_COROUTINES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "G8RTOS_Config.h"
+
+#if G8RTOS_USE_COROUTINES
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * What a coroutine handler reports back to the host thread when it returns
+ */
+typedef enum G8RTOS_Coroutine_Status
+{
+    COROUTINE_WAITING = 0,
+    COROUTINE_EXITED = 1,
+} G8RTOS_Coroutine_Status;
+
+/*
+ *  Coroutine:
+ *      - A stackless, run-to-completion task run by the coroutine host thread on its stack
+ *      - Locals do not survive a CO_YIELD or CO_SLEEP, anything that must is kept behind "context"
+ *      - resume_point holds the line of the CO_ macro to continue from (0 is the start)
+ *      - wake_time is the system time the coroutine is next due
+ */
+typedef struct coroutine_t
+{
+    G8RTOS_Coroutine_Status (*handler)(struct coroutine_t* co);
+    void* context;
+    uint32_t wake_time;
+    uint16_t resume_point;
+    bool alive;
+} coroutine_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Coroutine Macros *********************************************************************/
+
+/*
+ * Every coroutine handler body is wrapped in CO_BEGIN / CO_END, and must not
+ * use a switch statement around a CO_YIELD or CO_SLEEP
+ */
+#define CO_BEGIN(co)        switch ((co)->resume_point) { case 0:
+
+#define CO_END(co)          } (co)->resume_point = 0; return COROUTINE_EXITED
+
+/* Gives the other coroutines a turn, resuming on the next host pass */
+#define CO_YIELD(co)        do { (co)->resume_point = __LINE__; return COROUTINE_WAITING; case __LINE__:; } while (0)
+
+/* Resumes after "ms" milliseconds of system time */
+#define CO_SLEEP(co, ms)    do { (co)->wake_time = SystemTime + (ms); (co)->resume_point = __LINE__; return COROUTINE_WAITING; case __LINE__:; } while (0)
+
+/* Resumes once "condition" is true, checking it on every host pass */
+#define CO_WAIT_UNTIL(co, condition) do { (co)->resume_point = __LINE__; case __LINE__: if (!(condition)) return COROUTINE_WAITING; } while (0)
+
+/* Ends the coroutine and frees its slot */
+#define CO_EXIT(co)         do { (co)->resume_point = 0; return COROUTINE_EXITED; } while (0)
+
+/*********************************************** Coroutine Macros *********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Adds a coroutine to be run by the coroutine host thread
+ * Param "handler": coroutine body, written between CO_BEGIN and CO_END
+ * Param "context": state the coroutine keeps across resumes (may be NULL)
+ * Returns: the new coroutine, or NULL if MAX_COROUTINES are already alive
+ */
+coroutine_t* G8RTOS_AddCoroutine(G8RTOS_Coroutine_Status (*handler)(coroutine_t* co), void* context);
+
+/*
+ * Ends every coroutine without resuming it again
+ *  - Meant for tearing down a game or application, e.g. next to G8RTOS_KillAllOtherThreads
+ */
+void G8RTOS_KillAllCoroutines();
+
+/*
+ * Returns the number of coroutines currently alive
+ */
+uint32_t G8RTOS_NumberOfCoroutines();
+
+/*
+ * Coroutine Host Thread
+ *  - Added with G8RTOS_AddThread; runs every due coroutine on its own stack,
+ *    then sleeps until the next one is due
+ *  - Coroutines may take short kernel locks, but must not call G8RTOS_Sleep
+ *    or loop forever, since that stalls every other coroutine
+ */
+void G8RTOS_CoroutineHost();
+
+/*********************************************** Public Functions *********************************************************************/
+
+
+#endif /* G8RTOS_USE_COROUTINES */
+
+#endif /* G8RTOS_COROUTINES_H_ */
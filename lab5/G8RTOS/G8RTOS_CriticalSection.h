@@ -9,19 +9,30 @@
 #define G8RTOS_CRITICALSECTION_H_
 
 #include <stdint.h>
+#include "G8RTOS_Config.h"
+
+/*********************************************** Sizes and Limits *********************************************************************/
+
+/* Number of priority bits implemented by the MSP432 NVIC */
+#define KERNEL_NVIC_PRIO_BITS 3
+
+/* Ceiling as it is written into BASEPRI (priority lives in the upper bits) */
+#define KERNEL_CEILING_BASEPRI (KERNEL_CEILING_PRIORITY << (8 - KERNEL_NVIC_PRIO_BITS))
+
+/*********************************************** Sizes and Limits *********************************************************************/
 
 /*
  * Starts a critical section
- * 	- Saves the state of the current PRIMASK (I-bit)
- * 	- Disables interrupts
- * Returns: The current PRIMASK State
+ * 	- Saves the state of the current BASEPRI
+ * 	- Raises BASEPRI to the kernel ceiling (never lowers it)
+ * Returns: The previous BASEPRI State
  */
 extern int32_t StartCriticalSection();
 
 /*
  * Ends a critical Section
- * 	- Restores the state of the PRIMASK given an input
- * Param "IBit_State": PRIMASK State to update
+ * 	- Restores the state of the BASEPRI given an input
+ * Param "IBit_State": BASEPRI State to update
  */
 extern void EndCriticalSection(int32_t IBit_State);
 
@@ -4,32 +4,40 @@
 
 	; Functions Defined
 	.def StartCriticalSection, EndCriticalSection
+
+	; Pull in KERNEL_CEILING_BASEPRI and G8RTOS_USE_RAMFUNCS
+	.cdecls C,NOLIST,"G8RTOS_CriticalSection.h"
 	
 	.thumb		; Set to thumb mode
 	.align 2	; Align by 2 bytes (thumb mode uses allignment by 2 or 4)
+	.if G8RTOS_USE_RAMFUNCS
+	.sect ".TI.ramfunc" ; Run from SRAM, critical sections are on the hot path
+	.else
 	.text		; Text section
+	.endif
 	
 
 ; Starts a critical section
-; 	- Saves the state of the current PRIMASK (I-bit)
-; 	- Disables interrupts
-; Returns: The current PRIMASK State
+; 	- Saves the state of the current BASEPRI
+; 	- Masks interrupts at or below the kernel ceiling
+; Returns: The previous BASEPRI State
 StartCriticalSection:
 	.asmfunc
 
-	MRS R0, PRIMASK		; Save PRIMASK to R0 (Return Register)
-	CPSID I				; Disable Interrupts
+	MRS R0, BASEPRI		; Save BASEPRI to R0 (Return Register)
+	MOV R1, #KERNEL_CEILING_BASEPRI
+	MSR BASEPRI_MAX, R1	; Raise BASEPRI to the ceiling, nested sections never lower it
 	BX LR				; Return
 
 	.endasmfunc
 
 ; Ends a critical Section
-; 	- Restores the state of the PRIMASK given an input
-; Param R0: PRIMASK State to update
+; 	- Restores the state of the BASEPRI given an input
+; Param R0: BASEPRI State to update
 EndCriticalSection:
 	.asmfunc
 	
-	MSR PRIMASK, R0		; Save R0 (Param) to PRIMASK
+	MSR BASEPRI, R0		; Save R0 (Param) to BASEPRI
 	BX LR				; Return
 	
 	.endasmfunc
\ No newline at end of file
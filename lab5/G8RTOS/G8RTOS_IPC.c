@@ -6,163 +6,357 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include "msp.h"
 #include "G8RTOS_IPC.h"
 #include "G8RTOS_Semaphores.h"
+#include "G8RTOS_CriticalSection.h"
 
-
-/*********************************************** Defines ******************************************************************************/
-
-#define FIFO_SIZE 16
-#define MAX_NUMBER_OF_FIFOS 4
-
-/*********************************************** Defines ******************************************************************************/
-
+#if G8RTOS_USE_FIFOS
 
 /*********************************************** Data Structures Used *****************************************************************/
 
-typedef struct FIFO_t {
-    int32_t buffer[FIFO_SIZE];
-    int32_t* head;
-    int32_t* tail;
+typedef struct G8RTOS_FIFO_t {
+    uint8_t* buffer;
+    uint8_t* end;
+    uint8_t* head;
+    uint8_t* tail;
+    uint32_t elem_size;
+    uint32_t depth;
+    uint32_t count;
     uint32_t lost_data;
+    G8RTOS_FIFO_Policy policy;
+    bool in_use;
     semaphore_t current_size;
+    semaphore_t free_space;
     semaphore_t mutex;
-} FIFO_t;
+} G8RTOS_FIFO_t;
+
+/* The RAM budget in G8RTOS_Scheduler.c counts FIFO_CONTROL_BYTES per FIFO */
+G8RTOS_STATIC_ASSERT(sizeof(G8RTOS_FIFO_t) <= FIFO_CONTROL_BYTES, fifo_control_block_size);
+
+/* Pool of FIFO control blocks, the element storage belongs to the caller */
+static G8RTOS_FIFO_t FIFOs[MAX_NUMBER_OF_FIFOS];
 
-/* Array of FIFOS */
-static FIFO_t FIFOs[4];
+/* Storage and handles backing the index based FIFO API */
+static int32_t indexedBuffers[NUMBER_OF_INDEXED_FIFOS][FIFO_SIZE];
+static fifo_t indexedFIFOs[NUMBER_OF_INDEXED_FIFOS];
 
 /*********************************************** Data Structures Used *****************************************************************/
 
+
+/*********************************************** Private Functions ********************************************************************/
+
 /*
- * Initializes FIFO i
- * Param "i": which buffer we wish to initialize
- * Returns: error code (G8RTOS_FIFO_Error)
+ * Copies one element out of the head of the FIFO and advances the head
+ * (wrapping if necessary). Must hold the FIFO mutex.
  */
-G8RTOS_FIFO_Error G8RTOS_InitFIFO(uint32_t i)
+static void PopElement(G8RTOS_FIFO_t* fifo, uint8_t* data)
 {
-    if (i >= MAX_NUMBER_OF_FIFOS) return ERR_FIFO_INDEX;
+    memcpy(data, fifo->head, fifo->elem_size);
 
-    FIFOs[i].head = &(FIFOs[i].buffer[0]);
-    FIFOs[i].tail = &(FIFOs[i].buffer[0]);
-    FIFOs[i].lost_data = 0;
-    G8RTOS_InitSemaphore(&(FIFOs[i].current_size), 0);
-    G8RTOS_InitSemaphore(&(FIFOs[i].mutex), 1);
+    fifo->head += fifo->elem_size;
+    if (fifo->head >= fifo->end) fifo->head = fifo->buffer;
 
-    return OK_FIFO;
+    --fifo->count;
 }
 
 /*
- * Reads from FIFO i
- *  - Waits until current_size semaphore is greater than zero
- *  - Gets data and increments head (wrapping if necessary)
- * Param: "i": which buffer we want to read from
- * Returns: int32_t data from FIFO i
+ * Copies one element into the tail of the FIFO, applying the overflow
+ * policy. Must hold the FIFO mutex, the caller signals current_size for
+ * every element the FIFO grew by.
+ * Returns: error code (G8RTOS_FIFO_Error)
  */
-int32_t G8RTOS_ReadFIFO(uint32_t i)
+static G8RTOS_FIFO_Error PushElement(G8RTOS_FIFO_t* fifo, const uint8_t* data)
 {
-    /* TODO - how can we return errors?
-     * Perhaps we pass in a pointer to an integer and fill it with data.
-     * It is valid only if we receive OK as return value.
-     * If this is the desired soln., edit the method signature */
+    G8RTOS_FIFO_Error status = OK_FIFO;
 
-    // if the order of the two below waits are changed, deadlocks can occur
+    // a blocking writer already claimed a free slot, so only the other policies can be full
+    if (fifo->count >= fifo->depth)
+    {
+        // increment our lost data counter
+        ++fifo->lost_data;
 
-    // claim an element inside the FIFO, blocking if it doesn't exist yet
-    G8RTOS_WaitSemaphore(&(FIFOs[i].current_size));
-    // wait for exclusive access to the FIFO
-    G8RTOS_WaitSemaphore(&(FIFOs[i].mutex));
+        if (fifo->policy == FIFO_DROP_NEWEST) return ERR_FIFO_FULL;
 
-    // read the data from the FIFO
-    int32_t data = *(FIFOs[i].head);
+        /* advance the head to point at the oldest data (the previous oldest
+         * data is about to be overwritten) and wrap if needed */
+        fifo->head += fifo->elem_size;
+        if (fifo->head >= fifo->end) fifo->head = fifo->buffer;
 
-    /* increment the head and wrap the head if needed (if we are pointing to
-     * an element outside of the buffer) */
-    ++FIFOs[i].head;
-    if (FIFOs[i].head >= &(FIFOs[i].buffer[FIFO_SIZE]))
+        status = ERR_DATA_OVERWRITTEN;
+    }
+    else
     {
-        FIFOs[i].head = &(FIFOs[i].buffer[0]);
+        // else we won't overwrite any data, our buffer has grown
+        ++fifo->count;
     }
 
+    // write the data at the tail (the next insertion point)
+    memcpy(fifo->tail, data, fifo->elem_size);
+
+    // always advance the tail pointer and wrap if needed
+    fifo->tail += fifo->elem_size;
+    if (fifo->tail >= fifo->end) fifo->tail = fifo->buffer;
+
+    return status;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Creates a FIFO on top of caller provided storage
+ * Param "buffer": storage for the elements, at least elem_size * depth bytes
+ * Param "elem_size": size of a single element in bytes
+ * Param "depth": number of elements the FIFO can hold
+ * Param "policy": what a write does when the FIFO is full
+ * Returns: handle to the FIFO, or NULL if no FIFO could be allocated
+ */
+fifo_t G8RTOS_FIFO_Create(void* buffer, uint32_t elem_size, uint32_t depth, G8RTOS_FIFO_Policy policy)
+{
+    if (buffer == 0 || elem_size == 0 || depth == 0) return 0;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    // claim the first FIFO control block not in use
+    G8RTOS_FIFO_t* fifo = 0;
+    for (int i = 0; i < MAX_NUMBER_OF_FIFOS; ++i)
+    {
+        if (!FIFOs[i].in_use)
+        {
+            fifo = &FIFOs[i];
+            fifo->in_use = true;
+            break;
+        }
+    }
+
+    EndCriticalSection(IBit_State);
+
+    if (fifo == 0) return 0;
+
+    fifo->buffer = (uint8_t*)buffer;
+    fifo->end = fifo->buffer + elem_size * depth;
+    fifo->head = fifo->buffer;
+    fifo->tail = fifo->buffer;
+    fifo->elem_size = elem_size;
+    fifo->depth = depth;
+    fifo->count = 0;
+    fifo->lost_data = 0;
+    fifo->policy = policy;
+    G8RTOS_InitSemaphore(&fifo->current_size, 0);
+    G8RTOS_InitSemaphore(&fifo->free_space, depth);
+    G8RTOS_InitSemaphore(&fifo->mutex, 1);
+
+    return fifo;
+}
+
+/*
+ * Releases a FIFO so it can be created again
+ *  - No thread may be blocked on the FIFO when it is deleted
+ * Param "fifo": FIFO to release
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_Delete(fifo_t fifo)
+{
+    if (fifo == 0 || !fifo->in_use) return ERR_FIFO_HANDLE;
+
+    fifo->in_use = false;
+
+    return OK_FIFO;
+}
+
+/*
+ * Reads one element from a FIFO, blocking until one is available
+ * Param "fifo": FIFO to read from
+ * Param "data": where the element is copied to
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_Read(fifo_t fifo, void* data)
+{
+    return G8RTOS_FIFO_ReadN(fifo, data, 1);
+}
+
+/*
+ * Reads n elements from a FIFO, taking the FIFO lock and semaphores once for the batch
+ *  - Blocks until all n elements are available
+ *  - Meant for a single reader per FIFO
+ * Param "fifo": FIFO to read from
+ * Param "data": where the elements are copied to (n * elem_size bytes)
+ * Param "n": number of elements to read, at most the FIFO depth
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_ReadN(fifo_t fifo, void* data, uint32_t n)
+{
+    if (fifo == 0 || !fifo->in_use) return ERR_FIFO_HANDLE;
+    if (n > fifo->depth) return ERR_FIFO_BATCH_SIZE;
+
+    // if the order of the two below waits are changed, deadlocks can occur
+
+    // claim n elements inside the FIFO, blocking if they don't exist yet
+    G8RTOS_WaitSemaphoreN(&fifo->current_size, n);
+    // wait for exclusive access to the FIFO, once for the whole batch
+    G8RTOS_WaitSemaphore(&fifo->mutex);
+
+    uint8_t* dst = (uint8_t*)data;
+    for (uint32_t i = 0; i < n; ++i, dst += fifo->elem_size) PopElement(fifo, dst);
+
     // allow others exclusive access to the FIFO
-    G8RTOS_SignalSemaphore(&(FIFOs[i].mutex));
+    G8RTOS_SignalSemaphore(&fifo->mutex);
 
-    return data;
+    // hand the freed slots back to any blocked writers
+    if (fifo->policy == FIFO_BLOCK_WRITER) G8RTOS_SignalSemaphoreN(&fifo->free_space, n);
+
+    return OK_FIFO;
 }
 
 /*
- * Writes to FIFO i
- *  - Writes data to tail of the buffer and increments tail (wrapping if
- *    necessary)
- *  Param "i": which buffer we want to read from
- *        "data': data being put into FIFO
- *  Returns: error code (G8RTOS_FIFO_Error)
+ * Writes one element to a FIFO, following the FIFO's overflow policy
+ * Param "fifo": FIFO to write to
+ * Param "data": element to copy into the FIFO
+ * Returns: error code (G8RTOS_FIFO_Error)
  */
-G8RTOS_FIFO_Error G8RTOS_WriteFIFO(uint32_t i, int32_t data)
+G8RTOS_FIFO_Error G8RTOS_FIFO_Write(fifo_t fifo, const void* data)
 {
-    if (i >= MAX_NUMBER_OF_FIFOS) return ERR_FIFO_INDEX;
+    return G8RTOS_FIFO_WriteN(fifo, data, 1);
+}
+
+/*
+ * Writes n elements to a FIFO, taking the FIFO lock and semaphores once for the batch
+ * Param "fifo": FIFO to write to
+ * Param "data": elements to copy into the FIFO (n * elem_size bytes)
+ * Param "n": number of elements to write, at most the FIFO depth
+ * Returns: error code (G8RTOS_FIFO_Error), reporting the last overflow seen
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_WriteN(fifo_t fifo, const void* data, uint32_t n)
+{
+    if (fifo == 0 || !fifo->in_use) return ERR_FIFO_HANDLE;
+    if (n > fifo->depth) return ERR_FIFO_BATCH_SIZE;
 
     // default error status
     G8RTOS_FIFO_Error status = OK_FIFO;
 
-    // wait for exclusive access to the FIFO
-    G8RTOS_WaitSemaphore(&(FIFOs[i].mutex));
+    // a blocking writer claims a free slot per element before touching the FIFO
+    if (fifo->policy == FIFO_BLOCK_WRITER) G8RTOS_WaitSemaphoreN(&fifo->free_space, n);
 
-    // write the data at the tail (the next insertion point)
-    *(FIFOs[i].tail) = data;
-
-    // if we just overwrote data
-    if (FIFOs[i].current_size > FIFO_SIZE - 1)
-    {
-        // increment our last data counter
-        ++FIFOs[i].lost_data;
+    // wait for exclusive access to the FIFO, once for the whole batch
+    G8RTOS_WaitSemaphore(&fifo->mutex);
 
-        /* advance the head to point at the oldest data (the previous oldest
-         * data was just overwritten) and wrap if needed */
-        ++FIFOs[i].head;
-        if (FIFOs[i].head >= &(FIFOs[i].buffer[FIFO_SIZE]))
-        {
-            FIFOs[i].head = &(FIFOs[i].buffer[0]);
-        }
+    uint32_t count = fifo->count;
 
-        // change the status from the default to an error
-        status = ERR_DATA_OVERWRITTEN;
-    }
-    else
+    const uint8_t* src = (const uint8_t*)data;
+    for (uint32_t i = 0; i < n; ++i, src += fifo->elem_size)
     {
-        // else we didn't overwrite any data, signal that our buffer has grown
-        G8RTOS_SignalSemaphore(&(FIFOs[i].current_size));
+        G8RTOS_FIFO_Error push_status = PushElement(fifo, src);
+        if (push_status != OK_FIFO) status = push_status;
     }
 
-    // always advance the tail pointer and wrap if needed
-    ++FIFOs[i].tail;
-    if (FIFOs[i].tail >= &(FIFOs[i].buffer[FIFO_SIZE]))
-    {
-        FIFOs[i].tail = &(FIFOs[i].buffer[0]);
-    }
+    // signal that our buffer has grown, once for every element that was not overwritten
+    G8RTOS_SignalSemaphoreN(&fifo->current_size, fifo->count - count);
 
-    // signal and allow others exclusive access to the FIFO
-    G8RTOS_SignalSemaphore(&(FIFOs[i].mutex));
+    // allow others exclusive access to the FIFO
+    G8RTOS_SignalSemaphore(&fifo->mutex);
 
     return status;
 }
 
 /*
- * Checks if FIFO i is empty
+ * Checks if a FIFO is empty
  *  - Can be used to prevent a blocking read.
- *  Param "i": which buffer we want to read from
- *  Returns: true if the buffer is empty
+ * Param "fifo": FIFO to check
+ * Returns: true if the FIFO is empty (or the handle is invalid)
  */
-bool G8RTOS_FIFOIsEmpty(uint32_t i)
+bool G8RTOS_FIFO_IsEmpty(fifo_t fifo)
 {
+    if (fifo == 0 || !fifo->in_use) return true;
+
     // wait for exclusive access to the FIFO
-    G8RTOS_WaitSemaphore(&(FIFOs[i].mutex));
+    G8RTOS_WaitSemaphore(&fifo->mutex);
 
-    bool is_empty = FIFOs[i].current_size == 0;
+    bool is_empty = fifo->count == 0;
 
     // allow others exclusive access to the FIFO
-    G8RTOS_SignalSemaphore(&(FIFOs[i].mutex));
+    G8RTOS_SignalSemaphore(&fifo->mutex);
 
     return is_empty;
 }
+
+/*
+ * Returns the number of elements a FIFO has dropped or overwritten
+ */
+uint32_t G8RTOS_FIFO_LostData(fifo_t fifo)
+{
+    if (fifo == 0 || !fifo->in_use) return 0;
+
+    return fifo->lost_data;
+}
+
+/*
+ * Initializes FIFO i
+ * Param "i": which buffer we wish to initialize
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_InitFIFO(uint32_t i)
+{
+    if (i >= NUMBER_OF_INDEXED_FIFOS) return ERR_FIFO_INDEX;
+
+    // re-initializing FIFO i releases its previous control block
+    if (indexedFIFOs[i] != 0) G8RTOS_FIFO_Delete(indexedFIFOs[i]);
+
+    indexedFIFOs[i] = G8RTOS_FIFO_Create(indexedBuffers[i], sizeof(int32_t), FIFO_SIZE, FIFO_OVERWRITE_OLDEST);
+    if (indexedFIFOs[i] == 0) return ERR_FIFO_HANDLE;
+
+    return OK_FIFO;
+}
+
+/*
+ * Reads from FIFO i
+ *  - Waits until current_size semaphore is greater than zero
+ *  - Gets data and increments head (wrapping if necessary)
+ * Param: "i": which buffer we want to read from
+ * Returns: int32_t data from FIFO i (0 if "i" is not a valid FIFO)
+ */
+int32_t G8RTOS_ReadFIFO(uint32_t i)
+{
+    int32_t data = 0;
+
+    if (i >= NUMBER_OF_INDEXED_FIFOS) return data;
+
+    G8RTOS_FIFO_Read(indexedFIFOs[i], &data);
+
+    return data;
+}
+
+/*
+ * Writes to FIFO i
+ *  - Writes data to tail of the buffer and increments tail (wrapping if
+ *    necessary)
+ *  Param "i": which buffer we want to read from
+ *        "data': data being put into FIFO
+ *  Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_WriteFIFO(uint32_t i, int32_t data)
+{
+    if (i >= NUMBER_OF_INDEXED_FIFOS) return ERR_FIFO_INDEX;
+
+    return G8RTOS_FIFO_Write(indexedFIFOs[i], &data);
+}
+
+/*
+ * Checks if FIFO i is empty
+ *  - Can be used to prevent a blocking read.
+ *  Param "i": which buffer we want to read from
+ *  Returns: true if the buffer is empty
+ */
+bool G8RTOS_FIFOIsEmpty(uint32_t i)
+{
+    if (i >= NUMBER_OF_INDEXED_FIFOS) return true;
+
+    return G8RTOS_FIFO_IsEmpty(indexedFIFOs[i]);
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_USE_FIFOS */
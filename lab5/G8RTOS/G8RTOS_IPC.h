@@ -8,8 +8,11 @@
 #ifndef G8RTOS_IPC_H_
 #define G8RTOS_IPC_H_
 
+#include <stdint.h>
 #include <stdbool.h>
+#include "G8RTOS_Config.h"
 
+#if G8RTOS_USE_FIFOS
 
 /*********************************************** Error Codes **************************************************************************/
 typedef enum G8RTOS_FIFO_Error
@@ -17,14 +20,109 @@ typedef enum G8RTOS_FIFO_Error
     OK_FIFO = 0,
     ERR_FIFO_INDEX = -1,
     ERR_DATA_OVERWRITTEN = -2,
+    ERR_FIFO_FULL = -3,
+    ERR_FIFO_HANDLE = -4,
+    ERR_FIFO_BATCH_SIZE = -5,
 } G8RTOS_FIFO_Error;
 /*********************************************** Error Codes **************************************************************************/
 
 
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * What a write does when the FIFO is already full
+ *  - FIFO_OVERWRITE_OLDEST: the oldest element is dropped (ERR_DATA_OVERWRITTEN)
+ *  - FIFO_DROP_NEWEST: the new element is dropped (ERR_FIFO_FULL)
+ *  - FIFO_BLOCK_WRITER: the writer blocks until a reader frees a slot
+ */
+typedef enum G8RTOS_FIFO_Policy
+{
+    FIFO_OVERWRITE_OLDEST = 0,
+    FIFO_DROP_NEWEST = 1,
+    FIFO_BLOCK_WRITER = 2,
+} G8RTOS_FIFO_Policy;
+
+/*
+ * FIFO handle returned by G8RTOS_FIFO_Create
+ */
+typedef struct G8RTOS_FIFO_t* fifo_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
 /*********************************************** Public Functions *********************************************************************/
 
+/*
+ * Creates a FIFO on top of caller provided storage
+ * Param "buffer": storage for the elements, at least elem_size * depth bytes
+ * Param "elem_size": size of a single element in bytes
+ * Param "depth": number of elements the FIFO can hold
+ * Param "policy": what a write does when the FIFO is full
+ * Returns: handle to the FIFO, or NULL if no FIFO could be allocated
+ */
+fifo_t G8RTOS_FIFO_Create(void* buffer, uint32_t elem_size, uint32_t depth, G8RTOS_FIFO_Policy policy);
+
+/*
+ * Releases a FIFO so it can be created again
+ *  - No thread may be blocked on the FIFO when it is deleted
+ * Param "fifo": FIFO to release
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_Delete(fifo_t fifo);
+
+/*
+ * Reads one element from a FIFO, blocking until one is available
+ * Param "fifo": FIFO to read from
+ * Param "data": where the element is copied to
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_Read(fifo_t fifo, void* data);
+
+/*
+ * Reads n elements from a FIFO, taking the FIFO lock once for the batch
+ *  - Blocks until all n elements are available
+ *  - Meant for a single reader per FIFO
+ * Param "fifo": FIFO to read from
+ * Param "data": where the elements are copied to (n * elem_size bytes)
+ * Param "n": number of elements to read, at most the FIFO depth
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_ReadN(fifo_t fifo, void* data, uint32_t n);
+
+/*
+ * Writes one element to a FIFO, following the FIFO's overflow policy
+ * Param "fifo": FIFO to write to
+ * Param "data": element to copy into the FIFO
+ * Returns: error code (G8RTOS_FIFO_Error)
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_Write(fifo_t fifo, const void* data);
+
+/*
+ * Writes n elements to a FIFO, taking the FIFO lock once for the batch
+ * Param "fifo": FIFO to write to
+ * Param "data": elements to copy into the FIFO (n * elem_size bytes)
+ * Param "n": number of elements to write, at most the FIFO depth
+ * Returns: error code (G8RTOS_FIFO_Error), reporting the last overflow seen
+ */
+G8RTOS_FIFO_Error G8RTOS_FIFO_WriteN(fifo_t fifo, const void* data, uint32_t n);
+
+/*
+ * Checks if a FIFO is empty
+ *  - Can be used to prevent a blocking read.
+ * Param "fifo": FIFO to check
+ * Returns: true if the FIFO is empty (or the handle is invalid)
+ */
+bool G8RTOS_FIFO_IsEmpty(fifo_t fifo);
+
+/*
+ * Returns the number of elements a FIFO has dropped or overwritten
+ */
+uint32_t G8RTOS_FIFO_LostData(fifo_t fifo);
+
 /*
  * Initializes One to One FIFO Struct
+ *  - Index based wrapper around a FIFO_SIZE deep int32_t FIFO that
+ *    overwrites its oldest data
  */
 G8RTOS_FIFO_Error G8RTOS_InitFIFO(uint32_t i);
 
@@ -33,7 +131,7 @@ G8RTOS_FIFO_Error G8RTOS_InitFIFO(uint32_t i);
  *  - Waits until CurrentSize semaphore is greater than zero
  *  - Gets data and increments the head ptr (wraps if necessary)
  * Param "i": chooses which buffer we want to read from
- * Returns: int32_t Data from FIFO
+ * Returns: int32_t Data from FIFO (0 if "i" is not a valid FIFO)
  */
 int32_t G8RTOS_ReadFIFO(uint32_t i);
 
@@ -58,4 +156,6 @@ bool G8RTOS_FIFOIsEmpty(uint32_t i);
 /*********************************************** Public Functions *********************************************************************/
 
 
+#endif /* G8RTOS_USE_FIFOS */
+
 #endif /* G8RTOS_IPC_H_ */
@@ -0,0 +1,166 @@
+/*
+ * G8RTOS_Profiler.c
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_Profiler.h"
+#include "G8RTOS_Scheduler.h"
+
+#if G8RTOS_USE_PROFILER
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+/*
+ * Pointer to the currently running Thread Control Block
+ */
+extern tcb_t * CurrentlyRunningThread;
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Positions of the stacked lr and pc in an exception frame */
+#define FRAME_LR 5
+#define FRAME_PC 6
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Capture Buffer
+ *  - Samples in the order they were taken
+ */
+static profiler_sample_t samples[PROFILER_SAMPLES];
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*
+ * Number of samples in the capture buffer
+ */
+static volatile uint32_t NumberOfSamples;
+
+/*
+ * Samples dropped because the capture buffer was full
+ */
+static volatile uint32_t DroppedSamples;
+
+/*
+ * Whether the sampling timer is running
+ */
+static bool Sampling;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Starts sampling into an empty capture buffer
+ * Param "rate_hz": samples per second
+ */
+void G8RTOS_ProfilerStart(uint32_t rate_hz)
+{
+    NumberOfSamples = 0;
+    DroppedSamples = 0;
+
+    // Timer32 2 in 32 bit periodic mode, running off MCLK
+    TIMER32_2->CONTROL = 0;
+    TIMER32_2->LOAD = ClockSys_GetSysFreq() / rate_hz;
+    TIMER32_2->INTCLR = 0;
+
+    __NVIC_SetVector(T32_INT2_IRQn, (uint32_t)G8RTOS_ProfilerISR);
+    __NVIC_SetPriority(T32_INT2_IRQn, PROFILER_PRIORITY);
+    NVIC_EnableIRQ(T32_INT2_IRQn);
+
+    TIMER32_2->CONTROL = TIMER32_CONTROL_SIZE | TIMER32_CONTROL_MODE | TIMER32_CONTROL_IE | TIMER32_CONTROL_ENABLE;
+    Sampling = true;
+}
+
+/*
+ * Stops sampling, keeping the samples captured so far
+ */
+void G8RTOS_ProfilerStop()
+{
+    TIMER32_2->CONTROL &= ~TIMER32_CONTROL_ENABLE;
+    NVIC_DisableIRQ(T32_INT2_IRQn);
+    Sampling = false;
+}
+
+/*
+ * Prints the captured samples over the back channel UART and empties the buffer
+ */
+void G8RTOS_ProfilerDump()
+{
+    char line[64];
+    threadId_t threads[MAX_THREADS];
+    uint32_t numberOfThreads = 0;
+
+    // Pause sampling so the buffer holds still while it is printed
+    bool wasSampling = Sampling;
+    TIMER32_2->CONTROL &= ~TIMER32_CONTROL_ENABLE;
+
+    for (uint32_t i = 0; i < NumberOfSamples; ++i)
+    {
+        snprintf(line, sizeof(line), "prof %08x %08x %08x", samples[i].thread_id, samples[i].pc, samples[i].lr);
+        BackChannelPrint(line, BackChannel_Info);
+
+        // remember every thread seen, so its name can be printed once
+        uint32_t j = 0;
+        while (j < numberOfThreads && threads[j] != samples[i].thread_id) ++j;
+        if (j == numberOfThreads && numberOfThreads < MAX_THREADS) threads[numberOfThreads++] = samples[i].thread_id;
+    }
+
+    for (uint32_t j = 0; j < numberOfThreads; ++j)
+    {
+        const char* name = G8RTOS_GetThreadName(threads[j]);
+        snprintf(line, sizeof(line), "thread %08x %s", threads[j], (name == NULL) ? "(killed)" : name);
+        BackChannelPrint(line, BackChannel_Info);
+    }
+
+    if (DroppedSamples > 0) BackChannelPrintIntVariable("prof_dropped", DroppedSamples);
+
+    NumberOfSamples = 0;
+    DroppedSamples = 0;
+
+    if (wasSampling) TIMER32_2->CONTROL |= TIMER32_CONTROL_ENABLE;
+}
+
+/*
+ * Returns the number of samples dropped because the buffer was full
+ */
+uint32_t G8RTOS_ProfilerDropped()
+{
+    return DroppedSamples;
+}
+
+/*
+ * Records one sample
+ * Param "frame": stacked r0, r1, r2, r3, r12, lr, pc, xpsr
+ */
+void G8RTOS_ProfilerSample(uint32_t* frame)
+{
+    TIMER32_2->INTCLR = 0;
+
+    if (NumberOfSamples >= PROFILER_SAMPLES)
+    {
+        ++DroppedSamples;
+        return;
+    }
+
+    samples[NumberOfSamples].pc = frame[FRAME_PC];
+    samples[NumberOfSamples].lr = frame[FRAME_LR];
+    samples[NumberOfSamples].thread_id = CurrentlyRunningThread->thread_id;
+    ++NumberOfSamples;
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_USE_PROFILER */
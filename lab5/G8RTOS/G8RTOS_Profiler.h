@@ -0,0 +1,80 @@
+/*
+ * G8RTOS_Profiler.h
+ *
+ * Sampling profiler: Timer32 2 interrupts at a fixed rate and records the
+ * interrupted PC and LR together with the running thread's ID. The samples
+ * are dumped over the back channel UART and symbolised on the host with
+ * tools/g8rtos_profile.py.
+ */
+
+#ifndef G8RTOS_PROFILER_H_
+#define G8RTOS_PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "G8RTOS_Structures.h"
+#include "G8RTOS_Config.h"
+
+#if G8RTOS_USE_PROFILER
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * One sample of the interrupted context
+ */
+typedef struct profiler_sample_t
+{
+    uint32_t pc;
+    uint32_t lr;
+    threadId_t thread_id;
+} profiler_sample_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Starts sampling into an empty capture buffer
+ * Param "rate_hz": samples per second
+ */
+void G8RTOS_ProfilerStart(uint32_t rate_hz);
+
+/*
+ * Stops sampling, keeping the samples captured so far
+ */
+void G8RTOS_ProfilerStop();
+
+/*
+ * Prints the captured samples over the back channel UART and empties the buffer
+ *  - One "prof <thread id> <pc> <lr>" line per sample, then one
+ *    "thread <thread id> <name>" line per thread seen
+ *  - Sampling pauses while dumping and resumes afterwards if it was running
+ *  - Meant to be called from a low priority thread; printing is slow
+ */
+void G8RTOS_ProfilerDump();
+
+/*
+ * Returns the number of samples dropped because the buffer was full
+ */
+uint32_t G8RTOS_ProfilerDropped();
+
+/*
+ * Records one sample
+ *  - Called by the sampling interrupt (G8RTOS_ProfilerISR) with the
+ *    interrupted context's exception frame
+ * Param "frame": stacked r0, r1, r2, r3, r12, lr, pc, xpsr
+ */
+void G8RTOS_ProfilerSample(uint32_t* frame);
+
+/*
+ * Sampling interrupt, exists in asm
+ */
+extern void G8RTOS_ProfilerISR();
+
+/*********************************************** Public Functions *********************************************************************/
+
+
+#endif /* G8RTOS_USE_PROFILER */
+
+#endif /* G8RTOS_PROFILER_H_ */
@@ -0,0 +1,37 @@
+; G8RTOS_ProfilerASM.s
+; Holds the sampling interrupt of the profiler
+; Note: If you have an h file, do not have a C file and an S file of the same name
+
+	; Pull in G8RTOS_USE_PROFILER
+	.cdecls C,NOLIST,"G8RTOS_Config.h"
+
+	.if G8RTOS_USE_PROFILER
+
+	; Functions Defined
+	.def G8RTOS_ProfilerISR
+
+	; Dependencies
+	.ref G8RTOS_ProfilerSample
+
+	.thumb		; Set to thumb mode
+	.align 2	; Align by 2 bytes (thumb mode uses allignment by 2 or 4)
+	.text		; Text section
+
+; G8RTOS_ProfilerISR
+; - Hands the interrupted context's exception frame to G8RTOS_ProfilerSample
+;	- Every thread runs on the main stack, so the frame is at sp on entry
+;	- Tail calls the C function, which returns straight from the exception
+G8RTOS_ProfilerISR:
+
+	.asmfunc
+
+	mov r0, sp
+	b G8RTOS_ProfilerSample
+
+	.endasmfunc
+
+	.endif
+
+	; end of the asm file
+	.align
+	.end
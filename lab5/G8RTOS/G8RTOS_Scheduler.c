@@ -30,10 +30,17 @@ extern tcb_t * CurrentlyRunningThread;
 
 /*********************************************** Defines ******************************************************************************/
 
+/* BusStats holds off interrupts the way kernel critical sections do */
+#if BUSSTATS_CEILING_PRIORITY != KERNEL_CEILING_PRIORITY
+#error "BUSSTATS_CEILING_PRIORITY must equal KERNEL_CEILING_PRIORITY"
+#endif
+
 /* Status Register with the Thumb-bit Set */
 #define THUMBBIT 0x01000000
 /* Default Register Values */
 #define ZERO 0x0000
+/* Exception return to thread mode on the main stack with a basic (no FPU) frame */
+#define EXC_RETURN_THREAD_MSP 0xFFFFFFF9
 
 /*********************************************** Defines ******************************************************************************/
 
@@ -45,15 +52,55 @@ extern tcb_t * CurrentlyRunningThread;
  */
 static tcb_t threadControlBlocks[MAX_THREADS];
 
+/* Vector Table in SRAM
+ *  - Placed in .vtable (the start of SRAM) so the linker keeps other sections,
+ *    including the SRAM_CODE alias of .TI.ramfunc, from overlapping it
+ */
+#pragma DATA_SECTION(ramVectorTable, ".vtable")
+#pragma DATA_ALIGN(ramVectorTable, 256)
+static uint32_t ramVectorTable[57];
+
 /* Thread Stacks
  *	- An array of arrays that will act as individual stacks for each thread
  */
 static int32_t threadStacks[MAX_THREADS][STACK_SIZE];
 
+#if G8RTOS_USE_PTHREADS
 /* Periodic Event Threads
  * - An array of periodic events to hold pertinent information for each thread
  */
 static ptcb_t periodicThreadControlBlocks[MAX_PTHREADS];
+#endif
+
+#if G8RTOS_USE_TIMING
+/* Periodic Thread Timings
+ * - Statistics for the threads registered with G8RTOS_SetPeriodic
+ */
+static thread_timing_t threadTimings[MAX_PERIODIC_THREADS];
+#endif
+
+/* Everything the kernel allocates statically has to fit the RAM budget */
+G8RTOS_STATIC_ASSERT(sizeof(ramVectorTable) + sizeof(threadControlBlocks) + sizeof(threadStacks)
+#if G8RTOS_USE_PTHREADS
+                     + sizeof(periodicThreadControlBlocks)
+#endif
+#if G8RTOS_USE_TIMING
+                     + sizeof(threadTimings)
+#endif
+                     + MAX_RWLOCKS * sizeof(rwlock_t*)
+#if G8RTOS_USE_FIFOS
+                     + MAX_NUMBER_OF_FIFOS * FIFO_CONTROL_BYTES + NUMBER_OF_INDEXED_FIFOS * FIFO_SIZE * sizeof(int32_t)
+#endif
+#if G8RTOS_USE_COROUTINES
+                     + MAX_COROUTINES * sizeof(coroutine_t)
+#endif
+#if G8RTOS_USE_PROFILER
+                     + PROFILER_SAMPLES * sizeof(profiler_sample_t)
+#endif
+#if G8RTOS_USE_RAMFUNCS
+                     + G8RTOS_RAMFUNC_BYTES
+#endif
+                     <= G8RTOS_RAM_BUDGET, kernel_ram_budget);
 
 /*********************************************** Data Structures Used *****************************************************************/
 
@@ -65,21 +112,72 @@ static ptcb_t periodicThreadControlBlocks[MAX_PTHREADS];
  */
 static uint32_t NumberOfThreads;
 
+#if G8RTOS_USE_PTHREADS
 /*
  * Current Number of Periodic Threads currently in the scheduler
  */
 static uint32_t NumberOfPThreads;
+#endif
 
 /*
  * Counter used to generate unique thread IDs
  */
 static uint16_t IDCounter;
 
+/*
+ * Ticks left in the running thread's round-robin quantum
+ */
+static uint32_t TimeSliceRemaining;
+
+#if G8RTOS_USE_TIMING
+/*
+ * DWT cycles per microsecond, used to convert timing measurements
+ */
+static uint32_t CyclesPerUs;
+#endif
+
+#if G8RTOS_USE_BENCHMARK
+/*
+ * Fastest and slowest SysTick_Handler in cycles, and the ticks measured
+ */
+static uint32_t SysTickCyclesMin;
+static uint32_t SysTickCyclesMax;
+static uint32_t SysTickCount;
+#endif
+
+/*
+ * Signalled by the LCD DMA interrupt when a transfer completes
+ */
+static semaphore_t LCDTransferDone;
+
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+/*
+ * Counts periodic event releases the dispatch thread has not run yet
+ */
+static semaphore_t PeriodicEventsDue;
+
+/*
+ * Thread ID of the periodic event dispatch thread
+ */
+static threadId_t PeriodicDispatchThreadId;
+#endif
+
 /*********************************************** Private Variables ********************************************************************/
 
 
 /*********************************************** Private Functions ********************************************************************/
 
+#if G8RTOS_USE_RAMFUNCS
+/* The tick and scheduling hot path runs from SRAM (the context switch and critical sections do too, in asm) */
+#pragma CODE_SECTION(IsReady, ".TI.ramfunc")
+#pragma CODE_SECTION(SchedulingPriority, ".TI.ramfunc")
+#pragma CODE_SECTION(PreemptionThreshold, ".TI.ramfunc")
+#pragma CODE_SECTION(ReplenishBudget, ".TI.ramfunc")
+#pragma CODE_SECTION(G8RTOS_Scheduler, ".TI.ramfunc")
+#pragma CODE_SECTION(SysTick_Handler, ".TI.ramfunc")
+#pragma CODE_SECTION(G8RTOS_Yield, ".TI.ramfunc")
+#endif
+
 /*
  * Initializes the Systick and Systick Interrupt
  * The Systick interrupt will be responsible for starting a context switch between threads
@@ -94,8 +192,244 @@ static void InitSysTick()
                      SysTick_CTRL_ENABLE_Msk;
 }
 
+/*
+ * LCD DMA hooks: the thread drawing blocks while the transfer runs
+ */
+static void WaitLCDTransfer()
+{
+    G8RTOS_WaitSemaphore(&LCDTransferDone);
+}
+
+static void SignalLCDTransfer()
+{
+    G8RTOS_SignalSemaphore(&LCDTransferDone);
+}
+
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+/*
+ * Periodic Event Dispatch Thread
+ * Runs the handler of every periodic event released by the SysTick handler,
+ * so long handlers run at thread level instead of delaying the tick
+ */
+static void PeriodicEventDispatcher()
+{
+    ptcb_t* pthread = &periodicThreadControlBlocks[0];
+
+    while (1)
+    {
+        // block until the SysTick handler releases a periodic event
+        G8RTOS_WaitSemaphore(&PeriodicEventsDue);
+
+        // find the next released periodic event (continuing round-robin)
+        while (pthread->pending == 0) pthread = pthread->next;
+
+        int32_t IBit_State = StartCriticalSection();
+        --pthread->pending;
+        EndCriticalSection(IBit_State);
+
+        // and execute the periodic task
+        (pthread->handler)();
+
+        pthread = pthread->next;
+    }
+}
+#endif
+
+/*
+ * Finds the TCB of a live thread
+ * Param threadId: thread to look up
+ * Returns: the thread's TCB, or NULL if it does not exist
+ */
+static tcb_t* FindThread(threadId_t threadId)
+{
+    if (TCB_INDEX(threadId) >= MAX_THREADS) return NULL;
+
+    tcb_t* thread = &threadControlBlocks[TCB_INDEX(threadId)];
+    if (!thread->alive || thread->thread_id != threadId) return NULL;
+
+    return thread;
+}
+
+/*
+ * Puts the "fake context" a thread starts from on top of its stack
+ * Param tcbIndex: index of the thread's TCB and stack
+ * Param entry: function the thread starts in
+ */
+static void InitThreadContext(int tcbIndex, void (*entry)(void))
+{
+    // Sets stack tcb stack pointer to top of thread stack
+#if G8RTOS_USE_FPU
+    // (below the registers sits the EXC_RETURN the context switch returns through)
+    threadControlBlocks[tcbIndex].sp = &threadStacks[tcbIndex][STACK_SIZE-17];
+#else
+    threadControlBlocks[tcbIndex].sp = &threadStacks[tcbIndex][STACK_SIZE-16];
+#endif
+
+    // Initializes the stack for the provided thread to hold a "fake context"
+    threadStacks[tcbIndex][STACK_SIZE-1]  = THUMBBIT; // PSR
+    threadStacks[tcbIndex][STACK_SIZE-2]  = (int32_t)entry; // R15 (PC)
+    threadStacks[tcbIndex][STACK_SIZE-3]  = ZERO; // R14 (LR)
+    threadStacks[tcbIndex][STACK_SIZE-4]  = ZERO; // R12
+    threadStacks[tcbIndex][STACK_SIZE-5]  = ZERO; // R3
+    threadStacks[tcbIndex][STACK_SIZE-6]  = ZERO; // R2
+    threadStacks[tcbIndex][STACK_SIZE-7]  = ZERO; // R1
+    threadStacks[tcbIndex][STACK_SIZE-8]  = ZERO; // R0
+    threadStacks[tcbIndex][STACK_SIZE-9]  = ZERO; // R11
+    threadStacks[tcbIndex][STACK_SIZE-10] = ZERO; // R10
+    threadStacks[tcbIndex][STACK_SIZE-11] = ZERO; // R9
+    threadStacks[tcbIndex][STACK_SIZE-12] = ZERO; // R8
+    threadStacks[tcbIndex][STACK_SIZE-13] = ZERO; // R7
+    threadStacks[tcbIndex][STACK_SIZE-14] = ZERO; // R6
+    threadStacks[tcbIndex][STACK_SIZE-15] = ZERO; // R5
+    threadStacks[tcbIndex][STACK_SIZE-16] = ZERO; // R4
+#if G8RTOS_USE_FPU
+    threadStacks[tcbIndex][STACK_SIZE-17] = EXC_RETURN_THREAD_MSP; // EXC_RETURN
+#endif
+}
+
+/*
+ * Gives back everything a thread waits on or holds, before it is killed or restarted.
+ * Must be called inside a critical section.
+ * Param thread: thread to release
+ */
+static void ReleaseThread(tcb_t* thread)
+{
+    // A thread blocked gives back what it was waiting on
+    G8RTOS_CancelWait(thread);
+
+    // and the reader-writer locks it holds
+    G8RTOS_ReleaseLocks(thread);
+
+#if G8RTOS_USE_TIMING
+    // A periodic thread gives back its timing statistics
+    if (thread->timing != NULL)
+    {
+        thread->timing->in_use = false;
+        thread->timing = NULL;
+    }
+#endif
+}
+
+/*
+ * Takes a live thread out of the scheduler. Must be called inside a critical section.
+ * Param thread: thread to remove
+ * Param exit_code: exit code handed to the threads joining it
+ */
+static void RemoveThread(tcb_t* thread, int32_t exit_code)
+{
+    ReleaseThread(thread);
+
+    // Set the threads isAlive bit to false
+    thread->alive = false;
+    thread->exit_code = exit_code;
+
+    // Update thread pointers
+    thread->next->prev = thread->prev;
+    thread->prev->next = thread->next;
+
+    // If thread being killed is the currently running thread, we need to context switch
+    if (thread == CurrentlyRunningThread)
+    {
+        G8RTOS_Yield();
+    }
+
+    // Decrement number of threads
+    --NumberOfThreads;
+}
+
+/*
+ * Unblocks every thread joining a thread that has been removed, in one pass.
+ * Must be called inside a critical section, after the last RemoveThread.
+ */
+static void ReleaseJoiners()
+{
+    for (int i = 0; i < MAX_THREADS; ++i)
+    {
+        tcb_t* thread = &threadControlBlocks[i];
+        if (thread->alive && thread->joining != NULL && !thread->joining->alive)
+        {
+            thread->join_exit_code = thread->joining->exit_code;
+            thread->joining = NULL;
+            thread->blocked = NULL;
+        }
+    }
+}
+
+/*
+ * Whether a thread belongs to the kernel, and is left alone by bulk kills
+ */
+static bool IsKernelThread(tcb_t* thread)
+{
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+    // The periodic event dispatch thread belongs to the kernel
+    return NumberOfPThreads > 0 && thread->thread_id == PeriodicDispatchThreadId;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Returns true if a thread can be chosen to run
+ */
+static bool IsReady(tcb_t* thread)
+{
+    return thread->alive && !thread->asleep && thread->blocked == NULL &&
+           !(thread->throttled && thread->budget_policy == BUDGET_SUSPEND);
+}
+
+/*
+ * Returns the priority a thread is scheduled at, taking a used up budget into account
+ */
+static uint8_t SchedulingPriority(tcb_t* thread)
+{
+    return thread->throttled ? BUDGET_DEMOTED_PRIORITY : thread->priority;
+}
+
+/*
+ * Returns the priority a ready thread has to be above (a lower value) to preempt a running thread
+ *  - An inherited priority above the threshold also raises the threshold
+ *  - A throttled thread has no threshold
+ */
+static uint8_t PreemptionThreshold(tcb_t* thread)
+{
+    uint8_t priority = SchedulingPriority(thread);
+    uint8_t threshold = thread->throttled ? priority : thread->preempt_threshold;
+    return (priority < threshold) ? priority : threshold;
+}
+
+/*
+ * Returns true if a ready thread outranks the CRT's preemption threshold
+ */
+static bool PreemptionDue()
+{
+    uint8_t threshold = PreemptionThreshold(CurrentlyRunningThread);
+
+    for (tcb_t* thread = CurrentlyRunningThread->next; thread != CurrentlyRunningThread; thread = thread->next)
+    {
+        if (IsReady(thread) && SchedulingPriority(thread) < threshold) return true;
+    }
+    return false;
+}
+
+/*
+ * Gives a thread its full budget back if its replenishment period is up
+ */
+static void ReplenishBudget(tcb_t* thread)
+{
+    if (thread->budget != 0 && (int32_t)(SystemTime - thread->budget_replenish_time) >= 0)
+    {
+        thread->budget_remaining = thread->budget;
+        thread->budget_replenish_time += thread->budget_period;
+        thread->throttled = false;
+    }
+}
+
 /*
  * Chooses the next thread to run.
+ *  - Runs when the CRT blocks, sleeps, dies or yields, or when a preemption is
+ *    due (SysTick_Handler and G8RTOS_SetPriority only pend it once a ready thread
+ *    outranks the preemption threshold or the quantum ran out), so the highest
+ *    priority ready thread is always the right choice
  */
 void G8RTOS_Scheduler()
 {
@@ -104,32 +438,51 @@ void G8RTOS_Scheduler()
      * other threads */
     tcb_t* tempNextThread = CurrentlyRunningThread->next;
     int currentMaxPriority = 256;
+
+    // An I/O boost lasts until the boosted thread blocks or sleeps
+    if (CurrentlyRunningThread->io_boosted && !IsReady(CurrentlyRunningThread))
+    {
+        CurrentlyRunningThread->io_boosted = false;
+        CurrentlyRunningThread->priority = CurrentlyRunningThread->base_priority;
+    }
     for (int i = 0; i < NumberOfThreads; ++i, tempNextThread = tempNextThread->next)
     {
-        /* If tempNextThread is neither sleeping or blocked, we check if its
+        /* If tempNextThread is neither sleeping, blocked or suspended, we check if its
          * priority value is less than a currentMaxPriority value (initial
          * currentMaxPriority value will be 256) */
-        if (tempNextThread->alive && !tempNextThread->asleep && tempNextThread->blocked == NULL && tempNextThread->priority < currentMaxPriority)
+        if (IsReady(tempNextThread) && SchedulingPriority(tempNextThread) < currentMaxPriority)
         {
             /* If it is, we set the CurrentlyRunningThread equal to the thread with the
              *  higher priority, and reinitialize the currentMaxPriority */
             CurrentlyRunningThread = tempNextThread;
-            currentMaxPriority = tempNextThread->priority;
+            currentMaxPriority = SchedulingPriority(tempNextThread);
         }
     }
+
+    // whoever was chosen starts a fresh quantum
+    TimeSliceRemaining = CurrentlyRunningThread->time_slice;
 }
 
 /*
  * SysTick Handler
  * The Systick Handler now will increment the system time,
- * set the PendSV flag to start the scheduler,
+ * set the PendSV flag to start the scheduler (only when a ready thread
+ * outranks the running one's preemption threshold or its round-robin
+ * quantum has expired),
  * and be responsible for handling sleeping and periodic threads
+ * (periodic threads are released to the dispatch thread when
+ * PERIODIC_DISPATCH_THREAD is set)
  */
 void SysTick_Handler()
 {
+#if G8RTOS_USE_BENCHMARK
+    uint32_t startCycles = DWT->CYCCNT;
+#endif
+
     // increment the system time
     ++SystemTime;
 
+#if G8RTOS_USE_PTHREADS
     // handle periodic threads if they exist
     if (NumberOfPThreads > 0)
     {
@@ -144,11 +497,38 @@ void SysTick_Handler()
                 // update the exec_time to the next time it should execute
                 pthread->exec_time = SystemTime + pthread->period;
 
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+                // and release the periodic task to the dispatch thread
+                ++pthread->pending;
+                G8RTOS_SignalSemaphore(&PeriodicEventsDue);
+#else
                 // and execute the periodic task
                 (pthread->handler)();
+#endif
             }
         }
     }
+#endif
+
+    // the round-robin quantum only lets threads under the preemption threshold take a turn once it runs out
+    // (a time slice of 0 never runs out)
+    bool sliceExpired = false;
+    if (CurrentlyRunningThread->time_slice != 0)
+    {
+        sliceExpired = (TimeSliceRemaining <= 1);
+        if (!sliceExpired) --TimeSliceRemaining;
+    }
+
+    /* charge the running thread for the tick it just ran, in the budget period it ran in
+     * (the loop below starts the next one), throttling it once its budget is used up */
+    if (CurrentlyRunningThread->budget != 0 && !CurrentlyRunningThread->throttled && --CurrentlyRunningThread->budget_remaining == 0)
+    {
+        CurrentlyRunningThread->throttled = true;
+        ++CurrentlyRunningThread->budget_overruns;
+    }
+
+    // the most urgent priority among the other ready threads (past any priority if none is ready)
+    uint16_t readyPriority = UINT8_MAX + 1;
 
     // wake up our sleeping threads if necessary
     // start the pointer at the current thread
@@ -161,11 +541,49 @@ void SysTick_Handler()
 
             // wake it up
             thread->asleep = false;
+
+#if G8RTOS_USE_TIMING
+            // a periodic thread waking for its next job is released now
+            if (thread->timing != NULL && thread->timing->awaiting_release)
+            {
+                thread->timing->release_cycles = DWT->CYCCNT;
+            }
+#endif
+        }
+
+        // give back budgets whose period is up, once per thread and tick
+        ReplenishBudget(thread);
+
+        if (thread != CurrentlyRunningThread && IsReady(thread) && SchedulingPriority(thread) < readyPriority)
+        {
+            readyPriority = SchedulingPriority(thread);
         }
     }
 
-    // yield the CPU preemptively
-    G8RTOS_Yield();
+    /* a switch is needed if the running thread can no longer run, or if another
+     * ready thread (woken here, or unblocked since the last tick) outranks the
+     * running thread's preemption threshold, or at least ties with its priority
+     * once its quantum is used up */
+    bool switchNeeded = !IsReady(CurrentlyRunningThread) ||
+                        readyPriority < PreemptionThreshold(CurrentlyRunningThread) ||
+                        (sliceExpired && readyPriority <= SchedulingPriority(CurrentlyRunningThread));
+
+    // yield the CPU preemptively only if the scheduler could pick another thread
+    if (switchNeeded)
+    {
+        G8RTOS_Yield();
+    }
+    else
+    {
+        ++AvoidedContextSwitches;
+    }
+
+#if G8RTOS_USE_BENCHMARK
+    uint32_t cycles = DWT->CYCCNT - startCycles;
+    if (cycles < SysTickCyclesMin) SysTickCyclesMin = cycles;
+    if (cycles > SysTickCyclesMax) SysTickCyclesMax = cycles;
+    ++SysTickCount;
+#endif
 }
 
 /*********************************************** Private Functions ********************************************************************/
@@ -176,6 +594,12 @@ void SysTick_Handler()
 /* Holds the current time for the whole System */
 uint32_t SystemTime;
 
+/* Counts context switches skipped because the scheduling choice could not change */
+uint32_t AvoidedContextSwitches;
+
+/* Counts context switches PendSV actually performed */
+uint32_t ContextSwitches;
+
 /*********************************************** Public Variables *********************************************************************/
 
 
@@ -190,23 +614,51 @@ void G8RTOS_Init(bool LCD_usingTP, playerType wifi_hostOrClient)
     // Initialize system time, number of threads, and ID counter to zero
     SystemTime = 0;
     NumberOfThreads = 0;
+#if G8RTOS_USE_PTHREADS
     NumberOfPThreads = 0;
+#endif
     IDCounter = 0;
+    TimeSliceRemaining = TIME_SLICE_TICKS;
+    AvoidedContextSwitches = 0;
+    ContextSwitches = 0;
+#if G8RTOS_USE_BENCHMARK
+    SysTickCyclesMin = UINT32_MAX;
+    SysTickCyclesMax = 0;
+    SysTickCount = 0;
+#endif
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+    G8RTOS_InitSemaphore(&PeriodicEventsDue, 0);
+#endif
+    G8RTOS_InitSemaphore(&LCDTransferDone, 0);
 
     // Relocate the VTOR table to SRAM
-    uint32_t newVTORTable = 0x20000000;
     // 57 interrupt vectors to copy
-    memcpy((uint32_t *)newVTORTable, (uint32_t *)SCB->VTOR, 57*4);
-    SCB->VTOR = newVTORTable;
+    memcpy(ramVectorTable, (uint32_t *)SCB->VTOR, sizeof(ramVectorTable));
+    SCB->VTOR = (uint32_t)ramVectorTable;
 
     // Initialize all hardware on the board
     BSP_InitBoard(LCD_usingTP, wifi_hostOrClient);
+
+    // Start the DWT cycle counter used for timing measurements
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if !G8RTOS_USE_FPU
+    // The context switch does not save FPU registers, so keep exception frames the basic size
+    FPU->FPCCR &= ~(FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk);
+#endif
+#if G8RTOS_USE_TIMING
+    CyclesPerUs = ClockSys_GetSysFreq() / 1000000;
+#endif
 }
 
 /*
  * Starts G8RTOS Scheduler
  * 	- Initializes the SysTick
  * 	- Sets the priority of the SysTick and the PendSV interrupts
+ * 	- Makes LCD DMA transfers block the drawing thread on a semaphore
+ * 	- Charges bus traffic to the thread that makes it
  * 	- Sets context to first thread to run (the one with the highest priority)
  * 	- Calls G8RTOS Start to initiate the first context switch and begin exec.
  * Returns: Error Code for starting scheduler. This will only return if the scheduler fails
@@ -234,6 +686,12 @@ G8RTOS_Scheduler_Error G8RTOS_Launch()
     __NVIC_SetPriority(PendSV_IRQn, PENDSV_PRIORITY);
     __NVIC_SetPriority(SysTick_IRQn, SYSTICK_PRIORITY);
 
+    // From here on LCD DMA transfers block the drawing thread instead of spinning
+    LCD_SetDMAHooks(WaitLCDTransfer, SignalLCDTransfer);
+
+    // Bus traffic counted from here on is charged to the running thread
+    BusStats_SetThreadHook(G8RTOS_GetThreadId);
+
     // Call G8RTOS_Start
     G8RTOS_Start();
 
@@ -254,6 +712,25 @@ G8RTOS_Scheduler_Error G8RTOS_Launch()
  */
 G8RTOS_Scheduler_Error G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t priority, char* thread_name)
 {
+    return G8RTOS_AddThreadEx(threadToAdd, priority, priority, TIME_SLICE_TICKS, thread_name, NULL);
+}
+
+/*
+ * Adds threads to G8RTOS Scheduler with their own preemption threshold and time slice
+ * Param threadToAdd: Void-Void Function to add as preemptable main thread
+ * Param priority: Priority of the thread that is being added. 0 is the
+ *                   highest and 255 is the lowest priority.
+ * Param preempt_threshold: only threads with a priority value below this preempt the
+ *                   thread before its time slice is used up. Must be at most "priority".
+ * Param time_slice: round-robin quantum in ticks, 0 to run until the thread blocks or sleeps
+ * Param thread_name: the name of the thread, helpful when debugging.
+ * Param threadId: where the new thread's id is written, may be NULL
+ * Returns: Error code for adding threads
+ */
+G8RTOS_Scheduler_Error G8RTOS_AddThreadEx(void (*threadToAdd)(void), uint8_t priority, uint8_t preempt_threshold, uint32_t time_slice, char* thread_name, threadId_t* threadId)
+{
+    if (preempt_threshold > priority) return PREEMPT_THRESHOLD_INVALID;
+
     int32_t IBit_State = StartCriticalSection();
 
     // Checks if there are still available threads to insert to scheduler
@@ -312,33 +789,32 @@ G8RTOS_Scheduler_Error G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t prior
         }
     }
 
-    // Sets stack tcb stack pointer to top of thread stack
-    threadControlBlocks[tcbToInitialize].sp = &threadStacks[tcbToInitialize][STACK_SIZE-16];
-
-    // Initializes the stack for the provided thread to hold a "fake context"
-    threadStacks[tcbToInitialize][STACK_SIZE-1]  = THUMBBIT; // PSR
-    threadStacks[tcbToInitialize][STACK_SIZE-2]  = (int32_t)threadToAdd; // R15 (PC)
-    threadStacks[tcbToInitialize][STACK_SIZE-3]  = ZERO; // R14 (LR)
-    threadStacks[tcbToInitialize][STACK_SIZE-4]  = ZERO; // R12
-    threadStacks[tcbToInitialize][STACK_SIZE-5]  = ZERO; // R3
-    threadStacks[tcbToInitialize][STACK_SIZE-6]  = ZERO; // R2
-    threadStacks[tcbToInitialize][STACK_SIZE-7]  = ZERO; // R1
-    threadStacks[tcbToInitialize][STACK_SIZE-8]  = ZERO; // R0
-    threadStacks[tcbToInitialize][STACK_SIZE-9]  = ZERO; // R11
-    threadStacks[tcbToInitialize][STACK_SIZE-10] = ZERO; // R10
-    threadStacks[tcbToInitialize][STACK_SIZE-11] = ZERO; // R9
-    threadStacks[tcbToInitialize][STACK_SIZE-12] = ZERO; // R8
-    threadStacks[tcbToInitialize][STACK_SIZE-13] = ZERO; // R7
-    threadStacks[tcbToInitialize][STACK_SIZE-14] = ZERO; // R6
-    threadStacks[tcbToInitialize][STACK_SIZE-15] = ZERO; // R5
-    threadStacks[tcbToInitialize][STACK_SIZE-16] = ZERO; // R4
+    // Give the thread the context it starts from
+    InitThreadContext(tcbToInitialize, threadToAdd);
 
     threadControlBlocks[tcbToInitialize].priority = priority;
+    threadControlBlocks[tcbToInitialize].base_priority = priority;
+    threadControlBlocks[tcbToInitialize].preempt_threshold = preempt_threshold;
+    threadControlBlocks[tcbToInitialize].time_slice = time_slice;
+    threadControlBlocks[tcbToInitialize].budget = 0;
+    threadControlBlocks[tcbToInitialize].budget_overruns = 0;
+    threadControlBlocks[tcbToInitialize].throttled = false;
+#if G8RTOS_USE_TIMING
+    threadControlBlocks[tcbToInitialize].timing = NULL;
+#endif
+    threadControlBlocks[tcbToInitialize].io_boost = false;
+    threadControlBlocks[tcbToInitialize].io_boosted = false;
     threadControlBlocks[tcbToInitialize].alive = true;
     threadControlBlocks[tcbToInitialize].asleep = false;
     threadControlBlocks[tcbToInitialize].blocked = NULL;
+    threadControlBlocks[tcbToInitialize].waiting_lock = NULL;
+    threadControlBlocks[tcbToInitialize].entry = threadToAdd;
+    threadControlBlocks[tcbToInitialize].group = (CurrentlyRunningThread == NULL) ? THREAD_GROUP_NONE : CurrentlyRunningThread->group;
+    threadControlBlocks[tcbToInitialize].exit_code = 0;
+    threadControlBlocks[tcbToInitialize].joining = NULL;
     threadControlBlocks[tcbToInitialize].thread_id = ((IDCounter++) << 16) | tcbToInitialize;
     strcpy(threadControlBlocks[tcbToInitialize].thread_name, thread_name);
+    if (threadId != NULL) *threadId = threadControlBlocks[tcbToInitialize].thread_id;
 
     ++NumberOfThreads;
 
@@ -346,6 +822,7 @@ G8RTOS_Scheduler_Error G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t prior
     return SCHEDULER_NO_ERROR;
 }
 
+#if G8RTOS_USE_PTHREADS
 /*
  * Adds periodic threads to G8RTOS Scheduler
  * Function will initialize a periodic event struct to represent event.
@@ -367,6 +844,18 @@ G8RTOS_Scheduler_Error G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint3
 
     if (NumberOfPThreads == 0)
     {
+#if G8RTOS_USE_PTHREADS && PERIODIC_DISPATCH_THREAD
+        // The first periodic event also brings up the thread that runs them
+        // and remembers it, so KillAllOtherThreads leaves it alone
+        if (G8RTOS_AddThreadEx(&PeriodicEventDispatcher, PERIODIC_DISPATCH_PRIORITY, PERIODIC_DISPATCH_PRIORITY,
+                               TIME_SLICE_TICKS, "pthread dispatch", &PeriodicDispatchThreadId) != SCHEDULER_NO_ERROR)
+        {
+            EndCriticalSection(IBit_State);
+            return THREAD_LIMIT_REACHED;
+        }
+        FindThread(PeriodicDispatchThreadId)->group = THREAD_GROUP_NONE;
+#endif
+
         // If this is the first thread, point it to itself
         periodicThreadControlBlocks[NumberOfPThreads].prev = &periodicThreadControlBlocks[NumberOfPThreads];
         periodicThreadControlBlocks[NumberOfPThreads].next = &periodicThreadControlBlocks[NumberOfPThreads];
@@ -385,12 +874,14 @@ G8RTOS_Scheduler_Error G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint3
     periodicThreadControlBlocks[NumberOfPThreads].handler = PthreadToAdd;
     periodicThreadControlBlocks[NumberOfPThreads].exec_time = SystemTime + period;
     periodicThreadControlBlocks[NumberOfPThreads].period = period;
+    periodicThreadControlBlocks[NumberOfPThreads].pending = 0;
 
     ++NumberOfPThreads;
 
     EndCriticalSection(IBit_State);
     return SCHEDULER_NO_ERROR;
 }
+#endif
 
 /*
  * Puts the current thread into a sleep state.
@@ -427,64 +918,603 @@ threadId_t G8RTOS_GetThreadId()
 }
 
 /*
- * Kill all threads, except for the CRT.
+ * Returns the name of a thread, or NULL if it does not exist
  */
-void G8RTOS_KillAllOtherThreads()
+const char* G8RTOS_GetThreadName(threadId_t threadId)
 {
-    for (int i = 0; i < MAX_THREADS; ++i)
+    tcb_t* thread = FindThread(threadId);
+    return (thread == NULL) ? NULL : thread->thread_name;
+}
+
+/*
+ * Changes the priority of a thread
+ * Param threadId: thread to change
+ * Param priority: new priority, 0 is the highest and 255 the lowest
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPriority(threadId_t threadId, uint8_t priority)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
     {
-        if (&threadControlBlocks[i] != CurrentlyRunningThread) G8RTOS_KillThread(threadControlBlocks[i].thread_id);
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
     }
+
+    // Keep a threshold that tracked the old priority in step, and never below the new one
+    if (thread->preempt_threshold == thread->base_priority || thread->preempt_threshold > priority)
+    {
+        thread->preempt_threshold = priority;
+    }
+
+    // An inherited or boosted priority stays if it is still higher than the new one
+    bool raised = (thread->priority < thread->base_priority);
+    thread->base_priority = priority;
+    if (!raised || priority < thread->priority) thread->priority = priority;
+
+    /* There are no run queues to move the thread between: the scheduler and
+     * G8RTOS_SignalSemaphore pick threads by priority on every decision, so
+     * rescheduling is all that is needed for the change to take effect, and
+     * only if a ready thread now outranks the CRT's preemption threshold */
+    if (PreemptionDue()) G8RTOS_Yield();
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
 }
 
 /*
- * Kill the thread with id threadId.
+ * Gets the priority a thread was given (without any inherited or boosted priority)
+ * Param threadId: thread to query
+ * Param priority: where the priority is written
+ * Returns: Error code
  */
-G8RTOS_Scheduler_Error G8RTOS_KillThread(threadId_t threadId)
+G8RTOS_Scheduler_Error G8RTOS_GetPriority(threadId_t threadId, uint8_t* priority)
+{
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL) return THREAD_DOES_NOT_EXIST;
+
+    *priority = thread->base_priority;
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Boosts a thread whenever an interrupt handler wakes it through a semaphore (an I/O completion)
+ * Param threadId: thread to change
+ * Param enable: true to turn the boost on, false to turn it off
+ * Param boost_priority: priority the thread is boosted to
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetIOBoost(threadId_t threadId, bool enable, uint8_t boost_priority)
 {
-    // Enter a critical section
     int32_t IBit_State = StartCriticalSection();
 
-    // Return appropriate error code if there’s only one thread running
-    if (NumberOfThreads == 1)
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
     {
         EndCriticalSection(IBit_State);
-        return CANNOT_KILL_LAST_THREAD;
+        return THREAD_DOES_NOT_EXIST;
+    }
+
+    thread->io_boost = enable;
+    thread->io_boost_priority = boost_priority;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Changes the preemption threshold of a thread
+ * Param threadId: thread to change
+ * Param preempt_threshold: new threshold, at most the thread's priority
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPreemptThreshold(threadId_t threadId, uint8_t preempt_threshold)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
+    }
+
+    if (preempt_threshold > thread->base_priority)
+    {
+        EndCriticalSection(IBit_State);
+        return PREEMPT_THRESHOLD_INVALID;
+    }
+
+    thread->preempt_threshold = preempt_threshold;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Changes the round-robin time slice of a thread
+ *  - Takes effect the next time the thread is scheduled
+ * Param threadId: thread to change
+ * Param time_slice: quantum in ticks, 0 to run until the thread blocks or sleeps
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetTimeSlice(threadId_t threadId, uint32_t time_slice)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
     }
 
-    // Search for thread with the same threadId
-    int thread_to_kill = -1;
+    thread->time_slice = time_slice;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Gives a thread a CPU budget, replenished every period
+ * Param threadId: thread to limit
+ * Param budget: ticks the thread may run per period, 0 to remove the budget
+ * Param period: replenishment period in ticks, at least "budget"
+ * Param policy: what to do with the thread while it is over budget
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetBudget(threadId_t threadId, uint32_t budget, uint32_t period, G8RTOS_Budget_Policy policy)
+{
+    if (budget > period) return BUDGET_INVALID;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
+    }
+
+    // the first period starts now
+    thread->budget = budget;
+    thread->budget_period = period;
+    thread->budget_remaining = budget;
+    thread->budget_replenish_time = SystemTime + period;
+    thread->budget_policy = policy;
+    thread->throttled = false;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Returns the number of times a thread used up its CPU budget (0 if it does not exist)
+ */
+uint32_t G8RTOS_GetBudgetOverruns(threadId_t threadId)
+{
+    tcb_t* thread = FindThread(threadId);
+    return (thread == NULL) ? 0 : thread->budget_overruns;
+}
+
+#if G8RTOS_USE_TIMING
+/*
+ * Registers the CRT as periodic, starting its first job now
+ * Param period: time between releases in ms
+ * Param deadline: time after a release the job should be done by in ms
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPeriodic(uint32_t period, uint32_t deadline)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    // Reuse the thread's statistics if it registers again, otherwise take a free entry
+    thread_timing_t* timing = CurrentlyRunningThread->timing;
+    for (int i = 0; timing == NULL && i < MAX_PERIODIC_THREADS; ++i)
+    {
+        if (!threadTimings[i].in_use) timing = &threadTimings[i];
+    }
+
+    if (timing == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return PERIODIC_LIMIT_REACHED;
+    }
+
+    memset(timing, 0, sizeof(thread_timing_t));
+    timing->in_use = true;
+    timing->period = period;
+    timing->deadline = deadline;
+    timing->response_min_us = UINT32_MAX;
+    timing->next_release = SystemTime + period;
+    timing->release_cycles = DWT->CYCCNT;
+    CurrentlyRunningThread->timing = timing;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Ends the CRT's current job and sleeps until its next release
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_WaitForNextPeriod()
+{
+    uint32_t completion_cycles = DWT->CYCCNT;
+    thread_timing_t* timing = CurrentlyRunningThread->timing;
+
+    if (timing == NULL) return THREAD_NOT_PERIODIC;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    // Record the response time of the job that just finished
+    uint32_t response_us = (completion_cycles - timing->release_cycles) / CyclesPerUs;
+    uint32_t deadline_us = timing->deadline * 1000;
+
+    ++timing->jobs;
+    timing->response_total_us += response_us;
+    if (response_us < timing->response_min_us) timing->response_min_us = response_us;
+    if (response_us > timing->response_max_us) timing->response_max_us = response_us;
+    if (response_us > deadline_us) ++timing->deadline_misses;
+
+    // Bins split the deadline evenly, the last one catches everything at or past it
+    uint32_t bin = (deadline_us == 0) ? (TIMING_HISTOGRAM_BINS - 1) : (uint32_t)(((uint64_t)response_us * (TIMING_HISTOGRAM_BINS - 1)) / deadline_us);
+    if (bin > TIMING_HISTOGRAM_BINS - 1) bin = TIMING_HISTOGRAM_BINS - 1;
+    ++timing->response_histogram[bin];
+
+    // A job that ran past its next release starts the next one right away
+    if ((int32_t)(timing->next_release - SystemTime) <= 0)
+    {
+        timing->next_release = SystemTime + timing->period;
+        timing->release_cycles = completion_cycles;
+
+        EndCriticalSection(IBit_State);
+        return SCHEDULER_NO_ERROR;
+    }
+
+    // Otherwise sleep until the release, SysTick timestamps it when waking the thread
+    CurrentlyRunningThread->sleep_cnt = timing->next_release;
+    CurrentlyRunningThread->asleep = true;
+    timing->awaiting_release = true;
+    timing->next_release += timing->period;
+
+    EndCriticalSection(IBit_State);
+    G8RTOS_Yield();
+
+    // Running again, so the release jitter is the time since SysTick woke us
+    IBit_State = StartCriticalSection();
+
+    uint32_t jitter_us = (DWT->CYCCNT - timing->release_cycles) / CyclesPerUs;
+    timing->awaiting_release = false;
+    ++timing->jitter_samples;
+    timing->jitter_total_us += jitter_us;
+    if (jitter_us > timing->jitter_max_us) timing->jitter_max_us = jitter_us;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Copies the timing statistics of a periodic thread
+ * Param threadId: periodic thread to query
+ * Param timing: where the statistics are copied to
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_GetThreadTiming(threadId_t threadId, thread_timing_t* timing)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL || thread->timing == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return (thread == NULL) ? THREAD_DOES_NOT_EXIST : THREAD_NOT_PERIODIC;
+    }
+
+    *timing = *thread->timing;
+
+    EndCriticalSection(IBit_State);
+
+    // Averages are only worked out when asked for
+    if (timing->jobs > 0) timing->response_avg_us = (uint32_t)(timing->response_total_us / timing->jobs);
+    if (timing->jitter_samples > 0) timing->jitter_avg_us = (uint32_t)(timing->jitter_total_us / timing->jitter_samples);
+
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Clears the statistics of a periodic thread, keeping its period and deadline
+ */
+G8RTOS_Scheduler_Error G8RTOS_ResetThreadTiming(threadId_t threadId)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL || thread->timing == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return (thread == NULL) ? THREAD_DOES_NOT_EXIST : THREAD_NOT_PERIODIC;
+    }
+
+    thread_timing_t* timing = thread->timing;
+    timing->jobs = 0;
+    timing->deadline_misses = 0;
+    timing->jitter_samples = 0;
+    timing->jitter_max_us = 0;
+    timing->jitter_total_us = 0;
+    timing->response_min_us = UINT32_MAX;
+    timing->response_max_us = 0;
+    timing->response_total_us = 0;
+    memset(timing->response_histogram, 0, sizeof(timing->response_histogram));
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+#endif
+
+#if G8RTOS_USE_BENCHMARK
+/*
+ * Measures the cycle counts of the kernel hot path
+ * Param result: where the cycle counts are written
+ */
+void G8RTOS_KernelBenchmark(kernel_benchmark_t* result)
+{
+    // cost of reading the cycle counter twice, taken off every measurement
+    uint32_t overhead = UINT32_MAX;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        uint32_t start = DWT->CYCCNT;
+        uint32_t cycles = DWT->CYCCNT - start;
+        if (cycles < overhead) overhead = cycles;
+    }
+
+    result->critical_section = UINT32_MAX;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        uint32_t start = DWT->CYCCNT;
+        EndCriticalSection(StartCriticalSection());
+        uint32_t cycles = DWT->CYCCNT - start - overhead;
+        if (cycles < result->critical_section) result->critical_section = cycles;
+    }
+
+    semaphore_t semaphore;
+    G8RTOS_InitSemaphore(&semaphore, 1);
+    result->semaphore = UINT32_MAX;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        uint32_t start = DWT->CYCCNT;
+        G8RTOS_WaitSemaphore(&semaphore);
+        G8RTOS_SignalSemaphore(&semaphore);
+        uint32_t cycles = DWT->CYCCNT - start - overhead;
+        if (cycles < result->semaphore) result->semaphore = cycles;
+    }
+
+    // PendSV runs as soon as it is pended, only yields the scheduler kept this thread for count
+    result->yield = UINT32_MAX;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        uint32_t avoided = AvoidedContextSwitches;
+        uint32_t start = DWT->CYCCNT;
+        G8RTOS_Yield();
+        uint32_t cycles = DWT->CYCCNT - start - overhead;
+        if (AvoidedContextSwitches != avoided && cycles < result->yield) result->yield = cycles;
+    }
+
+    int32_t IBit_State = StartCriticalSection();
+    result->systick_min = SysTickCyclesMin;
+    result->systick_max = SysTickCyclesMax;
+    result->systick_ticks = SysTickCount;
+    EndCriticalSection(IBit_State);
+
+    result->ramfuncs = G8RTOS_USE_RAMFUNCS;
+}
+
+/*
+ * Thread that runs G8RTOS_KernelBenchmark once, prints it over the back channel UART and kills itself
+ */
+void G8RTOS_KernelBenchmarkThread()
+{
+    kernel_benchmark_t result;
+    G8RTOS_KernelBenchmark(&result);
+
+    BackChannelPrintIntVariable("bench_ramfuncs", result.ramfuncs);
+    BackChannelPrintIntVariable("bench_critical_section", result.critical_section);
+    BackChannelPrintIntVariable("bench_semaphore", result.semaphore);
+    BackChannelPrintIntVariable("bench_yield", result.yield);
+    BackChannelPrintIntVariable("bench_systick_min", result.systick_min);
+    BackChannelPrintIntVariable("bench_systick_max", result.systick_max);
+    BackChannelPrintIntVariable("bench_systick_ticks", result.systick_ticks);
+
+    G8RTOS_KillSelf();
+}
+#endif
+
+/*
+ * Moves a thread into a group
+ * Param threadId: thread to move
+ * Param group: new group, THREAD_GROUP_NONE to leave its group
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetThreadGroup(threadId_t threadId, threadGroup_t group)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = FindThread(threadId);
+    if (thread == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
+    }
+
+    thread->group = group;
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Kills every thread of a group except the CRT, in one pass over the TCBs
+ * Param group: group to kill
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_KillGroup(threadGroup_t group)
+{
+    if (group == THREAD_GROUP_NONE) return GROUP_INVALID;
+
+    int32_t IBit_State = StartCriticalSection();
+
     for (int i = 0; i < MAX_THREADS; ++i)
     {
-        if (threadControlBlocks[i].alive && threadControlBlocks[i].thread_id == threadId)
+        tcb_t* thread = &threadControlBlocks[i];
+        if (thread->alive && thread->group == group && thread != CurrentlyRunningThread && !IsKernelThread(thread))
         {
-            thread_to_kill = i;
-            break;
+            RemoveThread(thread, THREAD_EXIT_KILLED);
         }
     }
+    ReleaseJoiners();
 
-    // Return error code if the thread does not exist
-    if (thread_to_kill == -1)
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Restarts every thread of a group except the CRT from its entry function, in one pass over the TCBs
+ * Param group: group to restart
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_RestartGroup(threadGroup_t group)
+{
+    if (group == THREAD_GROUP_NONE) return GROUP_INVALID;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    for (int i = 0; i < MAX_THREADS; ++i)
+    {
+        tcb_t* thread = &threadControlBlocks[i];
+        if (thread->alive && thread->group == group && thread != CurrentlyRunningThread && !IsKernelThread(thread))
+        {
+            // the same release as a killed thread, then a fresh start
+            ReleaseThread(thread);
+            InitThreadContext(i, thread->entry);
+            thread->priority = thread->base_priority;
+            thread->io_boosted = false;
+            thread->throttled = false;
+            thread->budget_remaining = thread->budget;
+            thread->budget_replenish_time = SystemTime + thread->budget_period;
+            thread->budget_overruns = 0;
+            thread->asleep = false;
+        }
+    }
+
+    EndCriticalSection(IBit_State);
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Blocks until a thread exits or is killed
+ * Param threadId: thread to wait for
+ * Param exit_code: where its exit code is written, may be NULL
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_Join(threadId_t threadId, int32_t* exit_code)
+{
+    if (threadId == CurrentlyRunningThread->thread_id) return CANNOT_JOIN_SELF;
+    if (TCB_INDEX(threadId) >= MAX_THREADS) return THREAD_DOES_NOT_EXIST;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    tcb_t* thread = &threadControlBlocks[TCB_INDEX(threadId)];
+    if (thread->thread_id != threadId)
     {
         EndCriticalSection(IBit_State);
         return THREAD_DOES_NOT_EXIST;
     }
 
-    // Set the threads isAlive bit to false
-    threadControlBlocks[thread_to_kill].alive = false;
+    // already ended: its TCB still holds the exit code
+    if (!thread->alive)
+    {
+        if (exit_code != NULL) *exit_code = thread->exit_code;
+        EndCriticalSection(IBit_State);
+        return SCHEDULER_NO_ERROR;
+    }
 
-    // Update thread pointers
-    threadControlBlocks[thread_to_kill].next->prev = threadControlBlocks[thread_to_kill].prev;
-    threadControlBlocks[thread_to_kill].prev->next = threadControlBlocks[thread_to_kill].next;
+    // block on the thread's join gate, whoever removes it hands us the exit code
+    CurrentlyRunningThread->joining = thread;
+    CurrentlyRunningThread->blocked = &thread->join_gate;
+    G8RTOS_Yield();
 
-    // If thread being killed is the currently running thread, we need to context switch
-    if (threadControlBlocks[thread_to_kill].thread_id == CurrentlyRunningThread->thread_id)
+    EndCriticalSection(IBit_State);
+
+    if (exit_code != NULL) *exit_code = CurrentlyRunningThread->join_exit_code;
+    return SCHEDULER_NO_ERROR;
+}
+
+/*
+ * Ends the CRT with an exit code for the threads joining it
+ * Param exit_code: exit code passed to G8RTOS_Join
+ */
+void G8RTOS_Exit(int32_t exit_code)
+{
+    // Joiners tell a kill by THREAD_EXIT_KILLED, so it is never passed on from here
+    if (exit_code == THREAD_EXIT_KILLED) exit_code = THREAD_EXIT_KILLED + 1;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    RemoveThread(CurrentlyRunningThread, exit_code);
+    ReleaseJoiners();
+
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Kill all threads, except for the CRT (in one pass over the TCBs).
+ */
+void G8RTOS_KillAllOtherThreads()
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    for (int i = 0; i < MAX_THREADS; ++i)
     {
-        G8RTOS_Yield();
+        tcb_t* thread = &threadControlBlocks[i];
+        if (thread->alive && thread != CurrentlyRunningThread && !IsKernelThread(thread))
+        {
+            RemoveThread(thread, THREAD_EXIT_KILLED);
+        }
     }
+    ReleaseJoiners();
 
-    // Decrement number of threads
-    --NumberOfThreads;
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Kill the thread with id threadId.
+ */
+G8RTOS_Scheduler_Error G8RTOS_KillThread(threadId_t threadId)
+{
+    // Enter a critical section
+    int32_t IBit_State = StartCriticalSection();
+
+    // Return appropriate error code if there’s only one thread running
+    if (NumberOfThreads == 1)
+    {
+        EndCriticalSection(IBit_State);
+        return CANNOT_KILL_LAST_THREAD;
+    }
+
+    // The thread ID leads straight to its TCB
+    tcb_t* thread = FindThread(threadId);
+
+    // Return error code if the thread does not exist
+    if (thread == NULL)
+    {
+        EndCriticalSection(IBit_State);
+        return THREAD_DOES_NOT_EXIST;
+    }
+
+    RemoveThread(thread, (thread == CurrentlyRunningThread) ? 0 : THREAD_EXIT_KILLED);
+    ReleaseJoiners();
 
     // End critical section
     EndCriticalSection(IBit_State);
@@ -517,8 +1547,9 @@ G8RTOS_Scheduler_Error G8RTOS_AddAperiodicEvent(void (*AthreadToAdd)(void), uint
     }
 
     /* Verify priority is not greater than 6 (the greatest user priority
-     * number). */
-    if (priority > 6)
+     * number) and not above the kernel ceiling (an aperiodic event may call
+     * into the kernel, so critical sections must be able to mask it). */
+    if (priority > 6 || priority < KERNEL_CEILING_PRIORITY)
     {
         EndCriticalSection(IBit_State);
         return HWI_PRIORITY_INVALID;
@@ -6,19 +6,11 @@
 #define G8RTOS_SCHEDULER_H_
 
 #include "G8RTOS/G8RTOS.h"
+#include "G8RTOS_Config.h"
 #include "msp.h"
 #include "cc3100_usage.h"
 #include <stdbool.h>
 
-/*********************************************** Sizes and Limits *********************************************************************/
-#define MAX_THREADS 25
-#define MAX_PTHREADS 3
-#define STACK_SIZE 512
-#define PENDSV_PRIORITY 7
-#define SYSTICK_PRIORITY 7
-/*********************************************** Sizes and Limits *********************************************************************/
-
-
 /*********************************************** Enums ********************************************************************************/
 typedef enum G8RTOS_Scheduler_Error
 {
@@ -32,6 +24,12 @@ typedef enum G8RTOS_Scheduler_Error
     HWI_PRIORITY_INVALID = -7,
     PTHREAD_LIMIT_REACHED = -8,
     UNKNOWN_FAILURE = -9,
+    PREEMPT_THRESHOLD_INVALID = -10,
+    BUDGET_INVALID = -11,
+    PERIODIC_LIMIT_REACHED = -12,
+    THREAD_NOT_PERIODIC = -13,
+    GROUP_INVALID = -15,
+    CANNOT_JOIN_SELF = -16,
 } G8RTOS_Scheduler_Error;
 /*********************************************** Enums ********************************************************************************/
 
@@ -41,6 +39,13 @@ typedef enum G8RTOS_Scheduler_Error
 /* Holds the current time for the whole System */
 extern uint32_t SystemTime;
 
+/* Counts context switches skipped because the scheduling choice could not
+ * change (tick without a switch pended, or PendSV picking the same thread) */
+extern uint32_t AvoidedContextSwitches;
+
+/* Counts context switches PendSV actually performed */
+extern uint32_t ContextSwitches;
+
 /*********************************************** Public Variables *********************************************************************/
 
 
@@ -73,6 +78,22 @@ G8RTOS_Scheduler_Error G8RTOS_Launch();
  */
 G8RTOS_Scheduler_Error G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t priority, char* thread_name);
 
+/*
+ * Adds threads to G8RTOS Scheduler with their own preemption threshold and time slice
+ * Param threadToAdd: Void-Void Function to add as preemptable main thread
+ * Param priority: Priority of the thread that is being added. 0 is the
+ *                   highest and 255 is the lowest priority.
+ * Param preempt_threshold: only threads with a priority value below this preempt the
+ *                   thread before its time slice is used up. Must be at most "priority";
+ *                   equal to "priority" gives the normal behaviour.
+ * Param time_slice: round-robin quantum in ticks, 0 to run until the thread blocks or sleeps
+ * Param thread_name: the name of the thread, helpful when debugging.
+ * Param threadId: where the new thread's id is written, may be NULL
+ * Returns: Error code for adding threads
+ */
+G8RTOS_Scheduler_Error G8RTOS_AddThreadEx(void (*threadToAdd)(void), uint8_t priority, uint8_t preempt_threshold, uint32_t time_slice, char* thread_name, threadId_t* threadId);
+
+#if G8RTOS_USE_PTHREADS
 /*
  * Adds periodic threads to G8RTOS Scheduler
  * Function will initialize a periodic event struct to represent event.
@@ -82,6 +103,7 @@ G8RTOS_Scheduler_Error G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t prior
  * Returns: Error code for adding threads
  */
 G8RTOS_Scheduler_Error G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint32_t period);
+#endif
 
 /*
  * Puts the current thread into a sleep state.
@@ -101,12 +123,178 @@ void G8RTOS_Yield();
 threadId_t G8RTOS_GetThreadId();
 
 /*
- * Kill all threads, except for the CRT.
+ * Returns the name of a thread, or NULL if it does not exist
+ */
+const char* G8RTOS_GetThreadName(threadId_t threadId);
+
+/*
+ * Moves a thread into a group
+ *  - Threads it adds from then on start in the same group
+ * Param threadId: thread to move
+ * Param group: new group, THREAD_GROUP_NONE to leave its group
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetThreadGroup(threadId_t threadId, threadGroup_t group);
+
+/*
+ * Kills every thread of a group except the CRT, in one pass over the TCBs
+ * Param group: group to kill
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_KillGroup(threadGroup_t group);
+
+/*
+ * Restarts every thread of a group except the CRT from its entry function, in one pass over the TCBs
+ *  - Each thread is released like a killed one: a semaphore, lock or join it was blocked on is left
+ *    as if it had never waited, the reader-writer locks it holds are given back and its timing
+ *    statistics are dropped (G8RTOS_SetPeriodic registers it again)
+ *  - It then gets a fresh stack, its base priority, a full budget and a clean overrun count
+ *  - Plain semaphores have no owner, so one a thread took (used as a mutex) is not given back
+ *  - Do not restart a thread that may be blocked in a driver waiting for an interrupt (e.g. the LCD
+ *    DMA-done semaphore): the interrupt still signals it later, and the next waiter takes that
+ *    signal for its own transfer. Killing such a thread has the same problem.
+ * Param group: group to restart
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_RestartGroup(threadGroup_t group);
+
+/*
+ * Blocks until a thread exits or is killed
+ *  - A thread that already ended is joined right away, as long as its TCB was not reused
+ * Param threadId: thread to wait for
+ * Param exit_code: where its exit code is written (THREAD_EXIT_KILLED if it was killed), may be NULL
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_Join(threadId_t threadId, int32_t* exit_code);
+
+/*
+ * Ends the CRT with an exit code for the threads joining it
+ * Param exit_code: exit code passed to G8RTOS_Join; THREAD_EXIT_KILLED is reserved for
+ *                  killed threads and is passed on as THREAD_EXIT_KILLED + 1
+ */
+void G8RTOS_Exit(int32_t exit_code);
+
+/*
+ * Changes the priority of a thread
+ *  - Ready and blocked threads are picked by the new priority from then on
+ *  - A priority inherited through a lock or an I/O boost stays in effect if it is higher
+ *  - A preemption threshold left at the old priority follows the new one, and never ends up below it
+ *  - The CRT is only preempted right away if a ready thread now outranks its preemption threshold
+ * Param threadId: thread to change
+ * Param priority: new priority, 0 is the highest and 255 the lowest
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPriority(threadId_t threadId, uint8_t priority);
+
+/*
+ * Gets the priority a thread was given (without any inherited or boosted priority)
+ * Param threadId: thread to query
+ * Param priority: where the priority is written
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_GetPriority(threadId_t threadId, uint8_t* priority);
+
+/*
+ * Boosts a thread whenever an interrupt handler wakes it through a semaphore (an I/O completion)
+ *  - The thread runs at boost_priority until it next blocks or sleeps
+ * Param threadId: thread to change
+ * Param enable: true to turn the boost on, false to turn it off
+ * Param boost_priority: priority the thread is boosted to
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetIOBoost(threadId_t threadId, bool enable, uint8_t boost_priority);
+
+/*
+ * Changes the preemption threshold of a thread
+ * Param threadId: thread to change
+ * Param preempt_threshold: new threshold, at most the thread's priority
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPreemptThreshold(threadId_t threadId, uint8_t preempt_threshold);
+
+/*
+ * Changes the round-robin time slice of a thread
+ * Param threadId: thread to change
+ * Param time_slice: quantum in ticks, 0 to run until the thread blocks or sleeps
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetTimeSlice(threadId_t threadId, uint32_t time_slice);
+
+/*
+ * Gives a thread a CPU budget, replenished every period
+ *  - The thread is charged for every tick it is running when SysTick fires
+ *  - Once the budget is used up the thread is demoted or suspended (see
+ *    G8RTOS_Budget_Policy) until the next replenishment, and its overrun count goes up
+ *  - A suspended thread that is the only one left ready keeps running, so keep an idle thread
+ * Param threadId: thread to limit
+ * Param budget: ticks the thread may run per period, 0 to remove the budget
+ * Param period: replenishment period in ticks, at least "budget"
+ * Param policy: what to do with the thread while it is over budget
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetBudget(threadId_t threadId, uint32_t budget, uint32_t period, G8RTOS_Budget_Policy policy);
+
+/*
+ * Returns the number of times a thread used up its CPU budget (0 if it does not exist)
+ */
+uint32_t G8RTOS_GetBudgetOverruns(threadId_t threadId);
+
+#if G8RTOS_USE_TIMING
+/*
+ * Registers the CRT as periodic, starting its first job now
+ *  - The thread then ends each job with G8RTOS_WaitForNextPeriod
+ * Param period: time between releases in ms
+ * Param deadline: time after a release the job should be done by in ms
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_SetPeriodic(uint32_t period, uint32_t deadline);
+
+/*
+ * Ends the CRT's current job and sleeps until its next release
+ *  - Records the job's response time, and whether it missed its deadline
+ *  - A job that ran past its next release starts the next one right away
+ *  - Records the release jitter of the next job once it runs
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_WaitForNextPeriod();
+
+/*
+ * Copies the timing statistics of a periodic thread
+ * Param threadId: periodic thread to query
+ * Param timing: where the statistics are copied to
+ * Returns: Error code
+ */
+G8RTOS_Scheduler_Error G8RTOS_GetThreadTiming(threadId_t threadId, thread_timing_t* timing);
+
+/*
+ * Clears the statistics of a periodic thread, keeping its period and deadline
+ */
+G8RTOS_Scheduler_Error G8RTOS_ResetThreadTiming(threadId_t threadId);
+#endif
+
+#if G8RTOS_USE_BENCHMARK
+/*
+ * Measures the cycle counts of the kernel hot path
+ *  - Run from a thread after G8RTOS_Launch, with no higher priority thread kept ready
+ * Param result: where the cycle counts are written
+ */
+void G8RTOS_KernelBenchmark(kernel_benchmark_t* result);
+
+/*
+ * Thread that runs G8RTOS_KernelBenchmark once, prints it over the back channel UART and kills itself
+ */
+void G8RTOS_KernelBenchmarkThread();
+#endif
+
+/*
+ * Kill all threads, except for the CRT (in one pass over the TCBs).
  */
 void G8RTOS_KillAllOtherThreads();
 
 /*
  * Kill the thread with id threadId.
+ *  - Gives back what it waits on and the reader-writer locks it holds, see G8RTOS_RestartGroup
+ *    for why it may not be blocked in a driver
  */
 G8RTOS_Scheduler_Error G8RTOS_KillThread(threadId_t threadId);
 
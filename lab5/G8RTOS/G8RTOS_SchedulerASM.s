@@ -6,15 +6,24 @@
 	.def G8RTOS_Start, PendSV_Handler
 
 	; Dependencies
-	.ref CurrentlyRunningThread, G8RTOS_Scheduler, StartCriticalSection, EndCriticalSection
+	.ref CurrentlyRunningThread, G8RTOS_Scheduler, StartCriticalSection, EndCriticalSection, AvoidedContextSwitches, ContextSwitches
+
+	; Pull in G8RTOS_USE_FPU and G8RTOS_USE_RAMFUNCS
+	.cdecls C,NOLIST,"G8RTOS_Config.h"
 
 	.thumb		; Set to thumb mode
 	.align 2	; Align by 2 bytes (thumb mode uses allignment by 2 or 4)
+	.if G8RTOS_USE_RAMFUNCS
+	.sect ".TI.ramfunc" ; Run from SRAM, the context switch is on the hot path
+	.else
 	.text		; Text section
+	.endif
 
 ; Need to have the address defined in file 
 ; (label needs to be close enough to asm code to be reached with PC relative addressing)
 RunningPtr: .field CurrentlyRunningThread, 32
+AvoidedPtr: .field AvoidedContextSwitches, 32
+SwitchesPtr: .field ContextSwitches, 32
 
 ; G8RTOS_Start
 ;	Sets the first thread to be the currently running thread
@@ -28,6 +37,11 @@ G8RTOS_Start:
 	ldr r1, [r0] ; follow the pointer to the object and load it
 	ldr sp, [r1] ; restore the sp with the value that was stored in the tcb
 
+	.if G8RTOS_USE_FPU
+	; Skip the EXC_RETURN of the fake context
+	add sp, sp, #4
+	.endif
+
 	; Pops registers from thread stack
 	pop {r4-r11, r0-r3, r12}
 
@@ -45,11 +59,13 @@ G8RTOS_Start:
 
 ; PendSV_Handler
 ; - Performs a context switch in G8RTOS
-; 	- Saves remaining registers into thread stack
-;	- Saves current stack pointer to tcb
 ;	- Calls G8RTOS_Scheduler to get new tcb
+;	- If the scheduler kept the same tcb, counts the avoided switch and returns
+;	- Saves remaining registers into old thread stack
+;		(with G8RTOS_USE_FPU, also s16-s31 if the thread used the FPU, and its EXC_RETURN)
+;	- Saves current stack pointer to old tcb
 ;	- Set stack pointer to new stack pointer from new tcb
-;	- Pops registers from thread stack
+;	- Pops registers from thread stack and counts the switch
 PendSV_Handler:
 
 	.asmfunc
@@ -58,28 +74,66 @@ PendSV_Handler:
 	bl StartCriticalSection ; r0 contains IBit_State
 	pop {r1-r3, r12, lr}
 
-	; Saves remaining registers into thread stack
-	push {r4-r11}
-
-	; Saves current stack pointer to tcb
+	; Remember the thread that was running
 	ldr r1, RunningPtr ; point to the beginning of the running thread's struct
-	ldr r1, [r1] ; follow the pointer to the object and load it
-	str sp, [r1] ; update the value of the memory that sp is pointing to as the current sp
+	ldr r2, [r1] ; follow the pointer to the object and load it
 
 	; Calls G8RTOS_Scheduler to get new tcb
-	push {r0-r3, r12, lr}
+	; (r4-r11 are callee saved, so the old thread's values survive the call)
+	push {r0, r2, r12, lr}
 	bl G8RTOS_Scheduler
-	pop {r0-r3, r12, lr}
+	pop {r0, r2, r12, lr}
 
-	; Set stack pointer to new stack pointer from new tcb
+	; Skip the register save/restore if the scheduler kept the same thread
 	ldr r1, RunningPtr ; point to the beginning of the **new** running thread's struct
 	ldr r1, [r1] ; follow the pointer to the object and load it
+	cmp r1, r2
+	beq PendSV_SameThread
+
+	; Saves remaining registers into old thread stack
+	.if G8RTOS_USE_FPU
+	tst lr, #0x10 ; bit 4 clear: the hardware stacked an extended (FPU) frame
+	it eq
+	vpusheq {s16-s31}
+	push {r4-r11}
+	push {lr} ; EXC_RETURN, says how to return to this thread
+	.else
+	push {r4-r11}
+	.endif
+
+	; Saves current stack pointer to old tcb
+	str sp, [r2] ; update the value of the memory that sp is pointing to as the current sp
+
+	; Set stack pointer to new stack pointer from new tcb
 	ldr sp, [r1] ; restore the sp with the value that was stored in the tcb
 
 	; Pops registers from thread stack
+	.if G8RTOS_USE_FPU
+	pop {lr} ; return through the new thread's EXC_RETURN
+	pop {r4-r11}
+	tst lr, #0x10
+	it eq
+	vpopeq {s16-s31}
+	.else
 	pop {r4-r11}
+	.endif
 	; Popping r0-r3, r12-r15, psr is automatic when returning from this handler
 
+	; Count the context switch
+	ldr r1, SwitchesPtr
+	ldr r3, [r1]
+	add r3, r3, #1
+	str r3, [r1]
+	b PendSV_Exit
+
+PendSV_SameThread:
+	; Count the avoided context switch
+	ldr r1, AvoidedPtr
+	ldr r3, [r1]
+	add r3, r3, #1
+	str r3, [r1]
+
+PendSV_Exit:
 	push {r1-r3, r12, lr}
 	bl EndCriticalSection ; r0 contains IBit_State
 	pop {r1-r3, r12, lr}
@@ -9,11 +9,294 @@
 #include "G8RTOS_Semaphores.h"
 #include "msp.h"
 
+/*
+ * Lock-free fast paths, exist in asm
+ *  - Return true if they completed the operation, false if the kernel has
+ *    to finish it (block the caller, or unblock a waiting thread)
+ */
+extern bool SemaphoreTryWait(semaphore_t* s);
+extern bool SemaphoreTrySignal(semaphore_t* s);
+
 /*********************************************** Dependencies and Externs *************************************************************/
 
 
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Every reader-writer lock initialized, so the locks of a killed thread can be found */
+static rwlock_t* rwLocks[MAX_RWLOCKS];
+static uint32_t NumberOfRWLocks = 0;
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Bit identifying a thread in a reader-writer lock's reader_mask
+ */
+static uint32_t ReaderBit(tcb_t* thread)
+{
+    return 1UL << TCB_INDEX(thread->thread_id);
+}
+
+/*
+ * Raises the priority of a thread to at least the given priority
+ */
+static void Boost(tcb_t* thread, uint8_t priority)
+{
+    if (priority < thread->priority) thread->priority = priority;
+}
+
+/*
+ * Boosts every holder of a reader-writer lock to the priority of the
+ * currently running thread, which is about to block on it.
+ * Must be called inside a critical section.
+ */
+static void InheritPriority(rwlock_t* lock)
+{
+    if (!lock->priority_inheritance) return;
+
+    uint8_t priority = CurrentlyRunningThread->priority;
+
+    if (lock->writer)
+    {
+        Boost(lock->owner, priority);
+        return;
+    }
+
+    // boost every reader, found through the reader mask
+    for (tcb_t* thread = CurrentlyRunningThread->next; thread != CurrentlyRunningThread; thread = thread->next)
+    {
+        if (lock->reader_mask & ReaderBit(thread)) Boost(thread, priority);
+    }
+}
+
+/*
+ * Whether a thread holds a reader-writer lock, for reading or writing
+ */
+static bool Holds(rwlock_t* lock, tcb_t* thread)
+{
+    return (lock->writer && lock->owner == thread) || (lock->reader_mask & ReaderBit(thread)) != 0;
+}
+
+/*
+ * Drops the priority the currently running thread inherited through a
+ * reader-writer lock it has just released. It keeps an active I/O boost and
+ * what it inherits from threads still waiting on the locks it holds.
+ * Must be called inside a critical section, once the lock is released.
+ */
+static void DisinheritPriority(rwlock_t* lock)
+{
+    if (!lock->priority_inheritance) return;
+
+    uint8_t priority = CurrentlyRunningThread->base_priority;
+    if (CurrentlyRunningThread->io_boosted && CurrentlyRunningThread->io_boost_priority < priority) priority = CurrentlyRunningThread->io_boost_priority;
+
+    // every thread blocked on a lock still held passes its priority on again
+    for (tcb_t* thread = CurrentlyRunningThread->next; thread != CurrentlyRunningThread; thread = thread->next)
+    {
+        rwlock_t* held = thread->waiting_lock;
+        if (held != NULL && held->priority_inheritance && thread->priority < priority && Holds(held, CurrentlyRunningThread))
+        {
+            priority = thread->priority;
+        }
+    }
+
+    CurrentlyRunningThread->priority = priority;
+}
+
+/*
+ * Hands a reader-writer lock to the highest priority writer blocked on it.
+ * Must be called inside a critical section with a writer waiting.
+ */
+static void GrantWriter(rwlock_t* lock)
+{
+    // search for the highest priority thread blocked on the write gate (the first one found wins ties)
+    tcb_t* thread = CurrentlyRunningThread->next;
+    while (thread->blocked != &lock->write_gate) thread = thread->next;
+    for (tcb_t* other = thread->next; other != CurrentlyRunningThread->next; other = other->next)
+    {
+        if (other->blocked == &lock->write_gate && other->priority < thread->priority) thread = other;
+    }
+
+    // and hand it the lock
+    lock->writer = true;
+    lock->owner = thread;
+    --lock->waiting_writers;
+    thread->blocked = NULL;
+    thread->waiting_lock = NULL;
+}
+
+/*
+ * Hands a reader-writer lock to every reader blocked on it.
+ * Must be called inside a critical section.
+ */
+static void GrantReaders(rwlock_t* lock)
+{
+    tcb_t* thread = CurrentlyRunningThread;
+    do
+    {
+        thread = thread->next;
+        if (thread->blocked == &lock->read_gate)
+        {
+            lock->reader_mask |= ReaderBit(thread);
+            thread->blocked = NULL;
+            thread->waiting_lock = NULL;
+        }
+    } while (thread != CurrentlyRunningThread);
+
+    lock->readers += lock->waiting_readers;
+    lock->waiting_readers = 0;
+}
+
+/*
+ * Takes count units of a semaphore, blocking the currently running thread
+ * until it has all of them.
+ *  - A positive value is the number of free units, a negative one the number
+ *    of units the blocked threads still need
+ *  - A thread that has to block keeps the free units, the rest are handed to it by GiveUnits
+ */
+static void TakeUnits(semaphore_t* s, uint32_t count)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    int32_t available = (*s) > 0 ? (*s) : 0;
+
+    (*s) -= count;
+
+    // if the resource was not available
+    if ( (*s) < 0 )
+    {
+        // block the currently running thread until it is handed what is missing
+        CurrentlyRunningThread->blocked = s;
+        CurrentlyRunningThread->wait_count = count - available;
+        CurrentlyRunningThread->wait_granted = available;
+
+        EndCriticalSection(IBit_State);
+
+        // and yield the CPU
+        G8RTOS_Yield();
+    }
+    else
+    {
+        // the resource was available and we can continue without blocking
+        EndCriticalSection(IBit_State);
+    }
+}
+
+/*
+ * Gives count units back to a semaphore, handing them to the threads blocked
+ * on it (highest priority first) until none of them needs more.
+ * Must be called inside a critical section.
+ */
+static void GiveUnits(semaphore_t* s, uint32_t count)
+{
+    // units the blocked threads still need
+    int32_t owed = (*s) < 0 ? -(*s) : 0;
+
+    (*s) += count;
+
+    while (count > 0 && owed > 0)
+    {
+        // search for the highest priority thread blocked on this semaphore (the first one found wins ties)
+        tcb_t* thread = CurrentlyRunningThread->next;
+        while (thread->blocked != s) thread = thread->next;
+        for (tcb_t* other = thread->next; other != CurrentlyRunningThread->next; other = other->next)
+        {
+            if (other->blocked == s && other->priority < thread->priority) thread = other;
+        }
+
+        // and hand it as much as it needs
+        uint32_t units = count < thread->wait_count ? count : thread->wait_count;
+        thread->wait_count -= units;
+        thread->wait_granted += units;
+        count -= units;
+        owed -= units;
+
+        // unblock it once it has everything it waited for
+        if (thread->wait_count == 0)
+        {
+            thread->blocked = NULL;
+
+            // a thread woken by an interrupt handler finished waiting on I/O, so it may get a boost
+            if (thread->io_boost && (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0 && thread->io_boost_priority < thread->priority)
+            {
+                thread->priority = thread->io_boost_priority;
+                thread->io_boosted = true;
+            }
+        }
+    }
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
 /*********************************************** Public Functions *********************************************************************/
 
+/*
+ * Undoes the wait of a blocked thread, as if it had never waited
+ *  - A semaphore no longer owes the thread anything, and gets back the units it was handed
+ *  - A reader-writer lock forgets the waiter; readers queued only behind
+ *    that writer get the lock
+ *  - A join needs nothing undone
+ * Must be called inside a critical section, while the thread is still in the scheduler.
+ */
+void G8RTOS_CancelWait(tcb_t* thread)
+{
+    semaphore_t* s = thread->blocked;
+    if (s == NULL) return;
+
+    thread->blocked = NULL;
+
+    rwlock_t* lock = thread->waiting_lock;
+    if (lock != NULL)
+    {
+        thread->waiting_lock = NULL;
+
+        if (s == &lock->read_gate) --lock->waiting_readers;
+        else --lock->waiting_writers;
+
+        if (!lock->writer && lock->waiting_writers == 0 && lock->waiting_readers > 0) GrantReaders(lock);
+    }
+    else if (thread->joining != NULL)
+    {
+        thread->joining = NULL;
+    }
+    else
+    {
+        (*s) += thread->wait_count;
+        GiveUnits(s, thread->wait_granted);
+    }
+}
+
+/*
+ * Gives back every reader-writer lock a thread holds, handing each on as its
+ * release would. Must be called inside a critical section.
+ */
+void G8RTOS_ReleaseLocks(tcb_t* thread)
+{
+    for (uint32_t i = 0; i < NumberOfRWLocks; ++i)
+    {
+        rwlock_t* lock = rwLocks[i];
+
+        if (lock->writer && lock->owner == thread)
+        {
+            lock->writer = false;
+            lock->owner = NULL;
+
+            if (lock->waiting_writers > 0) GrantWriter(lock);
+            else if (lock->waiting_readers > 0) GrantReaders(lock);
+        }
+        else if (lock->reader_mask & ReaderBit(thread))
+        {
+            --lock->readers;
+            lock->reader_mask &= ~ReaderBit(thread);
+
+            if (lock->readers == 0 && lock->waiting_writers > 0) GrantWriter(lock);
+        }
+    }
+}
+
 /*
  * Initializes a semaphore to a given value
  * Param "s": Pointer to semaphore
@@ -32,19 +315,115 @@ void G8RTOS_InitSemaphore(semaphore_t* s, int32_t value)
  * No longer waits for semaphore
  *  - Decrements semaphore
  *  - Blocks thread is sempahore is unavalible
+ *  - An available semaphore is taken without a critical section
  * Param "s": Pointer to semaphore to wait on
  */
 void G8RTOS_WaitSemaphore(semaphore_t* s)
 {
+    // uncontended: take it lock-free
+    if (SemaphoreTryWait(s)) return;
+
+    TakeUnits(s, 1);
+}
+
+/*
+ * Signals the completion of the usage of a semaphore
+ *  - Increments the semaphore value by 1
+ *  - Hands the unit to the highest priority thread waiting on that semaphore,
+ *    which is unblocked if that was the last unit it needed
+ *  - A semaphore nobody waits on is signaled without a critical section
+ * Param "s": Pointer to semaphore to be signaled
+ */
+void G8RTOS_SignalSemaphore(semaphore_t* s)
+{
+    // uncontended: give it back lock-free
+    if (SemaphoreTrySignal(s)) return;
+
     int32_t IBit_State = StartCriticalSection();
 
-    (*s)--;
+    GiveUnits(s, 1);
 
-    // if the resource was not available
-    if ( (*s) < 0 )
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Waits for count units of a semaphore
+ *  - Costs one critical section however many units are taken
+ *  - Blocks until the missing units have been signaled
+ * Param "s": Pointer to semaphore to wait on
+ * Param "count": Number of units to take
+ */
+void G8RTOS_WaitSemaphoreN(semaphore_t* s, uint32_t count)
+{
+    if (count == 0) return;
+
+    TakeUnits(s, count);
+}
+
+/*
+ * Signals count units of a semaphore
+ *  - Costs one critical section however many units are given
+ *  - Unblocks the waiting threads the units complete, highest priority first
+ * Param "s": Pointer to semaphore to be signaled
+ * Param "count": Number of units to give
+ */
+void G8RTOS_SignalSemaphoreN(semaphore_t* s, uint32_t count)
+{
+    if (count == 0) return;
+
+    int32_t IBit_State = StartCriticalSection();
+
+    GiveUnits(s, count);
+
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Initializes a reader-writer lock to the unlocked state
+ * Param "lock": Pointer to the lock
+ * Param "priority_inheritance": if true, threads holding the lock inherit the
+ *                               priority of the threads it blocks
+ */
+void G8RTOS_InitRWLock(rwlock_t* lock, bool priority_inheritance)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    lock->readers = 0;
+    lock->writer = false;
+    lock->waiting_readers = 0;
+    lock->waiting_writers = 0;
+    lock->read_gate = 0;
+    lock->write_gate = 0;
+    lock->priority_inheritance = priority_inheritance;
+    lock->reader_mask = 0;
+    lock->owner = NULL;
+
+    // track the lock, once, so a killed thread can give it back
+    uint32_t i = 0;
+    while (i < NumberOfRWLocks && rwLocks[i] != lock) ++i;
+    if (i == NumberOfRWLocks && NumberOfRWLocks < MAX_RWLOCKS) rwLocks[NumberOfRWLocks++] = lock;
+
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Acquires a reader-writer lock for reading
+ *  - Blocks while a writer holds or is waiting for the lock
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_AcquireReadLock(rwlock_t* lock)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    // writer preference: queue behind both the active and the waiting writers
+    if (lock->writer || lock->waiting_writers > 0)
     {
-        // block the currently running thread
-        CurrentlyRunningThread->blocked = s;
+        ++lock->waiting_readers;
+        InheritPriority(lock);
+
+        // block the currently running thread, the releasing writer hands us the lock
+        CurrentlyRunningThread->blocked = &lock->read_gate;
+        CurrentlyRunningThread->waiting_lock = lock;
 
         EndCriticalSection(IBit_State);
 
@@ -53,33 +432,80 @@ void G8RTOS_WaitSemaphore(semaphore_t* s)
     }
     else
     {
-        // the resource was available and we can continue without blocking
+        // the lock was available for reading and we can continue without blocking
+        ++lock->readers;
+        lock->reader_mask |= ReaderBit(CurrentlyRunningThread);
+
         EndCriticalSection(IBit_State);
     }
 }
 
 /*
- * Signals the completion of the usage of a semaphore
- *  - Increments the semaphore value by 1
- *  - Unblocks any threads waiting on that semaphore
- * Param "s": Pointer to semaphore to be signaled
+ * Releases a reader-writer lock held for reading
+ *  - The last reader out hands the lock to the highest priority waiting writer
+ * Param "lock": Pointer to the lock
  */
-void G8RTOS_SignalSemaphore(semaphore_t* s)
+void G8RTOS_ReleaseReadLock(rwlock_t* lock)
 {
     int32_t IBit_State = StartCriticalSection();
 
-    (*s)++;
+    --lock->readers;
+    lock->reader_mask &= ~ReaderBit(CurrentlyRunningThread);
+    DisinheritPriority(lock);
 
-    // if the resource was unavailable before we signaled
-    if ( (*s) <= 0 )
+    if (lock->readers == 0 && lock->waiting_writers > 0) GrantWriter(lock);
+
+    EndCriticalSection(IBit_State);
+}
+
+/*
+ * Acquires a reader-writer lock for writing
+ *  - Blocks while any reader or writer holds the lock
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_AcquireWriteLock(rwlock_t* lock)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    if (lock->writer || lock->readers > 0)
     {
-        // search for the first thread blocked on this semaphore
-        tcb_t* thread = CurrentlyRunningThread->next;
-        while (thread->blocked != s) thread = thread->next;
+        ++lock->waiting_writers;
+        InheritPriority(lock);
+
+        // block the currently running thread, the releasing holder hands us the lock
+        CurrentlyRunningThread->blocked = &lock->write_gate;
+        CurrentlyRunningThread->waiting_lock = lock;
+
+        EndCriticalSection(IBit_State);
+
+        // and yield the CPU
+        G8RTOS_Yield();
+    }
+    else
+    {
+        // the lock was free and we can continue without blocking
+        lock->writer = true;
+        lock->owner = CurrentlyRunningThread;
 
-        // and unblock it
-        thread->blocked = NULL;
+        EndCriticalSection(IBit_State);
     }
+}
+
+/*
+ * Releases a reader-writer lock held for writing
+ *  - Hands the lock to the highest priority waiting writer, otherwise to every waiting reader
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_ReleaseWriteLock(rwlock_t* lock)
+{
+    int32_t IBit_State = StartCriticalSection();
+
+    lock->writer = false;
+    lock->owner = NULL;
+    DisinheritPriority(lock);
+
+    if (lock->waiting_writers > 0) GrantWriter(lock);
+    else if (lock->waiting_readers > 0) GrantReaders(lock);
 
     EndCriticalSection(IBit_State);
 }
@@ -6,6 +6,7 @@
 #define G8RTOS_SEMAPHORES_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /*********************************************** Datatype Definitions *****************************************************************/
 
@@ -14,6 +15,25 @@
  */
 typedef int32_t semaphore_t;
 
+/*
+ * Reader-Writer Lock typedef
+ *  - Any number of readers may hold the lock at once, writers hold it alone
+ *  - Writer preference: once a writer is waiting, new readers block
+ *  - Ownership is handed directly to the threads it unblocks
+ */
+typedef struct rwlock_t
+{
+    int32_t readers;                /* Number of threads holding the lock for reading */
+    bool writer;                    /* Whether a thread holds the lock for writing */
+    int32_t waiting_readers;        /* Readers blocked on read_gate */
+    int32_t waiting_writers;        /* Writers blocked on write_gate */
+    semaphore_t read_gate;          /* Address readers block on */
+    semaphore_t write_gate;         /* Address writers block on */
+    bool priority_inheritance;      /* Boost holders to the priority of blocked threads */
+    uint32_t reader_mask;           /* TCB indices of the current readers */
+    struct tcb_t* owner;            /* Current writer */
+} rwlock_t;
+
 /*********************************************** Datatype Definitions *****************************************************************/
 
 
@@ -29,7 +49,8 @@ void G8RTOS_InitSemaphore(semaphore_t *s, int32_t value);
 /*
  * Waits for a semaphore to be available (value greater than 0)
  * 	- Decrements semaphore when available
- * 	- Spinlocks to wait for semaphore
+ * 	- Blocks until it is signaled otherwise
+ * 	- The uncontended case uses LDREX/STREX instead of a critical section
  * Param "s": Pointer to semaphore to wait on
  */
 void G8RTOS_WaitSemaphore(semaphore_t *s);
@@ -37,10 +58,82 @@ void G8RTOS_WaitSemaphore(semaphore_t *s);
 /*
  * Signals the completion of the usage of a semaphore
  * 	- Increments the semaphore value by 1
+ * 	- Only enters a critical section if a thread is blocked on it
  * Param "s": Pointer to semaphore to be signalled
  */
 void G8RTOS_SignalSemaphore(semaphore_t *s);
 
+/*
+ * Waits for count units of a semaphore in one operation
+ * 	- Takes them all at once if available, otherwise takes what there is and
+ * 	  blocks until signals have handed it the rest
+ * Param "s": Pointer to semaphore to wait on
+ * Param "count": Number of units to take
+ */
+void G8RTOS_WaitSemaphoreN(semaphore_t *s, uint32_t count);
+
+/*
+ * Signals count units of a semaphore in one operation
+ * 	- Increments the semaphore value by count
+ * 	- Hands the units to blocked threads, highest priority first
+ * Param "s": Pointer to semaphore to be signalled
+ * Param "count": Number of units to give
+ */
+void G8RTOS_SignalSemaphoreN(semaphore_t *s, uint32_t count);
+
+/*
+ * Initializes a reader-writer lock to the unlocked state
+ * 	- The first MAX_RWLOCKS locks are tracked, so a killed thread gives them back
+ * Param "lock": Pointer to the lock
+ * Param "priority_inheritance": if true, threads holding the lock inherit the
+ *                               priority of the threads it blocks
+ */
+void G8RTOS_InitRWLock(rwlock_t *lock, bool priority_inheritance);
+
+/*
+ * Acquires a reader-writer lock for reading
+ * 	- Blocks while a writer holds or is waiting for the lock
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_AcquireReadLock(rwlock_t *lock);
+
+/*
+ * Releases a reader-writer lock held for reading
+ * 	- The last reader out hands the lock to the highest priority waiting writer
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_ReleaseReadLock(rwlock_t *lock);
+
+/*
+ * Acquires a reader-writer lock for writing
+ * 	- Blocks while any reader or writer holds the lock
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_AcquireWriteLock(rwlock_t *lock);
+
+/*
+ * Releases a reader-writer lock held for writing
+ * 	- Hands the lock to the highest priority waiting writer, otherwise to every waiting reader
+ * Param "lock": Pointer to the lock
+ */
+void G8RTOS_ReleaseWriteLock(rwlock_t *lock);
+
+/*
+ * Undoes the wait of a blocked thread, used by the scheduler when it kills or restarts it
+ * 	- A semaphore gets back the units the thread was handed, a reader-writer lock forgets the waiter
+ * 	- Must be called inside a critical section
+ * Param "thread": thread to unblock, nothing is done if it is not blocked
+ */
+void G8RTOS_CancelWait(struct tcb_t *thread);
+
+/*
+ * Gives back every reader-writer lock a thread holds, used by the scheduler when it kills or restarts it
+ * 	- Only the first MAX_RWLOCKS locks initialized are tracked
+ * 	- Must be called inside a critical section
+ * Param "thread": thread whose locks are released
+ */
+void G8RTOS_ReleaseLocks(struct tcb_t *thread);
+
 /*********************************************** Public Functions *********************************************************************/
 
 
@@ -0,0 +1,85 @@
+; G8RTOS_SemaphoresASM.s
+; Holds the lock-free fast paths of the semaphores
+; Note: If you have an h file, do not have a C file and an S file of the same name
+
+	; Functions Defined
+	.def SemaphoreTryWait, SemaphoreTrySignal
+
+	; Pull in G8RTOS_USE_RAMFUNCS
+	.cdecls C,NOLIST,"G8RTOS_Config.h"
+
+	.thumb		; Set to thumb mode
+	.align 2	; Align by 2 bytes (thumb mode uses allignment by 2 or 4)
+	.if G8RTOS_USE_RAMFUNCS
+	.sect ".TI.ramfunc" ; Run from SRAM, semaphores are on the hot path
+	.else
+	.text		; Text section
+	.endif
+
+; SemaphoreTryWait
+; - Takes a semaphore that is available without entering a critical section
+;	- Decrements the semaphore with LDREX/STREX, retrying if anything else touched it in between
+;	  (an exception between the two clears the exclusive monitor, so the STREX fails)
+;	- Leaves an unavailable semaphore alone for the kernel to block on
+; Param r0: Pointer to semaphore
+; Returns: 1 if the semaphore was taken, 0 if the caller has to block
+SemaphoreTryWait:
+
+	.asmfunc
+
+SemaphoreTryWait_Retry:
+	ldrex r1, [r0]
+	cmp r1, #0
+	ble SemaphoreTryWait_Unavailable ; nothing left to take
+
+	sub r1, r1, #1
+	strex r2, r1, [r0] ; r2 is 0 if the store went through
+	cmp r2, #0
+	bne SemaphoreTryWait_Retry
+
+	dmb ; the protected accesses may not start before the semaphore is taken
+	mov r0, #1
+	bx lr
+
+SemaphoreTryWait_Unavailable:
+	clrex
+	mov r0, #0
+	bx lr
+
+	.endasmfunc
+
+; SemaphoreTrySignal
+; - Signals a semaphore nobody waits on without entering a critical section
+;	- Increments the semaphore with LDREX/STREX, retrying if anything else touched it in between
+;	- Leaves a semaphore with blocked threads (negative value) for the kernel to unblock one
+; Param r0: Pointer to semaphore
+; Returns: 1 if the semaphore was signaled, 0 if the caller has to unblock a thread
+SemaphoreTrySignal:
+
+	.asmfunc
+
+	dmb ; the protected accesses finish before the semaphore is given back
+
+SemaphoreTrySignal_Retry:
+	ldrex r1, [r0]
+	cmp r1, #0
+	blt SemaphoreTrySignal_Waiters ; a thread is blocked on it
+
+	add r1, r1, #1
+	strex r2, r1, [r0] ; r2 is 0 if the store went through
+	cmp r2, #0
+	bne SemaphoreTrySignal_Retry
+
+	mov r0, #1
+	bx lr
+
+SemaphoreTrySignal_Waiters:
+	clrex
+	mov r0, #0
+	bx lr
+
+	.endasmfunc
+
+	; end of the asm file
+	.align
+	.end
@@ -10,29 +10,115 @@
 
 #include <stdbool.h>
 #include "G8RTOS_Semaphores.h"
+#include "G8RTOS_Config.h"
 
 
 /*********************************************** Typedefs ******************************************************************************/
 
 typedef uint32_t threadId_t;
 
+/*
+ * Thread groups let related threads be killed or restarted together
+ */
+typedef uint8_t threadGroup_t;
+
+/*
+ * What happens to a thread that uses up its CPU budget before it is replenished
+ *  - BUDGET_DEMOTE: it keeps running, but only at BUDGET_DEMOTED_PRIORITY
+ *  - BUDGET_SUSPEND: it does not run at all
+ */
+typedef enum G8RTOS_Budget_Policy
+{
+    BUDGET_DEMOTE = 0,
+    BUDGET_SUSPEND = 1,
+} G8RTOS_Budget_Policy;
+
 /*********************************************** Typedefs ******************************************************************************/
 
 
 /*********************************************** Defines ******************************************************************************/
 
-#define MAX_NAME_LENGTH 16
 #define NULL 0
 
+/* The lower half of a thread ID is the index of its TCB */
+#define TCB_INDEX(threadId) ((threadId) & 0xFFFF)
+
+/* Group of threads that belong to no group */
+#define THREAD_GROUP_NONE 0
+
+/* Exit code of a thread that was killed instead of exiting itself (G8RTOS_Exit never passes it on) */
+#define THREAD_EXIT_KILLED INT32_MIN
+
 /*********************************************** Defines ******************************************************************************/
 
 
 /*********************************************** Data Structure Definitions ***********************************************************/
 
+#if G8RTOS_USE_TIMING
+/*
+ *  Thread Timing:
+ *      - Kept for threads registered as periodic with G8RTOS_SetPeriodic
+ *      - A job is released every period ms and should finish (G8RTOS_WaitForNextPeriod) within deadline ms
+ *      - Jitter is the time from a release to the thread actually running, response time from a release to its completion
+ *      - Only releases the thread slept for give a jitter sample (not the first job, nor one started late by an overrun)
+ *      - Times are measured in us with the DWT cycle counter
+ */
+typedef struct thread_timing_t
+{
+    uint32_t period;
+    uint32_t deadline;
+    uint32_t next_release;
+    uint32_t release_cycles;
+    bool awaiting_release;
+    bool in_use;
+    uint32_t jobs;
+    uint32_t deadline_misses;
+    uint32_t jitter_samples;
+    uint32_t jitter_max_us;
+    uint32_t jitter_avg_us;
+    uint32_t response_min_us;
+    uint32_t response_max_us;
+    uint32_t response_avg_us;
+    uint64_t jitter_total_us;
+    uint64_t response_total_us;
+    uint32_t response_histogram[TIMING_HISTOGRAM_BINS];
+} thread_timing_t;
+#endif
+
+#if G8RTOS_USE_BENCHMARK
+/*
+ *  Kernel Benchmark:
+ *      - Cycle counts of the kernel hot path, measured with the DWT cycle counter
+ *      - critical_section: a StartCriticalSection/EndCriticalSection pair
+ *      - semaphore: an uncontended G8RTOS_WaitSemaphore/G8RTOS_SignalSemaphore pair
+ *      - yield: a G8RTOS_Yield that keeps the same thread (PendSV and the scheduler)
+ *      - systick: SysTick_Handler, over every tick since G8RTOS_Launch
+ *      - Compare a build with G8RTOS_USE_RAMFUNCS against one without
+ */
+typedef struct kernel_benchmark_t
+{
+    uint32_t critical_section;
+    uint32_t semaphore;
+    uint32_t yield;
+    uint32_t systick_min;
+    uint32_t systick_max;
+    uint32_t systick_ticks;
+    bool ramfuncs;
+} kernel_benchmark_t;
+#endif
+
 /*
  *  Thread Control Block:
  *      - Every thread has a Thread Control Block
  *      - The Thread Control Block holds information about the Thread Such as the Stack Pointer, Priority Level, and Blocked Status
+ *      - Only threads of a higher priority than preempt_threshold preempt it before its time_slice (in ticks) is used up
+ *      - A thread with a budget may run budget ticks every budget_period ticks before it is throttled
+ *      - Periodic threads point to their timing statistics
+ *      - With io_boost set, a thread woken from an interrupt runs at io_boost_priority until it next blocks or sleeps
+ *      - Threads start in the group of the thread that added them; entry is kept so a group can be restarted
+ *      - A thread joining another blocks on the other's join_gate and gets its exit_code in join_exit_code
+ *      - A thread blocked on a reader-writer lock's gate points to the lock, so the wait can be undone
+ *      - A thread blocked on a semaphore still needs wait_count units, and has been handed wait_granted already
  */
 
 typedef struct tcb_t
@@ -42,9 +128,34 @@ typedef struct tcb_t
     struct tcb_t* next;
     bool alive;
     uint8_t priority;
+    uint8_t base_priority;
+    uint8_t preempt_threshold;
+    uint32_t time_slice;
+    uint32_t budget;
+    uint32_t budget_period;
+    uint32_t budget_remaining;
+    uint32_t budget_replenish_time;
+    uint32_t budget_overruns;
+    G8RTOS_Budget_Policy budget_policy;
+    bool throttled;
+#if G8RTOS_USE_TIMING
+    thread_timing_t* timing;
+#endif
+    bool io_boost;
+    bool io_boosted;
+    uint8_t io_boost_priority;
     bool asleep;
     uint32_t sleep_cnt;
     semaphore_t* blocked;
+    uint32_t wait_count;
+    uint32_t wait_granted;
+    struct rwlock_t* waiting_lock;
+    void (*entry)(void);
+    threadGroup_t group;
+    int32_t exit_code;
+    semaphore_t join_gate;
+    struct tcb_t* joining;
+    int32_t join_exit_code;
     threadId_t thread_id;
     char thread_name[MAX_NAME_LENGTH];
 } tcb_t;
@@ -54,6 +165,7 @@ typedef struct tcb_t
  *      - Holds a function pointer that points to the periodic thread to be executed
  *      - Has a period in us
  *      - Holds Current time
+ *      - Counts releases still waiting for the dispatch thread
  *      - Contains pointer to the next periodic event - linked list
  */
 
@@ -62,6 +174,7 @@ typedef struct ptcb_t
     void (*handler)(void);
     uint32_t period;
     uint32_t exec_time;
+    uint32_t pending;
     struct ptcb_t* prev;
     struct ptcb_t* next;
 } ptcb_t;
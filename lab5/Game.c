@@ -14,6 +14,12 @@
  */
 void JoinGame()
 {
+    // Polls at MAX_PRIO, so limit how much of the CPU it can take
+    G8RTOS_SetBudget(G8RTOS_GetThreadId(), SETUP_BUDGET, SETUP_BUDGET_PERIOD, BUDGET_DEMOTE);
+
+    // The game threads added from here on start in the game session group
+    G8RTOS_SetThreadGroup(G8RTOS_GetThreadId(), GAME_SESSION_GROUP);
+
     // Temp variables to prevent hold-and-wait condition
     GameState_t tempGameState;
     // Set initial SpecificPlayerInfo_t strict attributes (you can get the IP address by calling getLocalIP()
@@ -47,9 +53,9 @@ void JoinGame()
     G8RTOS_SignalSemaphore(&WiFi_Mutex);
 
     // Empty the received packet
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
+    G8RTOS_AcquireWriteLock(&GameState_Lock);
     gameState = tempGameState;
-    G8RTOS_SignalSemaphore(&GameState_Mutex);
+    G8RTOS_ReleaseWriteLock(&GameState_Lock);
 
     // If you've joined the game, acknowledge you've joined to the host and show connection with an LED
     if (tempGameState.player.acknowledge)
@@ -95,26 +101,37 @@ void JoinGame()
  */
 void ReceiveDataFromHost()
 {
+   bool bursting = false;
+
    while (1)
    {
        // Continually receive data until a return value greater than zero is returned (meaning valid data has been read)
        // Note: Remember to release and take the semaphore again so you've still able to send data
        GameState_t tempGameState;
        _i32 retVal = NOTHING_RECEIVED;
+       uint32_t polls = 0;
        while(retVal != SUCCESS)
        {
            G8RTOS_WaitSemaphore(&WiFi_Mutex);
            retVal = ReceiveData((uint8_t*)(&tempGameState), sizeof(GameState_t)/sizeof(uint8_t));
            G8RTOS_SignalSemaphore(&WiFi_Mutex);
+           ++polls;
 
            // Sleeping here for 1ms would avoid a deadlock
            G8RTOS_Sleep(1);
        }
 
+       // A packet already waiting on the first poll means a burst is queued up, so drain it at a higher priority
+       if (bursting != (polls == 1))
+       {
+           bursting = (polls == 1);
+           G8RTOS_SetPriority(G8RTOS_GetThreadId(), bursting ? RECEIVEDATA_BURST_PRIO : RECEIVEDATA_PRIO);
+       }
+
        // Empty the received packet
-       G8RTOS_WaitSemaphore(&GameState_Mutex);
+       G8RTOS_AcquireWriteLock(&GameState_Lock);
        gameState = tempGameState;
-       G8RTOS_SignalSemaphore(&GameState_Mutex);
+       G8RTOS_ReleaseWriteLock(&GameState_Lock);
 
        // If the game is done, add EndOfGameClient thread with the highest priority
        if (tempGameState.gameDone) G8RTOS_AddThread(&EndOfGameClient, MAX_PRIO, "End Client");
@@ -181,42 +198,45 @@ void ReadJoystickClient()
  */
 void EndOfGameClient()
 {
+    // Polls at MAX_PRIO, so limit how much of the CPU it can take
+    G8RTOS_SetBudget(G8RTOS_GetThreadId(), SETUP_BUDGET, SETUP_BUDGET_PERIOD, BUDGET_DEMOTE);
+
     // Wait for all semaphores to be released
     G8RTOS_WaitSemaphore(&LED_Mutex);
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
     G8RTOS_WaitSemaphore(&WiFi_Mutex);
     G8RTOS_WaitSemaphore(&SpecificPlayerInfo_Mutex);
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
+    G8RTOS_AcquireWriteLock(&GameState_Lock);
 
-    // Kill all other threads
-    G8RTOS_KillAllOtherThreads();
+    // Kill all other game threads
+    G8RTOS_KillGroup(GAME_SESSION_GROUP);
 
     // Re-initialize semaphores
     G8RTOS_InitSemaphore(&LED_Mutex, 1);
-    G8RTOS_InitSemaphore(&LCD_Mutex, 1);
     G8RTOS_InitSemaphore(&WiFi_Mutex, 1);
     G8RTOS_InitSemaphore(&SpecificPlayerInfo_Mutex, 1);
-    G8RTOS_InitSemaphore(&GameState_Mutex, 1);
+    G8RTOS_InitRWLock(&GameState_Lock, true);
 
-    // Clear screen with winner's color
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    if (gameState.winner == TOP) LCD_Clear(gameState.players[TOP].color);
-    else LCD_Clear(gameState.players[BOTTOM].color);
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
+    // Clear screen with winner's color, after any frame the killed threads queued
+    if (gameState.winner == TOP) LCDQueue_Clear(gameState.players[TOP].color);
+    else LCDQueue_Clear(gameState.players[BOTTOM].color);
+    LCDQueue_Flush();
 
     // Wait for host to restart game
     while (gameState.gameDone)
     {
-        // Wait for server response
+        // Wait for server response, sleeping between polls so the render thread gets to run
         GameState_t tempGameState;
         G8RTOS_WaitSemaphore(&WiFi_Mutex);
-        while( ReceiveData((uint8_t*)(&tempGameState), sizeof(GameState_t)/sizeof(uint8_t)) == NOTHING_RECEIVED);
+        while( ReceiveData((uint8_t*)(&tempGameState), sizeof(GameState_t)/sizeof(uint8_t)) == NOTHING_RECEIVED)
+        {
+            G8RTOS_Sleep(EOG_CLIENT_POLL_SLEEP);
+        }
         G8RTOS_SignalSemaphore(&WiFi_Mutex);
 
         // Empty the received packet
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireWriteLock(&GameState_Lock);
         gameState=tempGameState;
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseWriteLock(&GameState_Lock);
     }
 
     // Add all threads back and restart game variables
@@ -241,12 +261,18 @@ void EndOfGameClient()
  */
 void CreateGame()
 {
+    // Polls at MAX_PRIO, so limit how much of the CPU it can take
+    G8RTOS_SetBudget(G8RTOS_GetThreadId(), SETUP_BUDGET, SETUP_BUDGET_PERIOD, BUDGET_DEMOTE);
+
+    // The game threads added from here on start in the game session group
+    G8RTOS_SetThreadGroup(G8RTOS_GetThreadId(), GAME_SESSION_GROUP);
+
     // Temp variables to prevent hold-and-wait condition
     GameState_t tempGameState;
     SpecificPlayerInfo_t tempClientInfo;
 
     // Initializes the players
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
+    G8RTOS_AcquireWriteLock(&GameState_Lock);
     // Host SpecificPlayerInfo
     gameState.player.IP_address = CONFIG_IP;
     gameState.player.playerNumber = BOTTOM;
@@ -276,7 +302,7 @@ void CreateGame()
     gameState.overallScores[BOTTOM] = 0;
     gameState.overallScores[TOP] = 0;
 
-    G8RTOS_SignalSemaphore(&GameState_Mutex);
+    G8RTOS_ReleaseWriteLock(&GameState_Lock);
 
     // Red LED = No connection
     G8RTOS_WaitSemaphore(&LED_Mutex);
@@ -293,11 +319,11 @@ void CreateGame()
     G8RTOS_SignalSemaphore(&SpecificPlayerInfo_Mutex);
 
     // Update Host SpecificPlayerInfo
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
+    G8RTOS_AcquireWriteLock(&GameState_Lock);
     gameState.player.joined = 1;
     gameState.player.acknowledge = 1;
     tempGameState = gameState;
-    G8RTOS_SignalSemaphore(&GameState_Mutex);
+    G8RTOS_ReleaseWriteLock(&GameState_Lock);
     // Send new game state
     G8RTOS_WaitSemaphore(&WiFi_Mutex);
     SendData((uint8_t*)(&tempGameState), HOST_IP_ADDR, sizeof(GameState_t)/sizeof(uint8_t));
@@ -343,12 +369,15 @@ void CreateGame()
  */
 void SendDataToClient()
 {
+    // Runs every SENDDATA_PERIOD ms, so the kernel can report how late it runs
+    G8RTOS_SetPeriodic(SENDDATA_PERIOD, SENDDATA_PERIOD);
+
     while (1)
     {
         // Fill packet for client
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireReadLock(&GameState_Lock);
         GameState_t tempGameState = gameState;
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseReadLock(&GameState_Lock);
 
         // Send packet
         G8RTOS_WaitSemaphore(&WiFi_Mutex);
@@ -358,9 +387,9 @@ void SendDataToClient()
         // If game is done, add EndOfGameHost thread with highest priority
         if (tempGameState.gameDone) G8RTOS_AddThread(&EndOfGameHost, MAX_PRIO, "EOG Host");
 
-        // Sleep for 16ms (found experimentally to be a good amount of time for synchronization)
+        // Wait for the next period (found experimentally to be a good amount of time for synchronization)
         // Was previously 5ms, but this led to large buffers and an unplayable game
-        G8RTOS_Sleep(10);
+        G8RTOS_WaitForNextPeriod();
     }
 }
 
@@ -397,11 +426,11 @@ void ReceiveDataFromClient()
         {
             rawClientCenter = MIN_RAW_PLAYER_CENTER;
         }
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireWriteLock(&GameState_Lock);
 
         // Update the player's current center with the displacement received from the client
         UpdatePlayerDisplacement(&clientInfo);
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseWriteLock(&GameState_Lock);
         G8RTOS_SignalSemaphore(&SpecificPlayerInfo_Mutex);
 
         // Sleep for 1ms (again found experimentally)
@@ -416,15 +445,34 @@ void ReceiveDataFromClient()
 void GenerateBall()
 {
     uint16_t numBallsTemp;
+    bool steady = false;
 
     while (1)
     {
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireReadLock(&GameState_Lock);
         numBallsTemp = gameState.numberOfBalls;
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseReadLock(&GameState_Lock);
+
+        // With every ball in play there is nothing to generate, so step aside until one goes out
+        if (steady != (numBallsTemp >= MAX_NUM_OF_BALLS))
+        {
+            steady = (numBallsTemp >= MAX_NUM_OF_BALLS);
+            G8RTOS_SetPriority(G8RTOS_GetThreadId(), steady ? GENBALL_STEADY_PRIO : GENBALL_PRIO);
+        }
 
-        // Adds another MoveBall thread if the number of balls is less than the max
-        if (numBallsTemp < MAX_NUM_OF_BALLS) G8RTOS_AddThread(&MoveBall, MOVEBALL_PRIO, "move ball");
+        // Adds another MoveBall coroutine if the number of balls is less than the max
+        if (numBallsTemp < MAX_NUM_OF_BALLS)
+        {
+            G8RTOS_AcquireWriteLock(&GameState_Lock);
+            Ball_t* ball = SpawnBall();
+            if (ball != NULL && G8RTOS_AddCoroutine(&MoveBall, ball) == NULL)
+            {
+                // No coroutine to move it, so the ball never enters play
+                ball->alive = false;
+                --(gameState.numberOfBalls);
+            }
+            G8RTOS_ReleaseWriteLock(&GameState_Lock);
+        }
 
         // Sleeps proportional to the number of balls currently in play
         G8RTOS_Sleep(1000 * numBallsTemp + 1);
@@ -452,9 +500,9 @@ void ReadJoystickHost()
         js_y_data *= -1;
 
         // Change self.displacement accordingly (you can experiment with how much you want to scale the ADC value)
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireWriteLock(&GameState_Lock);
         gameState.player.displacement = js_x_data;
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseWriteLock(&GameState_Lock);
 
         rawHostCenter += js_x_data;
         if (rawHostCenter > MAX_RAW_PLAYER_CENTER)
@@ -471,20 +519,21 @@ void ReadJoystickHost()
 
         /* Then add the displacement to the bottom player in the list of players (general list that sent to the
          * client and used for drawing) i.e. players[0].position += self.displacement */
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireWriteLock(&GameState_Lock);
         UpdatePlayerDisplacement(&gameState.player);
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseWriteLock(&GameState_Lock);
     }
 }
 
 /*
- * Thread to move a single ball
+ * Spawns a ball in the first free slot with a random position and velocity
+ * NOTE - MUST BE HOLDING THE GameState LOCK FOR WRITING WHEN CALLING THIS FUNCTION
+ * Returns: the new ball, or NULL if every slot is in use
  */
-void MoveBall()
+Ball_t* SpawnBall()
 {
     // Go through array of balls and find one that's not alive
     int curr = -1;
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
     for (int i = 0; i < MAX_NUM_OF_BALLS; ++i)
     {
         if (!gameState.balls[i].alive)
@@ -494,13 +543,7 @@ void MoveBall()
         }
     }
 
-    // Bug !
-    if (curr == -1)
-    {
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
-        G8RTOS_KillSelf();
-        while(1);
-    }
+    if (curr == -1) return NULL;
 
     // Once found, initialize random position and X and Y velocities, as well as color and alive attributes
     gameState.balls[curr].alive = true;
@@ -514,47 +557,58 @@ void MoveBall()
 
     ++(gameState.numberOfBalls);
 
-    G8RTOS_SignalSemaphore(&GameState_Mutex);
+    return &gameState.balls[curr];
+}
+
+/*
+ * Coroutine to move a single ball
+ *  - Runs on the coroutine host thread's stack, with the ball it moves as its context
+ */
+G8RTOS_Coroutine_Status MoveBall(coroutine_t* co)
+{
+    Ball_t* ball = (Ball_t*)co->context;
+
+    CO_BEGIN(co);
 
     while (1)
     {
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
+        G8RTOS_AcquireWriteLock(&GameState_Lock);
 
         // Move the ball in its current direction according to its velocity
-        gameState.balls[curr].currentCenterX += gameState.balls[curr].velocityX;
-        gameState.balls[curr].currentCenterY += gameState.balls[curr].velocityY;
+        ball->currentCenterX += ball->velocityX;
+        ball->currentCenterY += ball->velocityY;
 
         // Check for 3 scenarios - (1) collision with a wall, (2) collision with paddle, or (3) past paddle
 
         // (1) If collision with wall occurs, flip x velocity and move ball in-bounds
-        if (gameState.balls[curr].currentCenterX - BALL_SIZE_D2 < ARENA_MIN_X)
+        if (ball->currentCenterX - BALL_SIZE_D2 < ARENA_MIN_X)
         {
-            gameState.balls[curr].currentCenterX = ARENA_MIN_X + (BALL_SIZE_D2 * 2);
-            gameState.balls[curr].velocityX *= -1;
+            ball->currentCenterX = ARENA_MIN_X + (BALL_SIZE_D2 * 2);
+            ball->velocityX *= -1;
         }
-        else if (gameState.balls[curr].currentCenterX + BALL_SIZE_D2 > ARENA_MAX_X)
+        else if (ball->currentCenterX + BALL_SIZE_D2 > ARENA_MAX_X)
         {
-            gameState.balls[curr].currentCenterX = ARENA_MAX_X - (BALL_SIZE_D2 * 2);
-            gameState.balls[curr].velocityX *= -1;
+            ball->currentCenterX = ARENA_MAX_X - (BALL_SIZE_D2 * 2);
+            ball->velocityX *= -1;
         }
 
         // If there is an event with bottom paddle, occurs when the ball is below the bottom paddle's top edge (either scenario 2 or 3 has occurred)
-        if (gameState.balls[curr].currentCenterY + BALL_SIZE_D2 > BOTTOM_PADDLE_EDGE - WIGGLE_ROOM)
+        if (ball->currentCenterY + BALL_SIZE_D2 > BOTTOM_PADDLE_EDGE - WIGGLE_ROOM)
         {
             // (2) If collision with paddle occurs, flip y velocity and move ball to edge of paddle
             // Collision with paddle occurs when ball center within the edges of the paddle
-            if ( (gameState.players[BOTTOM].currentCenter - PADDLE_LEN_D2) < gameState.balls[curr].currentCenterX &&
-                  gameState.balls[curr].currentCenterX < (gameState.players[BOTTOM].currentCenter + PADDLE_LEN_D2) )
+            if ( (gameState.players[BOTTOM].currentCenter - PADDLE_LEN_D2) < ball->currentCenterX &&
+                  ball->currentCenterX < (gameState.players[BOTTOM].currentCenter + PADDLE_LEN_D2) )
             {
-                gameState.balls[curr].currentCenterY = BOTTOM_PADDLE_EDGE - WIGGLE_ROOM - BALL_SIZE_D2;
-                gameState.balls[curr].velocityY *= -1;
-                gameState.balls[curr].color = gameState.players[BOTTOM].color;
+                ball->currentCenterY = BOTTOM_PADDLE_EDGE - WIGGLE_ROOM - BALL_SIZE_D2;
+                ball->velocityY *= -1;
+                ball->color = gameState.players[BOTTOM].color;
             }
             // (3) If the ball passes the boundary edge, adjust score, account for the game possibly ending, and kill self
             // Passing the boundary edge occurs when the ball center is not within the edges of the paddle
             else
             {
-                if (gameState.players[TOP].color == gameState.balls[curr].color)
+                if (gameState.players[TOP].color == ball->color)
                 {
                     ++gameState.LEDScores[TOP];
                     if (gameState.LEDScores[TOP] > MAX_SCORE)
@@ -565,30 +619,29 @@ void MoveBall()
                 }
 
                 --(gameState.numberOfBalls);
-                gameState.balls[curr].alive = false;
+                ball->alive = false;
 
-                G8RTOS_SignalSemaphore(&GameState_Mutex);
-                G8RTOS_KillSelf();
-                while(1);
+                G8RTOS_ReleaseWriteLock(&GameState_Lock);
+                CO_EXIT(co);
             }
         }
         // Else if there is an event with top paddle, occurs when the ball is above the top paddle's bottom edge (either scenario 2 or 3 has occurred)
-        else if (gameState.balls[curr].currentCenterY - BALL_SIZE_D2 < TOP_PADDLE_EDGE + WIGGLE_ROOM)
+        else if (ball->currentCenterY - BALL_SIZE_D2 < TOP_PADDLE_EDGE + WIGGLE_ROOM)
         {
             // (2) If collision with paddle occurs, flip y velocity and move ball to edge of paddle
             // Collision with paddle occurs when ball center within the edges of the paddle
-            if ( (gameState.players[TOP].currentCenter - PADDLE_LEN_D2) < gameState.balls[curr].currentCenterX &&
-                  gameState.balls[curr].currentCenterX < (gameState.players[TOP].currentCenter + PADDLE_LEN_D2) )
+            if ( (gameState.players[TOP].currentCenter - PADDLE_LEN_D2) < ball->currentCenterX &&
+                  ball->currentCenterX < (gameState.players[TOP].currentCenter + PADDLE_LEN_D2) )
             {
-                gameState.balls[curr].currentCenterY = TOP_PADDLE_EDGE + WIGGLE_ROOM + BALL_SIZE_D2;
-                gameState.balls[curr].velocityY *= -1;
-                gameState.balls[curr].color = gameState.players[TOP].color;
+                ball->currentCenterY = TOP_PADDLE_EDGE + WIGGLE_ROOM + BALL_SIZE_D2;
+                ball->velocityY *= -1;
+                ball->color = gameState.players[TOP].color;
             }
             // (3) Else ball passes the boundary edge, adjust score, account for the game possibly ending, and kill self
             // Passing the boundary edge occurs when the ball center is not within the edges of the paddle
             else
             {
-                if (gameState.players[BOTTOM].color == gameState.balls[curr].color)
+                if (gameState.players[BOTTOM].color == ball->color)
                 {
                     ++gameState.LEDScores[BOTTOM];
                     if (gameState.LEDScores[BOTTOM] > MAX_SCORE)
@@ -599,19 +652,20 @@ void MoveBall()
                 }
 
                 --(gameState.numberOfBalls);
-                gameState.balls[curr].alive = false;
+                ball->alive = false;
 
-                G8RTOS_SignalSemaphore(&GameState_Mutex);
-                G8RTOS_KillSelf();
-                while(1);
+                G8RTOS_ReleaseWriteLock(&GameState_Lock);
+                CO_EXIT(co);
             }
         }
 
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
+        G8RTOS_ReleaseWriteLock(&GameState_Lock);
 
         // Sleep for 35ms
-        G8RTOS_Sleep(35);
+        CO_SLEEP(co, 35);
     }
+
+    CO_END(co);
 }
 
 /*
@@ -619,37 +673,42 @@ void MoveBall()
  */
 void EndOfGameHost()
 {
+    // Polls at MAX_PRIO, so limit how much of the CPU it can take
+    G8RTOS_SetBudget(G8RTOS_GetThreadId(), SETUP_BUDGET, SETUP_BUDGET_PERIOD, BUDGET_DEMOTE);
+
     // Wait for all the semaphores to be released
     G8RTOS_WaitSemaphore(&LED_Mutex);
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
     G8RTOS_WaitSemaphore(&WiFi_Mutex);
     G8RTOS_WaitSemaphore(&SpecificPlayerInfo_Mutex);
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
+    G8RTOS_AcquireWriteLock(&GameState_Lock);
 
-    // Kill all other threads
-    G8RTOS_KillAllOtherThreads();
+    // Kill all other game threads
+    G8RTOS_KillGroup(GAME_SESSION_GROUP);
+    G8RTOS_KillAllCoroutines();
 
     // Re-initialize semaphores
     G8RTOS_InitSemaphore(&LED_Mutex, 1);
-    G8RTOS_InitSemaphore(&LCD_Mutex, 1);
     G8RTOS_InitSemaphore(&WiFi_Mutex, 1);
     G8RTOS_InitSemaphore(&SpecificPlayerInfo_Mutex, 1);
-    G8RTOS_InitSemaphore(&GameState_Mutex, 1);
+    G8RTOS_InitRWLock(&GameState_Lock, true);
 
     // Clear screen with winner's color
+    uint16_t winnerColor;
     if (gameState.winner == TOP)
     {
-        LCD_Clear(PLAYER_BLUE);
+        winnerColor = PLAYER_BLUE;
         ++gameState.overallScores[TOP];
     }
     else
     {
-        LCD_Clear(PLAYER_RED);
+        winnerColor = PLAYER_RED;
         ++gameState.overallScores[BOTTOM];
     }
+    LCDQueue_Clear(winnerColor);
 
     // Print some message that waits for the host's action to start a new game
-    LCD_Text(12, 100, "Press left to play again as the host.", LCD_WHITE);
+    LCDQueue_Text(12, 100, "Press left to play again as the host.", LCD_WHITE, winnerColor);
+    LCDQueue_Flush();
 
     // Port should still be initialized from the original HostVsClient decision
     // Waits for the host's button press
@@ -658,7 +717,7 @@ void EndOfGameHost()
     {
         // Send EOG packet
         SendData((uint8_t*)(&gameState), HOST_IP_ADDR, sizeof(GameState_t)/sizeof(uint8_t));
-        DelayMs(16);
+        G8RTOS_Sleep(EOG_HOST_POLL_SLEEP);
     }
     P5->IFG &= ~BIT5;
 
@@ -724,46 +783,25 @@ void IdleThread()
  */
 void DrawObjects()
 {
+    // Redraws every DRAWOBJ_PERIOD ms, so the kernel can report how late frames are
+    G8RTOS_SetPeriodic(DRAWOBJ_PERIOD, DRAWOBJ_PERIOD);
+
     while (1)
     {
-        GameState_t tempGameState;
-        G8RTOS_WaitSemaphore(&GameState_Mutex);
-        tempGameState = gameState;
-        G8RTOS_SignalSemaphore(&GameState_Mutex);
-
-        // Draw and/or update balls (you'll need a way to tell whether to draw a new ball, or update its position (i.e. if a new ball has just been created - hence the alive attribute in the Ball_t struct.
-        for (int i = 0; i < MAX_NUM_OF_BALLS; i++)
+        // Hand a copy of the game state to the render thread; if it is still drawing both earlier frames, skip this one
+        if (!frameBusy[nextFrame])
         {
-            if (!prevBalls[i].alive)
-            {
-                // Dead ball became alive, should draw new ball
-                if (tempGameState.balls[i].alive)
-                {
-                    DrawBallOnScreen(&(prevBalls[i]), &(tempGameState.balls[i]));
-                }
-            }
-            else
-            {
-                // alive ball is still alive, update ball
-                if (tempGameState.balls[i].alive)
-                {
-                    UpdateBallOnScreen(&(prevBalls[i]), &(tempGameState.balls[i]));
-                }
-                // alive ball is dead, erase the ball
-                else
-                {
-                    DeleteBallOnScreen(&(prevBalls[i]));
-                }
-            }
+            frameBusy[nextFrame] = true;
+            G8RTOS_AcquireReadLock(&GameState_Lock);
+            frameStates[nextFrame] = gameState;
+            G8RTOS_ReleaseReadLock(&GameState_Lock);
 
-            prevBalls[i].alive = tempGameState.balls[i].alive;
+            LCDQueue_Call(&DrawFrame, &frameStates[nextFrame]);
+            nextFrame ^= 1;
         }
 
-        // Update players
-        for(int i = 0; i < MAX_NUM_OF_PLAYERS; ++i) UpdatePlayerOnScreen(&prevPlayers[i], &(tempGameState.players[i]));
-
-        // Sleep for 20ms (reasonable refresh rate)
-        G8RTOS_Sleep(20);
+        // Wait for the next frame (20ms is a reasonable refresh rate)
+        G8RTOS_WaitForNextPeriod();
     }
 }
 
@@ -787,23 +825,23 @@ void MoveLEDs()
  */
 void HostVsClient()
 {
+    // Polls at MAX_PRIO, so limit how much of the CPU it can take
+    G8RTOS_SetBudget(G8RTOS_GetThreadId(), SETUP_BUDGET, SETUP_BUDGET_PERIOD, BUDGET_DEMOTE);
+
     // Initialize semaphores
     G8RTOS_InitSemaphore(&LED_Mutex, 1);
-    G8RTOS_InitSemaphore(&LCD_Mutex, 1);
     G8RTOS_InitSemaphore(&WiFi_Mutex, 1);
     G8RTOS_InitSemaphore(&SpecificPlayerInfo_Mutex, 1);
-    G8RTOS_InitSemaphore(&GameState_Mutex, 1);
+    G8RTOS_InitRWLock(&GameState_Lock, true);
 
     // Write message on screen assisting player choice of Host vs. Client
-    LCD_Text(0, 100, "Press left for host and right for client", LCD_WHITE);
+    LCDQueue_Text(0, 100, "Press left for host and right for client", LCD_WHITE, BACK_COLOR);
 
     playerType role = GetPlayerRole();
     if (role == Client) G8RTOS_AddThread(&JoinGame, MAX_PRIO, "join");
     else G8RTOS_AddThread(&CreateGame, MAX_PRIO, "create");
 
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    LCD_Clear(BACK_COLOR);
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
+    LCDQueue_Clear(BACK_COLOR);
 
     G8RTOS_KillSelf();
 }
@@ -856,215 +894,106 @@ playerType GetPlayerRole()
 }
 
 /*
- * Draw players given center X center coordinate
+ * Draws a copy of the game state, queued by DrawObjects
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DrawPlayer(GeneralPlayerInfo_t *player)
+void DrawFrame(void *state)
 {
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    // Bottom player
-    if(player->position == BOTTOM)
-    {
-        LCD_DrawRectangle(player->currentCenter - PADDLE_LEN_D2,
-                          player->currentCenter + PADDLE_LEN_D2,
-                          BOTTOM_PADDLE_EDGE,
-                          ARENA_MAX_Y,
-                          player->color
-        );
-    }
-    // Top player
-    else
+    GameState_t *frame = state;
+
+    // SPI cost of one frame of paddle and ball updates, see BusStats_Snapshot
+    bus_span_t span;
+    BusStats_Begin(&span, "DrawFrame");
+
+    // Submit where every object is now, the renderer only draws what changed since the last frame
+    for (int i = 0; i < MAX_NUM_OF_BALLS; i++)
     {
-        LCD_DrawRectangle(player->currentCenter - PADDLE_LEN_D2,
-                          player->currentCenter + PADDLE_LEN_D2,
-                          ARENA_MIN_Y,
-                          TOP_PADDLE_EDGE,
-                          player->color
-        );
+        if (frame->balls[i].alive) DrawBallOnScreen(i, &(frame->balls[i]));
+        else DeleteBallOnScreen(i);
     }
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
+    for (int i = 0; i < MAX_NUM_OF_PLAYERS; ++i) UpdatePlayerOnScreen(&(frame->players[i]));
+    Renderer_Frame();
+    BusStats_End(&span);
+
+    // The copy can be refilled
+    frameBusy[frame - frameStates] = false;
 }
 
 /*
- * Updates player's paddle based on current and new center
- * (Only redraw the entire paddle when necessary)
+ * Draws the empty arena and the first frame on a cleared screen, queued by InitBoardState
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void UpdatePlayerOnScreen(PrevPlayer_t *prevPlayerIn, GeneralPlayerInfo_t *outPlayer)
+void DrawBoard(void *state)
 {
-    int16_t displacement = outPlayer->currentCenter - prevPlayerIn->Center;
+    // Nothing the renderer drew is left
+    Renderer_Reset(BACK_COLOR);
 
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    // If the displacement is greater than the paddle length, we need to redraw the entire paddle
-    if(abs(displacement) >= PADDLE_LEN)
-    {
-        // Bottom player
-        if(outPlayer->position == BOTTOM)
-        {
-            LCD_DrawRectangle(prevPlayerIn->Center - PADDLE_LEN_D2,
-                              prevPlayerIn->Center + PADDLE_LEN_D2,
-                              BOTTOM_PADDLE_EDGE,
-                              ARENA_MAX_Y,
-                              BACK_COLOR
-            );
-            LCD_DrawRectangle(outPlayer->currentCenter - PADDLE_LEN_D2,
-                              outPlayer->currentCenter + PADDLE_LEN_D2,
-                              BOTTOM_PADDLE_EDGE,
-                              ARENA_MAX_Y,
-                              outPlayer->color
-            );
-        }
-        // Top player
-        else
-        {
-            LCD_DrawRectangle(prevPlayerIn->Center - PADDLE_LEN_D2,
-                              prevPlayerIn->Center + PADDLE_LEN_D2,
-                              ARENA_MIN_Y,
-                              TOP_PADDLE_EDGE,
-                              BACK_COLOR
-            );
-            LCD_DrawRectangle(outPlayer->currentCenter - PADDLE_LEN_D2,
-                              outPlayer->currentCenter + PADDLE_LEN_D2,
-                              ARENA_MIN_Y,
-                              TOP_PADDLE_EDGE,
-                              outPlayer->color
-            );
-        }
-    }
-    // Else, we only need to partially update the paddle
-    else
-    {
-        // Calculate area need to modify
-        int16_t deleteL, deleteR, drawL, drawR;
-        // Move left
-        if(displacement <= 0)
-        {
-            deleteR=prevPlayerIn->Center + PADDLE_LEN_D2;
-            deleteL=deleteR + displacement;
-            drawR=prevPlayerIn->Center - PADDLE_LEN_D2;
-            drawL=drawR + displacement;
-        }
-        // Move right
-        else
-        {
-            deleteL=prevPlayerIn->Center - PADDLE_LEN_D2;
-            deleteR=deleteL + displacement;
-            drawL=prevPlayerIn->Center + PADDLE_LEN_D2;
-            drawR=drawL + displacement;
-        }
+    // Draw two vertical lines, kept by the renderer so paddles passing over them do not wipe them out
+    render_rect_t wall = {ARENA_MIN_X, ARENA_MIN_X, ARENA_MIN_Y, ARENA_MAX_Y};
+    Renderer_Submit(WALL_OBJECT(0), &wall, LCD_WHITE);
+    wall.xMin = wall.xMax = ARENA_MAX_X;
+    Renderer_Submit(WALL_OBJECT(1), &wall, LCD_WHITE);
 
-        // Modify area
-        // Bottom player
-        if(outPlayer->position == BOTTOM)
-        {
-            LCD_DrawRectangle(deleteL,
-                              deleteR,
-                              BOTTOM_PADDLE_EDGE,
-                              ARENA_MAX_Y,
-                              BACK_COLOR
-            );
-            LCD_DrawRectangle(drawL,
-                              drawR,
-                              BOTTOM_PADDLE_EDGE,
-                              ARENA_MAX_Y,
-                              outPlayer->color
-            );
-        }
-        // Top player
-        else
-        {
-            LCD_DrawRectangle(deleteL,
-                              deleteR,
-                              ARENA_MIN_Y,
-                              TOP_PADDLE_EDGE,
-                              BACK_COLOR
-            );
-            LCD_DrawRectangle(drawL,
-                              drawR,
-                              ARENA_MIN_Y,
-                              TOP_PADDLE_EDGE,
-                              outPlayer->color
-            );
-        }
-    }
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
-
-    prevPlayerIn->Center = outPlayer->currentCenter;
+    // Draw player paddles
+    DrawFrame(state);
 }
 
 /*
- * Draw a new ball on screen
+ * Submits the player's paddle to the renderer
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DrawBallOnScreen(PrevBall_t *previousBall, Ball_t *currentBall)
+void UpdatePlayerOnScreen(GeneralPlayerInfo_t *player)
 {
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    // Draw the new ball
-    int16_t drawL, drawR, drawT, drawB;
-    drawL=currentBall->currentCenterX - BALL_SIZE_D2;
-    drawR=currentBall->currentCenterX + BALL_SIZE_D2;
-    drawT=currentBall->currentCenterY - BALL_SIZE_D2;
-    drawB=currentBall->currentCenterY + BALL_SIZE_D2;
-    if(drawL<=ARENA_MIN_X){
-        drawL=ARENA_MIN_X+1;
-        drawR=drawL+BALL_SIZE;
+    render_rect_t paddle;
+    paddle.xMin = player->currentCenter - PADDLE_LEN_D2;
+    paddle.xMax = player->currentCenter + PADDLE_LEN_D2;
+
+    // Bottom player
+    if(player->position == BOTTOM)
+    {
+        paddle.yMin = BOTTOM_PADDLE_EDGE;
+        paddle.yMax = ARENA_MAX_Y;
     }
-    if(drawR>=ARENA_MAX_X){
-        drawR=ARENA_MAX_X-1;
-        drawL=drawR-BALL_SIZE;
+    // Top player
+    else
+    {
+        paddle.yMin = ARENA_MIN_Y;
+        paddle.yMax = TOP_PADDLE_EDGE;
     }
-    LCD_DrawRectangle(drawL,
-                      drawR,
-                      drawT,
-                      drawB,
-                      currentBall->color
-    );
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
-
-    previousBall->CenterX = currentBall->currentCenterX;
-    previousBall->CenterY = currentBall->currentCenterY;
+
+    Renderer_Submit(PADDLE_OBJECT(player->position), &paddle, player->color);
 }
 
 /*
- * Delete a dead ball on screen
+ * Submits a ball to the renderer, kept clear of the arena walls
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DeleteBallOnScreen(PrevBall_t * previousBall)
+void DrawBallOnScreen(uint8_t ballIndex, Ball_t *currentBall)
 {
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    // Delete the old ball
-    int16_t deleteL, deleteR, deleteT, deleteB;
-    deleteL=previousBall->CenterX - BALL_SIZE_D2;
-    deleteR=previousBall->CenterX + BALL_SIZE_D2;
-    deleteT=previousBall->CenterY - BALL_SIZE_D2;
-    deleteB=previousBall->CenterY + BALL_SIZE_D2;
-    if(deleteL<=ARENA_MIN_X){
-        deleteL=ARENA_MIN_X+1;
-        deleteR=deleteL+BALL_SIZE;
+    render_rect_t ball;
+    ball.xMin = currentBall->currentCenterX - BALL_SIZE_D2;
+    ball.xMax = currentBall->currentCenterX + BALL_SIZE_D2;
+    ball.yMin = currentBall->currentCenterY - BALL_SIZE_D2;
+    ball.yMax = currentBall->currentCenterY + BALL_SIZE_D2;
+    if(ball.xMin <= ARENA_MIN_X){
+        ball.xMin = ARENA_MIN_X+1;
+        ball.xMax = ball.xMin+BALL_SIZE;
     }
-    if(deleteR>=ARENA_MAX_X){
-        deleteR=ARENA_MAX_X-1;
-        deleteL=deleteR-BALL_SIZE;
+    if(ball.xMax >= ARENA_MAX_X){
+        ball.xMax = ARENA_MAX_X-1;
+        ball.xMin = ball.xMax-BALL_SIZE;
     }
-    LCD_DrawRectangle(deleteL,
-                      deleteR,
-                      deleteT,
-                      deleteB,
-                      BACK_COLOR
-    );
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
+
+    Renderer_Submit(BALL_OBJECT(ballIndex), &ball, currentBall->color);
 }
 
 /*
- * Function updates ball position on screen
+ * Removes a dead ball from the screen
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-// Note: I commented out the outColor variable because I could not find any use of it
-void UpdateBallOnScreen(PrevBall_t *previousBall, Ball_t *currentBall/*, uint16_t outColor */)
+void DeleteBallOnScreen(uint8_t ballIndex)
 {
-    // Delete the old ball
-    DeleteBallOnScreen(previousBall);
-
-    G8RTOS_WaitSemaphore(&GameState_Mutex);
-    Ball_t tempCurrentBall=*currentBall;
-    G8RTOS_SignalSemaphore(&GameState_Mutex);
-    // Draw the new ball
-    DrawBallOnScreen(previousBall, &tempCurrentBall);
+    Renderer_Hide(BALL_OBJECT(ballIndex));
 }
 
 /*
@@ -1077,26 +1006,19 @@ void UpdateOverallScore()
     snprintf(player0ScoreStr, 3, "%02d", gameState.overallScores[0]);
     snprintf(player1ScoreStr, 3, "%02d", gameState.overallScores[1]);
 
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-
-    // Clear score region
-    LCD_DrawRectangle(TOP_SCORE_MIN_X, TOP_SCORE_MAX_X, TOP_SCORE_MIN_Y, TOP_SCORE_MAX_Y, BACK_COLOR);
-    LCD_DrawRectangle(BOTTOM_SCORE_MIN_X, BOTTOM_SCORE_MAX_X, BOTTOM_SCORE_MIN_Y, BOTTOM_SCORE_MAX_Y, BACK_COLOR);
-
+    // The text is drawn with its background, so it overwrites the old score without a clear
     // if player0 is BOTTOM, player1 is TOP
     if (gameState.players[0].position == BOTTOM)
     {
-        LCD_Text(BOTTOM_SCORE_MIN_X, BOTTOM_SCORE_MIN_Y, player0ScoreStr, gameState.players[0].color);
-        LCD_Text(TOP_SCORE_MIN_X, TOP_SCORE_MIN_Y, player1ScoreStr, gameState.players[1].color);
+        LCDQueue_Text(BOTTOM_SCORE_MIN_X, BOTTOM_SCORE_MIN_Y, player0ScoreStr, gameState.players[0].color, BACK_COLOR);
+        LCDQueue_Text(TOP_SCORE_MIN_X, TOP_SCORE_MIN_Y, player1ScoreStr, gameState.players[1].color, BACK_COLOR);
     }
     // player0 is TOP, player1 is BUTTOM
     else
     {
-        LCD_Text(TOP_SCORE_MIN_X, TOP_SCORE_MIN_Y, player0ScoreStr, gameState.players[0].color);
-        LCD_Text(BOTTOM_SCORE_MIN_X, BOTTOM_SCORE_MIN_Y, player1ScoreStr, gameState.players[1].color);
+        LCDQueue_Text(TOP_SCORE_MIN_X, TOP_SCORE_MIN_Y, player0ScoreStr, gameState.players[0].color, BACK_COLOR);
+        LCDQueue_Text(BOTTOM_SCORE_MIN_X, BOTTOM_SCORE_MIN_Y, player1ScoreStr, gameState.players[1].color, BACK_COLOR);
     }
-
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
 }
 
 /*
@@ -1133,20 +1055,18 @@ void UpdateLEDScore()
  */
 void InitBoardState()
 {
-    G8RTOS_WaitSemaphore(&LCD_Mutex);
-    // Clear background
-    LCD_Clear(BACK_COLOR);
-    // Draw two vertical lines
-    for(int i = ARENA_MIN_Y; i <= ARENA_MAX_Y; i++)
-    {
-        LCD_SetPoint(ARENA_MIN_X, i, LCD_WHITE);
-        LCD_SetPoint(ARENA_MAX_X, i, LCD_WHITE);
-    }
-    G8RTOS_SignalSemaphore(&LCD_Mutex);
-
-    // Draw player paddles
-    DrawPlayer(&(gameState.players[0]));
-    DrawPlayer(&(gameState.players[1]));
+    // Let the last game's frames finish, a DrawObjects killed mid-handoff may have left a copy marked busy
+    LCDQueue_Flush();
+    frameBusy[1] = false;
+    nextFrame = 1;
+
+    // Clear background, then draw the arena and player paddles
+    frameBusy[0] = true;
+    G8RTOS_AcquireReadLock(&GameState_Lock);
+    frameStates[0] = gameState;
+    G8RTOS_ReleaseReadLock(&GameState_Lock);
+    LCDQueue_Clear(BACK_COLOR);
+    LCDQueue_Call(&DrawBoard, &frameStates[0]);
 
     // Draw scores
     UpdateOverallScore();
@@ -1158,8 +1078,8 @@ void InitBoardState()
  */
 void AddClientGameThreads()
 {
-    G8RTOS_AddThread(&ReadJoystickClient, JOYSTICK_PRIO, "joystick");
-    G8RTOS_AddThread(&SendDataToHost, SENDDATA_PRIO, "send");
+    G8RTOS_AddThreadEx(&ReadJoystickClient, JOYSTICK_PRIO, GROUP_PREEMPT_THRESHOLD, GROUP_TIME_SLICE, "joystick", NULL);
+    G8RTOS_AddThreadEx(&SendDataToHost, SENDDATA_PRIO, GROUP_PREEMPT_THRESHOLD, GROUP_TIME_SLICE, "send", NULL);
     G8RTOS_AddThread(&ReceiveDataFromHost, RECEIVEDATA_PRIO, "receive");
 }
 
@@ -1169,8 +1089,9 @@ void AddClientGameThreads()
 void AddHostGameThreads()
 {
     G8RTOS_AddThread(&GenerateBall, GENBALL_PRIO, "gen ball");
-    G8RTOS_AddThread(&ReadJoystickHost, JOYSTICK_PRIO, "joystick");
-    G8RTOS_AddThread(&SendDataToClient, SENDDATA_PRIO, "send data");
+    G8RTOS_AddThreadEx(&G8RTOS_CoroutineHost, MOVEBALL_PRIO, GROUP_PREEMPT_THRESHOLD, GROUP_TIME_SLICE, "ball coroutines", NULL);
+    G8RTOS_AddThreadEx(&ReadJoystickHost, JOYSTICK_PRIO, GROUP_PREEMPT_THRESHOLD, GROUP_TIME_SLICE, "joystick", NULL);
+    G8RTOS_AddThreadEx(&SendDataToClient, SENDDATA_PRIO, GROUP_PREEMPT_THRESHOLD, GROUP_TIME_SLICE, "send data", NULL);
     G8RTOS_AddThread(&ReceiveDataFromClient, RECEIVEDATA_PRIO, "rcv data");
 }
 
@@ -1186,7 +1107,7 @@ void AddCommonGameThreads()
 
 /*
  * Updates a particular player's displacement, given it's SpecificPlayerInfo_t struct.
- * NOTE - MUST BE HOLDING THE GameState MUTEX AND/OR THE CORRESPONDING SpecificPlayerInfo MUTEX WHEN CALLING THIS FUNCTION
+ * NOTE - MUST BE HOLDING THE GameState LOCK FOR WRITING AND/OR THE CORRESPONDING SpecificPlayerInfo MUTEX WHEN CALLING THIS FUNCTION
  */
 void UpdatePlayerDisplacement(SpecificPlayerInfo_t *player)
 {
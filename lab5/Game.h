@@ -15,11 +15,17 @@
 #include "G8RTOS/G8RTOS.h"
 #include "cc3100_usage.h"
 #include "LCDLib.h"
+#include "BusStats.h"
+#include "Renderer.h"
+#include "LCDQueue.h"
 /*********************************************** Includes ********************************************************************/
 
 /*********************************************** Externs ********************************************************************/
 
-semaphore_t LED_Mutex, LCD_Mutex, WiFi_Mutex, SpecificPlayerInfo_Mutex, GameState_Mutex;
+semaphore_t LED_Mutex, WiFi_Mutex, SpecificPlayerInfo_Mutex;
+
+/* Many threads only read the game state, so it is guarded by a reader-writer lock */
+rwlock_t GameState_Lock;
 
 /*********************************************** Externs ********************************************************************/
 
@@ -101,6 +107,11 @@ semaphore_t LED_Mutex, LCD_Mutex, WiFi_Mutex, SpecificPlayerInfo_Mutex, GameStat
 #define BACK_COLOR                  LCD_BLACK
 #define INIT_BALL_COLOR             LCD_WHITE
 
+/* Renderer slots of the objects, bottom to top: arena walls, balls, paddles */
+#define WALL_OBJECT(side)           (side)
+#define BALL_OBJECT(index)          (2 + (index))
+#define PADDLE_OBJECT(position)     (2 + MAX_NUM_OF_BALLS + (position))
+
 /* Offset for printing player to avoid blips from left behind ball */
 #define PRINT_OFFSET                10
 
@@ -118,6 +129,33 @@ semaphore_t LED_Mutex, LCD_Mutex, WiFi_Mutex, SpecificPlayerInfo_Mutex, GameStat
 #define RECEIVEDATA_PRIO            45
 #define MOVELED_PRIO                20
 #define DRAWOBJ_PRIO                10
+#define RENDER_PRIO                 12
+
+/* Priorities the receive and generate ball threads switch to at run time */
+#define RECEIVEDATA_BURST_PRIO      15
+#define GENBALL_STEADY_PRIO         200
+
+/* The priority 50 threads (ball coroutines, joystick, send) cooperate: none of them preempts another,
+ * only receive and higher still preempt them, and each runs up to GROUP_TIME_SLICE ms before rotating */
+#define GROUP_PREEMPT_THRESHOLD     (RECEIVEDATA_PRIO + 1)
+#define GROUP_TIME_SLICE            10
+
+/* The setup threads (host vs client, join, create, end of game) poll at MAX_PRIO, so each only gets
+ * SETUP_BUDGET ms of every SETUP_BUDGET_PERIOD ms at that priority before being demoted */
+#define SETUP_BUDGET                5
+#define SETUP_BUDGET_PERIOD         10
+
+/* Time the end of game threads sleep between polls: the client for the host's restart packet,
+ * the host for its button while it resends the end of game packet */
+#define EOG_CLIENT_POLL_SLEEP       1
+#define EOG_HOST_POLL_SLEEP         16
+
+/* Every thread of a running game, so the end of game can kill them together */
+#define GAME_SESSION_GROUP          1
+
+/* Periods (and deadlines) of the threads registered as periodic, in ms */
+#define SENDDATA_PERIOD             10
+#define DRAWOBJ_PERIOD              20
 
 /* Adding resolution to joystick */
 #define PLAYER_CENTER_SHIFT_AMOUNT  11
@@ -196,32 +234,18 @@ typedef struct
 } GameState_t;
 #pragma pack ( pop )
 
-/*
- * Struct of all the previous ball locations, only changed by self for drawing!
- */
-typedef struct
-{
-    int16_t CenterX;
-    int16_t CenterY;
-    bool alive;
-} PrevBall_t;
-
-/*
- * Struct of all the previous players locations, only changed by self for drawing
- */
-typedef struct
-{
-    int16_t Center;
-} PrevPlayer_t;
 /*********************************************** Data Structures ********************************************************************/
 
 /*********************************************** Global Variables ********************************************************************/
 SpecificPlayerInfo_t clientInfo;
 GameState_t gameState;
-PrevBall_t prevBalls[MAX_NUM_OF_BALLS];
-PrevPlayer_t prevPlayers[MAX_NUM_OF_PLAYERS];
 
 int32_t rawHostCenter, rawClientCenter;
+
+/* Copies of the game state handed to the render thread, one can be drawn while the next is filled */
+GameState_t frameStates[2];
+volatile bool frameBusy[2];
+uint8_t nextFrame;
 /*********************************************** Global Variables ********************************************************************/
 
 /*********************************************** Client Threads *********************************************************************/
@@ -280,9 +304,15 @@ void GenerateBall();
 void ReadJoystickHost();
 
 /*
- * Thread to move a single ball
+ * Spawns a ball in the first free slot with a random position and velocity
+ * NOTE - MUST BE HOLDING THE GameState LOCK FOR WRITING WHEN CALLING THIS FUNCTION
+ */
+Ball_t* SpawnBall();
+
+/*
+ * Coroutine to move a single ball, run by the coroutine host thread
  */
-void MoveBall();
+G8RTOS_Coroutine_Status MoveBall(coroutine_t* co);
 
 /*
  * End of game for the host
@@ -323,30 +353,34 @@ void HostVsClient();
 playerType GetPlayerRole();
 
 /*
- * Draw players given center X center coordinate
+ * Draws a copy of the game state, queued by DrawObjects
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DrawPlayer(GeneralPlayerInfo_t * player);
+void DrawFrame(void * state);
 
 /*
- * Updates player's paddle based on current and new center
+ * Draws the empty arena and the first frame on a cleared screen, queued by InitBoardState
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void UpdatePlayerOnScreen(PrevPlayer_t * prevPlayerIn, GeneralPlayerInfo_t * outPlayer);
+void DrawBoard(void * state);
 
 /*
- * Draw a new ball on screen
+ * Submits the player's paddle to the renderer
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DrawBallOnScreen(PrevBall_t * previousBall, Ball_t * currentBall);
+void UpdatePlayerOnScreen(GeneralPlayerInfo_t * player);
 
 /*
- * Delete a dead ball on screen
+ * Submits a ball to the renderer
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-void DeleteBallOnScreen(PrevBall_t * previousBall);
+void DrawBallOnScreen(uint8_t ballIndex, Ball_t * currentBall);
 
 /*
- * Function updates ball position on screen
+ * Removes a dead ball from the screen
+ * NOTE - ONLY CALLED FROM THE RENDER THREAD
  */
-// Note: I commented out the outColor variable because I could not find any use of it
-void UpdateBallOnScreen(PrevBall_t * previousBall, Ball_t * currentBall/*, uint16_t outColor */);
+void DeleteBallOnScreen(uint8_t ballIndex);
 
 /*
  * Function updates overall scores
@@ -380,7 +414,7 @@ void AddHostGameThreads();
 
 /*
  * Updates a particular player's displacement, given it's SpecificPlayerInfo_t struct.
- * NOTE - MUST BE HOLDING THE GAMESTATE MUTEX AND/OR THE CORRESPONDING SpecificPlayerInfo MUTEX WHEN CALLING THIS FUNCTION
+ * NOTE - MUST BE HOLDING THE GAMESTATE LOCK FOR WRITING AND/OR THE CORRESPONDING SpecificPlayerInfo MUTEX WHEN CALLING THIS FUNCTION
  */
 void UpdatePlayerDisplacement(SpecificPlayerInfo_t *player);
 
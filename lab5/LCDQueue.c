@@ -0,0 +1,354 @@
+/*
+ * LCDQueue.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "G8RTOS/G8RTOS.h"
+#include "G8RTOS/G8RTOS_CriticalSection.h"
+#include "LCDLib.h"
+#include "LCDQueue.h"
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Command ring, slot n % LCDQUEUE_LENGTH holds the n-th command queued */
+static lcd_command_t ring[LCDQUEUE_LENGTH];
+
+G8RTOS_STATIC_ASSERT(sizeof(ring) <= LCDQUEUE_RAM_BYTES, lcdqueue_ram_budget);
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*
+ * Commands queued and commands finished, both counting up forever
+ *  - Head only moves inside a critical section, Tail only in the render thread
+ */
+static volatile uint32_t Head;
+static volatile uint32_t Tail;
+
+/*
+ * Wakes the render thread; signalled once per command queued
+ */
+static semaphore_t Pending;
+
+/*
+ * Running totals
+ */
+static lcdqueue_stats_t Stats;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Copies a command into the ring, sleeping while the ring is full
+ */
+static void Enqueue(const lcd_command_t* command)
+{
+    while (1)
+    {
+        int32_t IBit_State = StartCriticalSection();
+        if (Head - Tail < LCDQUEUE_LENGTH)
+        {
+            ring[Head % LCDQUEUE_LENGTH] = *command;
+            ++Head;
+            ++Stats.queued;
+            EndCriticalSection(IBit_State);
+            break;
+        }
+        ++Stats.stalls;
+        EndCriticalSection(IBit_State);
+
+        G8RTOS_Sleep(LCDQUEUE_RETRY_SLEEP);
+    }
+
+    G8RTOS_SignalSemaphore(&Pending);
+}
+
+/*
+ * Whether a command paints every pixel of its bounds (text only when it stays on
+ * one line, bitmaps only without transparency, never lines, circles and the console)
+ */
+static bool IsOpaque(const lcd_command_t* command)
+{
+    if (command->type == LCD_COMMAND_CALL ||
+        command->type == LCD_COMMAND_LINE || command->type == LCD_COMMAND_CIRCLE ||
+        command->type == LCD_COMMAND_CONSOLE) return false;
+    if (command->type == LCD_COMMAND_BITMAP && (command->data.bitmap->flags & LCD_BITMAP_TRANSPARENT)) return false;
+    return command->xEnd < MAX_SCREEN_X && command->yEnd < MAX_SCREEN_Y;
+}
+
+/*
+ * Whether a later command of the batch paints over all of a command
+ * Param "index": the command, counted like Head and Tail
+ * Param "end": end of the batch
+ */
+static bool IsPaintedOver(uint32_t index, uint32_t end)
+{
+    const lcd_command_t* command = &ring[index % LCDQUEUE_LENGTH];
+    if (!IsOpaque(command)) return false;
+
+    for (uint32_t later = index + 1; later != end; ++later)
+    {
+        const lcd_command_t* cover = &ring[later % LCDQUEUE_LENGTH];
+
+        // a call may depend on what was drawn before it
+        if (cover->type == LCD_COMMAND_CALL) return false;
+
+        if (IsOpaque(cover) &&
+            cover->xStart <= command->xStart && cover->xEnd >= command->xEnd &&
+            cover->yStart <= command->yStart && cover->yEnd >= command->yEnd)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void Execute(lcd_command_t* command)
+{
+    switch (command->type)
+    {
+    case LCD_COMMAND_RECT:
+        LCD_DrawRectangle(command->xStart, command->xEnd, command->yStart, command->yEnd, command->color);
+        break;
+    case LCD_COMMAND_TEXT:
+        LCD_Text(command->xStart, command->yStart, (uint8_t*)command->data.text, command->color, command->bkColor);
+        break;
+    case LCD_COMMAND_PIXELS:
+        LCD_DrawPixels(command->xStart, command->xEnd, command->yStart, command->yEnd, command->data.pixels);
+        break;
+    case LCD_COMMAND_BITMAP:
+        LCD_DrawBitmap(command->xStart, command->yStart, command->data.bitmap);
+        break;
+    case LCD_COMMAND_LINE:
+        LCD_DrawLine(command->data.line.x0, command->data.line.y0, command->data.line.x1, command->data.line.y1, command->color);
+        break;
+    case LCD_COMMAND_CIRCLE:
+        LCD_DrawCircle(command->data.circle.xCenter, command->data.circle.yCenter, command->data.circle.radius, command->color, command->data.circle.filled);
+        break;
+    case LCD_COMMAND_CONSOLE:
+        LCD_ConsolePrint(command->data.text);
+        break;
+    case LCD_COMMAND_CALL:
+        command->data.call.function(command->data.call.arg);
+        break;
+    }
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Empties the queue, before the render thread is added
+ */
+void LCDQueue_Init()
+{
+    Head = 0;
+    Tail = 0;
+    G8RTOS_InitSemaphore(&Pending, 0);
+}
+
+/*
+ * Render thread, runs the queued commands in order
+ */
+void LCDQueue_RenderThread()
+{
+    while (1)
+    {
+        G8RTOS_WaitSemaphore(&Pending);
+
+        // everything queued so far is one batch (a wake-up may find it already drawn)
+        uint32_t end = Head;
+        while (Tail != end)
+        {
+            if (IsPaintedOver(Tail, end)) ++Stats.skipped;
+            else
+            {
+                Execute(&ring[Tail % LCDQUEUE_LENGTH]);
+                ++Stats.executed;
+            }
+
+            // frees the slot
+            ++Tail;
+        }
+    }
+}
+
+/*
+ * Queues a filled rectangle
+ */
+void LCDQueue_Rect(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, uint16_t color)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_RECT;
+    command.xStart = xStart;
+    command.xEnd = xEnd;
+    command.yStart = yStart;
+    command.yEnd = yEnd;
+    command.color = color;
+    Enqueue(&command);
+}
+
+/*
+ * Queues a horizontal line
+ */
+void LCDQueue_HLine(uint16_t xStart, uint16_t xEnd, uint16_t y, uint16_t color)
+{
+    LCDQueue_Rect(xStart, xEnd, y, y, color);
+}
+
+/*
+ * Queues a vertical line
+ */
+void LCDQueue_VLine(uint16_t x, uint16_t yStart, uint16_t yEnd, uint16_t color)
+{
+    LCDQueue_Rect(x, x, yStart, yEnd, color);
+}
+
+/*
+ * Queues a line between two points (see LCD_DrawLine)
+ */
+void LCDQueue_Line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_LINE;
+    command.data.line.x0 = x0;
+    command.data.line.y0 = y0;
+    command.data.line.x1 = x1;
+    command.data.line.y1 = y1;
+    command.color = color;
+    Enqueue(&command);
+}
+
+/*
+ * Queues a circle outline or disc (see LCD_DrawCircle)
+ */
+void LCDQueue_Circle(int16_t xCenter, int16_t yCenter, uint16_t radius, uint16_t color, bool filled)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_CIRCLE;
+    command.data.circle.xCenter = xCenter;
+    command.data.circle.yCenter = yCenter;
+    command.data.circle.radius = radius;
+    command.data.circle.filled = filled;
+    command.color = color;
+    Enqueue(&command);
+}
+
+/*
+ * Queues filling the whole screen
+ */
+void LCDQueue_Clear(uint16_t color)
+{
+    LCDQueue_Rect(MIN_SCREEN_X, MAX_SCREEN_X - 1, MIN_SCREEN_Y, MAX_SCREEN_Y - 1, color);
+}
+
+/*
+ * Queues a string, copied into the command
+ */
+void LCDQueue_Text(uint16_t x, uint16_t y, const char* str, uint16_t color, uint16_t bkColor)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_TEXT;
+    strncpy(command.data.text, str, LCDQUEUE_TEXT_LENGTH - 1);
+    command.data.text[LCDQUEUE_TEXT_LENGTH - 1] = 0;
+
+    // bounds of one line of text; text that wraps is never treated as opaque
+    command.xStart = x;
+    command.xEnd = x + strlen(command.data.text) * 8 - 1;
+    command.yStart = y;
+    command.yEnd = y + 15;
+    if (command.xEnd >= MAX_SCREEN_X || command.data.text[0] == 0) command.xEnd = UINT16_MAX;
+
+    command.color = color;
+    command.bkColor = bkColor;
+    Enqueue(&command);
+}
+
+/*
+ * Queues printing on the scrolling console (see LCD_ConsolePrint), copied into the command
+ */
+void LCDQueue_ConsolePrint(const char* str)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_CONSOLE;
+    strncpy(command.data.text, str, LCDQUEUE_TEXT_LENGTH - 1);
+    command.data.text[LCDQUEUE_TEXT_LENGTH - 1] = 0;
+    Enqueue(&command);
+}
+
+/*
+ * Queues copying a pixel buffer into a rectangle (see LCD_DrawPixels)
+ *  - The buffer is not copied, it must stay unchanged until drawn (e.g. in flash)
+ */
+void LCDQueue_Pixels(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, const uint8_t* pixels)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_PIXELS;
+    command.xStart = xStart;
+    command.xEnd = xEnd;
+    command.yStart = yStart;
+    command.yEnd = yEnd;
+    command.data.pixels = pixels;
+    Enqueue(&command);
+}
+
+/*
+ * Queues drawing a bitmap (see LCD_DrawBitmap)
+ *  - The bitmap is not copied, it must stay unchanged until drawn (e.g. in flash)
+ */
+void LCDQueue_Bitmap(uint16_t x, uint16_t y, const Bitmap* bitmap)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_BITMAP;
+
+    // bounds of the whole bitmap; one running off screen is never treated as opaque
+    command.xStart = x;
+    command.xEnd = x + bitmap->width - 1;
+    command.yStart = y;
+    command.yEnd = y + bitmap->height - 1;
+    if (bitmap->width == 0 || bitmap->height == 0 ||
+        (uint32_t)x + bitmap->width > MAX_SCREEN_X || (uint32_t)y + bitmap->height > MAX_SCREEN_Y) command.xEnd = UINT16_MAX;
+
+    command.data.bitmap = bitmap;
+    Enqueue(&command);
+}
+
+/*
+ * Queues a call made by the render thread, in order with the drawing around it
+ */
+void LCDQueue_Call(void (*function)(void*), void* arg)
+{
+    lcd_command_t command;
+    command.type = LCD_COMMAND_CALL;
+    command.data.call.function = function;
+    command.data.call.arg = arg;
+    Enqueue(&command);
+}
+
+/*
+ * Sleeps until everything queued before has been drawn
+ */
+void LCDQueue_Flush()
+{
+    uint32_t queued = Head;
+    while ((int32_t)(Tail - queued) < 0) G8RTOS_Sleep(LCDQUEUE_RETRY_SLEEP);
+}
+
+/*
+ * Copies the running totals
+ */
+void LCDQueue_GetStats(lcdqueue_stats_t* stats)
+{
+    *stats = Stats;
+}
+
+/*********************************************** Public Functions *********************************************************************/
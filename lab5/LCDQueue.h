@@ -0,0 +1,189 @@
+/*
+ * LCDQueue.h
+ *
+ * Asynchronous drawing: threads queue LCD commands and one render thread runs them
+ *  - Queuing copies the command into a ring and returns at once; only while
+ *    the ring is full does the caller sleep until the render thread frees a slot
+ *  - Once it runs, the render thread is the only thread that touches the LCD
+ *  - Each time it wakes, the render thread takes every command queued so far
+ *    as one batch and skips the commands a later command of the batch paints
+ *    over completely
+ *  - Nothing here blocks on a semaphore another thread signals, so killing a
+ *    thread that draws leaves the queue intact
+ */
+
+#ifndef LCDQUEUE_H_
+#define LCDQUEUE_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include "LCDLib.h"
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+/* Commands the ring holds */
+#define LCDQUEUE_LENGTH             16
+
+/* Longest text a command carries, including the terminating 0; longer text is cut */
+#define LCDQUEUE_TEXT_LENGTH        48
+
+/* How long a thread sleeps before retrying when the ring is full, or while it waits for a flush */
+#define LCDQUEUE_RETRY_SLEEP        1
+
+/* SRAM the ring may take, counted in the application's RAM budget (checked in LCDQueue.c) */
+#define LCDQUEUE_RAM_BYTES          1088
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Data Structures ********************************************************************/
+
+typedef enum
+{
+    LCD_COMMAND_RECT,
+    LCD_COMMAND_TEXT,
+    LCD_COMMAND_PIXELS,
+    LCD_COMMAND_BITMAP,
+    LCD_COMMAND_LINE,
+    LCD_COMMAND_CIRCLE,
+    LCD_COMMAND_CONSOLE,
+    LCD_COMMAND_CALL
+} lcd_command_type_t;
+
+/*
+ * One queued command; the bounds are inclusive like LCD_DrawRectangle's
+ */
+typedef struct
+{
+    lcd_command_type_t type;
+    uint16_t xStart;
+    uint16_t xEnd;
+    uint16_t yStart;
+    uint16_t yEnd;
+    uint16_t color;
+    uint16_t bkColor;
+    union
+    {
+        char text[LCDQUEUE_TEXT_LENGTH];
+        const uint8_t* pixels;
+        const Bitmap* bitmap;
+        struct
+        {
+            int16_t x0;
+            int16_t y0;
+            int16_t x1;
+            int16_t y1;
+        } line;
+        struct
+        {
+            int16_t xCenter;
+            int16_t yCenter;
+            uint16_t radius;
+            bool filled;
+        } circle;
+        struct
+        {
+            void (*function)(void*);
+            void* arg;
+        } call;
+    } data;
+} lcd_command_t;
+
+/*
+ * Running totals of the queue
+ */
+typedef struct
+{
+    uint32_t queued;
+    uint32_t executed;
+    uint32_t skipped;       // painted over later in the same batch
+    uint32_t stalls;        // times a thread found the ring full
+} lcdqueue_stats_t;
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+/*
+ * Empties the queue, before the render thread is added
+ */
+void LCDQueue_Init();
+
+/*
+ * Render thread, runs the queued commands in order
+ */
+void LCDQueue_RenderThread();
+
+/*
+ * Queues a filled rectangle
+ */
+void LCDQueue_Rect(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, uint16_t color);
+
+/*
+ * Queues a horizontal line
+ */
+void LCDQueue_HLine(uint16_t xStart, uint16_t xEnd, uint16_t y, uint16_t color);
+
+/*
+ * Queues a vertical line
+ */
+void LCDQueue_VLine(uint16_t x, uint16_t yStart, uint16_t yEnd, uint16_t color);
+
+/*
+ * Queues a line between two points (see LCD_DrawLine)
+ */
+void LCDQueue_Line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/*
+ * Queues a circle outline or disc (see LCD_DrawCircle)
+ */
+void LCDQueue_Circle(int16_t xCenter, int16_t yCenter, uint16_t radius, uint16_t color, bool filled);
+
+/*
+ * Queues filling the whole screen
+ */
+void LCDQueue_Clear(uint16_t color);
+
+/*
+ * Queues a string, copied into the command
+ */
+void LCDQueue_Text(uint16_t x, uint16_t y, const char* str, uint16_t color, uint16_t bkColor);
+
+/*
+ * Queues printing on the scrolling console (see LCD_ConsolePrint), copied into the command
+ *  - The console must be opened first, e.g. by a queued call to LCD_ConsoleInit
+ */
+void LCDQueue_ConsolePrint(const char* str);
+
+/*
+ * Queues copying a pixel buffer into a rectangle (see LCD_DrawPixels)
+ *  - The buffer is not copied, it must stay unchanged until drawn (e.g. in flash)
+ */
+void LCDQueue_Pixels(uint16_t xStart, uint16_t xEnd, uint16_t yStart, uint16_t yEnd, const uint8_t* pixels);
+
+/*
+ * Queues drawing a bitmap (see LCD_DrawBitmap)
+ *  - The bitmap is not copied, it must stay unchanged until drawn (e.g. in flash)
+ */
+void LCDQueue_Bitmap(uint16_t x, uint16_t y, const Bitmap* bitmap);
+
+/*
+ * Queues a call made by the render thread, in order with the drawing around it
+ *  - Lets a function that draws a lot at once (e.g. a renderer frame) run on the render thread
+ *  - Nothing queued before a call is skipped because of what is queued after it
+ */
+void LCDQueue_Call(void (*function)(void*), void* arg);
+
+/*
+ * Sleeps until everything queued before has been drawn
+ */
+void LCDQueue_Flush();
+
+/*
+ * Copies the running totals
+ */
+void LCDQueue_GetStats(lcdqueue_stats_t* stats);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* LCDQUEUE_H_ */
@@ -0,0 +1,568 @@
+/*
+ * Renderer.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "LCDLib.h"
+#include "Renderer.h"
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*
+ * One object slot: what is on screen now and what the game wants there
+ */
+typedef struct
+{
+    render_rect_t shownRect;
+    render_rect_t wantedRect;
+    uint16_t shownColor;
+    uint16_t wantedColor;
+    bool shown;
+    bool wanted;
+} render_object_t;
+
+/*
+ * One rectangle of the frame, filled with a single colour
+ */
+typedef struct
+{
+    render_rect_t rect;
+    uint16_t color;
+} render_fill_t;
+
+/*
+ * How a changed object is brought up to date
+ *  - STRIPS: clear the part it left, draw the part it entered
+ *  - DRAW: clear the part it left, draw all of it
+ *  - REDRAW: clear all of where it was, draw all of it
+ */
+typedef enum
+{
+    PLAN_NONE,
+    PLAN_STRIPS,
+    PLAN_DRAW,
+    PLAN_REDRAW
+} render_plan_t;
+
+static render_object_t objects[RENDER_MAX_OBJECTS];
+
+#if RENDER_USE_TILES
+#define RENDER_TILES_X ((MAX_SCREEN_X + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE)
+#define RENDER_TILES_Y ((MAX_SCREEN_Y + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE)
+
+/* Scratch tile, pixels high byte first as LCD_DrawPixels takes them */
+static uint8_t tile[RENDER_TILE_SIZE * RENDER_TILE_SIZE * 2];
+
+/* Bounds of the changed pixels in each tile */
+static render_rect_t dirtyRects[RENDER_TILES_Y][RENDER_TILES_X];
+static bool dirtyTiles[RENDER_TILES_Y][RENDER_TILES_X];
+
+/* Composing costs per pixel, not per window */
+#define FILL_OVERHEAD_BYTES 0
+#else
+/* Fills of the frame being drawn, in painting order */
+static render_fill_t fills[RENDER_MAX_RECTS];
+
+#define FILL_OVERHEAD_BYTES RENDER_WINDOW_BYTES
+
+/* A frame that runs out of fills repaints the screen, one fill for the background and one per object */
+#if RENDER_MAX_RECTS < RENDER_MAX_OBJECTS + 1
+#error "RENDER_MAX_RECTS must leave room to repaint the whole screen"
+#endif
+#endif
+
+/* The tables have to fit RENDER_RAM_BYTES */
+#if RENDER_USE_TILES
+typedef char render_ram_check[(sizeof(objects) + sizeof(tile) + sizeof(dirtyRects) + sizeof(dirtyTiles) <= RENDER_RAM_BYTES) ? 1 : -1];
+#else
+typedef char render_ram_check[(sizeof(objects) + sizeof(fills) <= RENDER_RAM_BYTES) ? 1 : -1];
+#endif
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+#if !RENDER_USE_TILES
+/*
+ * Number of fills of the frame being drawn, and whether it needed more than RENDER_MAX_RECTS
+ */
+static uint32_t NumberOfFills;
+static bool FillsOverflowed;
+#endif
+
+/*
+ * Colour uncovered pixels are filled with
+ */
+static uint16_t BackColor;
+
+/*
+ * Running totals
+ */
+static render_stats_t Stats;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Overlap of two rectangles
+ * Returns: whether they overlap at all
+ */
+static bool Intersect(const render_rect_t* a, const render_rect_t* b, render_rect_t* overlap)
+{
+    overlap->xMin = (a->xMin > b->xMin) ? a->xMin : b->xMin;
+    overlap->xMax = (a->xMax < b->xMax) ? a->xMax : b->xMax;
+    overlap->yMin = (a->yMin > b->yMin) ? a->yMin : b->yMin;
+    overlap->yMax = (a->yMax < b->yMax) ? a->yMax : b->yMax;
+    return overlap->xMin <= overlap->xMax && overlap->yMin <= overlap->yMax;
+}
+
+static bool SameRect(const render_rect_t* a, const render_rect_t* b)
+{
+    return a->xMin == b->xMin && a->xMax == b->xMax && a->yMin == b->yMin && a->yMax == b->yMax;
+}
+
+static uint32_t Area(const render_rect_t* rect)
+{
+    return (uint32_t)(rect->xMax - rect->xMin + 1) * (rect->yMax - rect->yMin + 1);
+}
+
+/*
+ * Splits the part of "a" outside "b" into at most 4 rectangles
+ * (full width bands above and below the overlap, then the pieces left and right of it)
+ * Returns: number of rectangles written to "out"
+ */
+static uint32_t Subtract(const render_rect_t* a, const render_rect_t* b, render_rect_t* out)
+{
+    render_rect_t overlap;
+    uint32_t n = 0;
+
+    if (!Intersect(a, b, &overlap))
+    {
+        out[0] = *a;
+        return 1;
+    }
+
+    if (a->yMin < overlap.yMin) out[n++] = (render_rect_t){a->xMin, a->xMax, a->yMin, overlap.yMin - 1};
+    if (a->yMax > overlap.yMax) out[n++] = (render_rect_t){a->xMin, a->xMax, overlap.yMax + 1, a->yMax};
+    if (a->xMin < overlap.xMin) out[n++] = (render_rect_t){a->xMin, overlap.xMin - 1, overlap.yMin, overlap.yMax};
+    if (a->xMax > overlap.xMax) out[n++] = (render_rect_t){overlap.xMax + 1, a->xMax, overlap.yMin, overlap.yMax};
+    return n;
+}
+
+/*
+ * Clips a rectangle to the screen
+ * Returns: whether any of it is on screen
+ */
+static bool ClipToScreen(render_rect_t* rect)
+{
+    if (rect->xMin < 0) rect->xMin = 0;
+    if (rect->yMin < 0) rect->yMin = 0;
+    if (rect->xMax > MAX_SCREEN_X - 1) rect->xMax = MAX_SCREEN_X - 1;
+    if (rect->yMax > MAX_SCREEN_Y - 1) rect->yMax = MAX_SCREEN_Y - 1;
+    return rect->xMin <= rect->xMax && rect->yMin <= rect->yMax;
+}
+
+/*
+ * SPI bytes needed to fill some rectangles
+ */
+static uint32_t Cost(const render_rect_t* rects, uint32_t n)
+{
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < n; ++i) bytes += FILL_OVERHEAD_BYTES + Area(&rects[i]) * 2;
+    return bytes;
+}
+
+#if RENDER_USE_TILES
+/*
+ * Marks the pixels of a rectangle as changed in every tile it touches
+ * (no colour is needed, tiles are composed from the objects)
+ */
+static void MarkDirty(const render_rect_t* rect)
+{
+    render_rect_t changed = *rect;
+    if (!ClipToScreen(&changed)) return;
+
+    for (int ty = changed.yMin / RENDER_TILE_SIZE; ty <= changed.yMax / RENDER_TILE_SIZE; ++ty)
+    {
+        for (int tx = changed.xMin / RENDER_TILE_SIZE; tx <= changed.xMax / RENDER_TILE_SIZE; ++tx)
+        {
+            render_rect_t bounds = {tx * RENDER_TILE_SIZE, tx * RENDER_TILE_SIZE + RENDER_TILE_SIZE - 1,
+                                    ty * RENDER_TILE_SIZE, ty * RENDER_TILE_SIZE + RENDER_TILE_SIZE - 1};
+            render_rect_t part;
+            Intersect(&changed, &bounds, &part);
+
+            render_rect_t* dirty = &dirtyRects[ty][tx];
+            if (!dirtyTiles[ty][tx])
+            {
+                *dirty = part;
+                dirtyTiles[ty][tx] = true;
+                continue;
+            }
+            if (part.xMin < dirty->xMin) dirty->xMin = part.xMin;
+            if (part.xMax > dirty->xMax) dirty->xMax = part.xMax;
+            if (part.yMin < dirty->yMin) dirty->yMin = part.yMin;
+            if (part.yMax > dirty->yMax) dirty->yMax = part.yMax;
+        }
+    }
+}
+
+/*
+ * Composes the changed part of every dirty tile and writes it in one window
+ *  - The tile starts as background, then every object over it is painted in slot order
+ */
+static void DrawDirtyTiles()
+{
+    for (int ty = 0; ty < RENDER_TILES_Y; ++ty)
+    {
+        for (int tx = 0; tx < RENDER_TILES_X; ++tx)
+        {
+            if (!dirtyTiles[ty][tx]) continue;
+            dirtyTiles[ty][tx] = false;
+
+            render_rect_t* dirty = &dirtyRects[ty][tx];
+            uint32_t width = dirty->xMax - dirty->xMin + 1;
+            uint32_t pixels = Area(dirty);
+
+            for (uint32_t p = 0; p < pixels; ++p)
+            {
+                tile[p * 2] = BackColor >> 8;
+                tile[p * 2 + 1] = BackColor & 0xFF;
+            }
+
+            for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+            {
+                render_rect_t part;
+                if (!objects[i].wanted || !Intersect(&objects[i].wantedRect, dirty, &part)) continue;
+
+                uint8_t high = objects[i].wantedColor >> 8;
+                uint8_t low = objects[i].wantedColor & 0xFF;
+                for (int y = part.yMin; y <= part.yMax; ++y)
+                {
+                    uint8_t* pixel = &tile[((y - dirty->yMin) * width + (part.xMin - dirty->xMin)) * 2];
+                    for (int x = part.xMin; x <= part.xMax; ++x)
+                    {
+                        *pixel++ = high;
+                        *pixel++ = low;
+                    }
+                }
+            }
+
+            LCD_DrawPixels(dirty->xMin, dirty->xMax, dirty->yMin, dirty->yMax, tile);
+            ++Stats.windows;
+            Stats.pixels += pixels;
+        }
+    }
+}
+#else
+/*
+ * Bounding rectangle of two rectangles, if it holds no pixel outside them
+ * Returns: whether the two can be written as one window
+ */
+static bool Union(const render_rect_t* a, const render_rect_t* b, render_rect_t* both)
+{
+    render_rect_t overlap;
+
+    // one holds the other
+    if (Intersect(a, b, &overlap))
+    {
+        if (SameRect(&overlap, b)) { *both = *a; return true; }
+        if (SameRect(&overlap, a)) { *both = *b; return true; }
+    }
+
+    // same rows, touching or overlapping columns
+    if (a->yMin == b->yMin && a->yMax == b->yMax && a->xMin <= b->xMax + 1 && b->xMin <= a->xMax + 1)
+    {
+        *both = (render_rect_t){(a->xMin < b->xMin) ? a->xMin : b->xMin, (a->xMax > b->xMax) ? a->xMax : b->xMax, a->yMin, a->yMax};
+        return true;
+    }
+
+    // same columns, touching or overlapping rows
+    if (a->xMin == b->xMin && a->xMax == b->xMax && a->yMin <= b->yMax + 1 && b->yMin <= a->yMax + 1)
+    {
+        *both = (render_rect_t){a->xMin, a->xMax, (a->yMin < b->yMin) ? a->yMin : b->yMin, (a->yMax > b->yMax) ? a->yMax : b->yMax};
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Queues a fill at the end of the frame
+ */
+static void AddFill(const render_rect_t* rect, uint16_t color)
+{
+    if (NumberOfFills >= RENDER_MAX_RECTS)
+    {
+        FillsOverflowed = true;
+        return;
+    }
+
+    fills[NumberOfFills].rect = *rect;
+    fills[NumberOfFills].color = color;
+    ++NumberOfFills;
+}
+
+/*
+ * Merges fills of one colour that make up a rectangle together, in one pass
+ *  - The later fill moves up to the earlier one's place, so this is only done
+ *    when no fill of another colour in between overlaps it
+ *  - A fill that grew keeps taking in the fills after it; fills before it are
+ *    not looked at again
+ */
+static void MergeFills()
+{
+    for (uint32_t a = 0; a < NumberOfFills; ++a)
+    {
+        uint32_t b = a + 1;
+        while (b < NumberOfFills)
+        {
+            render_rect_t both, overlap;
+            bool merge = fills[a].color == fills[b].color && Union(&fills[a].rect, &fills[b].rect, &both);
+
+            for (uint32_t k = a + 1; k < b && merge; ++k)
+            {
+                merge = fills[k].color == fills[b].color || !Intersect(&fills[k].rect, &fills[b].rect, &overlap);
+            }
+            if (!merge)
+            {
+                ++b;
+                continue;
+            }
+
+            // the next fill moves into b's place, so b is looked at again
+            fills[a].rect = both;
+            for (uint32_t k = b + 1; k < NumberOfFills; ++k) fills[k - 1] = fills[k];
+            --NumberOfFills;
+        }
+    }
+}
+
+/*
+ * Replaces the fills of a frame that ran out of room with a repaint of the
+ * whole screen, so no pixel is left stale: the background, then every object
+ */
+static void RepaintScreen()
+{
+    render_rect_t screen = {0, MAX_SCREEN_X - 1, 0, MAX_SCREEN_Y - 1};
+
+    NumberOfFills = 0;
+    AddFill(&screen, BackColor);
+    for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+    {
+        if (objects[i].wanted) AddFill(&objects[i].wantedRect, objects[i].wantedColor);
+    }
+}
+
+/*
+ * Writes the queued fills to the LCD, clipped to the screen
+ */
+static void EmitFills()
+{
+    for (uint32_t i = 0; i < NumberOfFills; ++i)
+    {
+        render_rect_t rect = fills[i].rect;
+        if (!ClipToScreen(&rect)) continue;
+
+        LCD_DrawRectangle(rect.xMin, rect.xMax, rect.yMin, rect.yMax, fills[i].color);
+        ++Stats.windows;
+        Stats.pixels += Area(&rect);
+    }
+}
+#endif
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Forgets every object, for when the screen has just been cleared
+ * Param "backColor": colour uncovered pixels are filled with
+ */
+void Renderer_Reset(uint16_t backColor)
+{
+    BackColor = backColor;
+    for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+    {
+        objects[i].shown = false;
+        objects[i].wanted = false;
+    }
+}
+
+/*
+ * Sets where an object should be drawn from the next frame on
+ * Param "object": slot of the object, below RENDER_MAX_OBJECTS
+ * Param "rect": bounds of the object
+ * Param "color": colour of the object
+ */
+void Renderer_Submit(uint8_t object, const render_rect_t* rect, uint16_t color)
+{
+    if (object >= RENDER_MAX_OBJECTS) return;
+
+    objects[object].wantedRect = *rect;
+    objects[object].wantedColor = color;
+    objects[object].wanted = true;
+}
+
+/*
+ * Removes an object from the screen from the next frame on
+ * Param "object": slot of the object, below RENDER_MAX_OBJECTS
+ */
+void Renderer_Hide(uint8_t object)
+{
+    if (object >= RENDER_MAX_OBJECTS) return;
+
+    objects[object].wanted = false;
+}
+
+/*
+ * Draws the changes submitted since the last frame
+ *  - First the pixels changed objects uncovered are filled with the background
+ *  - Then, in slot order, every object draws what it needs and repaints
+ *    where the fills before it went over it
+ *  - With tiles, those pixels are instead composed and written once per tile
+ *  - Each changed object is updated the way that costs the fewest SPI bytes
+ */
+void Renderer_Frame()
+{
+    render_plan_t plans[RENDER_MAX_OBJECTS];
+    render_rect_t draws[RENDER_MAX_OBJECTS][4];
+    uint32_t numberOfDraws[RENDER_MAX_OBJECTS];
+    render_rect_t erases[4];
+
+#if !RENDER_USE_TILES
+    NumberOfFills = 0;
+    FillsOverflowed = false;
+#endif
+
+    // Pick a plan for every changed object and clear what it uncovers
+    for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+    {
+        render_object_t* o = &objects[i];
+        uint32_t numberOfErases = 0;
+
+        plans[i] = PLAN_NONE;
+        numberOfDraws[i] = 0;
+
+        if (o->shown == o->wanted && (!o->wanted || (SameRect(&o->shownRect, &o->wantedRect) && o->shownColor == o->wantedColor)))
+        {
+            if (o->wanted) ++Stats.skipped;
+            continue;
+        }
+
+        if (o->shown && o->wanted)
+        {
+            numberOfErases = Subtract(&o->shownRect, &o->wantedRect, erases);
+
+            uint32_t costDraw = Cost(erases, numberOfErases) + Cost(&o->wantedRect, 1);
+            uint32_t costRedraw = Cost(&o->shownRect, 1) + Cost(&o->wantedRect, 1);
+            uint32_t costStrips = UINT32_MAX;
+            if (o->shownColor == o->wantedColor)
+            {
+                numberOfDraws[i] = Subtract(&o->wantedRect, &o->shownRect, draws[i]);
+                costStrips = Cost(erases, numberOfErases) + Cost(draws[i], numberOfDraws[i]);
+            }
+
+            if (costStrips <= costDraw && costStrips <= costRedraw) plans[i] = PLAN_STRIPS;
+            else if (costDraw <= costRedraw) plans[i] = PLAN_DRAW;
+            else
+            {
+                plans[i] = PLAN_REDRAW;
+                erases[0] = o->shownRect;
+                numberOfErases = 1;
+            }
+        }
+        else if (o->shown)
+        {
+            erases[0] = o->shownRect;
+            numberOfErases = 1;
+        }
+        else
+        {
+            plans[i] = PLAN_DRAW;
+        }
+
+        if (plans[i] == PLAN_DRAW || plans[i] == PLAN_REDRAW)
+        {
+            draws[i][0] = o->wantedRect;
+            numberOfDraws[i] = 1;
+        }
+
+#if RENDER_USE_TILES
+        for (uint32_t e = 0; e < numberOfErases; ++e) MarkDirty(&erases[e]);
+#else
+        for (uint32_t e = 0; e < numberOfErases; ++e) AddFill(&erases[e], BackColor);
+#endif
+    }
+
+    // Draw the objects bottom to top, repairing whatever was painted over them
+    for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+    {
+        render_object_t* o = &objects[i];
+        if (!o->wanted) continue;
+
+#if RENDER_USE_TILES
+        // tiles are composed from every object, so nothing needs repairing
+        for (uint32_t d = 0; d < numberOfDraws[i]; ++d) MarkDirty(&draws[i][d]);
+#else
+        uint32_t before = NumberOfFills;
+        for (uint32_t d = 0; d < numberOfDraws[i]; ++d) AddFill(&draws[i][d], o->wantedColor);
+
+        // a full draw already covers every pixel of the object
+        if (plans[i] == PLAN_DRAW || plans[i] == PLAN_REDRAW) continue;
+
+        for (uint32_t f = 0; f < before; ++f)
+        {
+            render_rect_t overlap;
+            if (fills[f].color != o->wantedColor && Intersect(&fills[f].rect, &o->wantedRect, &overlap))
+            {
+                AddFill(&overlap, o->wantedColor);
+            }
+        }
+#endif
+    }
+
+#if RENDER_USE_TILES
+    DrawDirtyTiles();
+#else
+    if (FillsOverflowed)
+    {
+        ++Stats.overflows;
+        RepaintScreen();
+    }
+    MergeFills();
+    EmitFills();
+#endif
+
+    for (int i = 0; i < RENDER_MAX_OBJECTS; ++i)
+    {
+        objects[i].shown = objects[i].wanted;
+        objects[i].shownRect = objects[i].wantedRect;
+        objects[i].shownColor = objects[i].wantedColor;
+    }
+
+    ++Stats.frames;
+}
+
+/*
+ * Copies the running totals
+ * Param "stats": receives the totals
+ */
+void Renderer_GetStats(render_stats_t* stats)
+{
+    *stats = Stats;
+}
+
+/*
+ * Returns the SPI bytes the compositor has sent so far
+ */
+uint32_t Renderer_SpiBytes()
+{
+    return Stats.windows * RENDER_WINDOW_BYTES + Stats.pixels * 2;
+}
+
+/*********************************************** Public Functions *********************************************************************/
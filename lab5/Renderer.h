@@ -0,0 +1,119 @@
+/*
+ * Renderer.h
+ *
+ * Dirty rectangle compositor for the game screen
+ *  - Every object on screen is a solid rectangle kept in a numbered slot
+ *  - Each frame the game submits where every object should be, then
+ *    Renderer_Frame draws only what changed since the last frame: uncovered
+ *    pixels are filled with the background, pixels an object keeps are not
+ *    redrawn, and objects stacked over changed pixels are repainted in order
+ *    (higher slots on top)
+ *  - With RENDER_USE_TILES, changed pixels are composed off screen a tile at
+ *    a time from the object list and written once each, so nothing flickers
+ *    and overlapping objects never show through each other
+ *  - Without it, rectangles of one colour that line up are merged into one
+ *    LCD window and written straight to the screen
+ *  - Not thread safe, only the render thread uses it (see LCDQueue.h)
+ */
+
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+/* Compose changed pixels in an SRAM tile before writing them (1), or fill rectangles on screen (0) */
+#define RENDER_USE_TILES            1
+
+/* Width and height of a tile; the scratch tile takes RENDER_TILE_SIZE^2 * 2 bytes of SRAM */
+#define RENDER_TILE_SIZE            32
+
+/* Object slots */
+#define RENDER_MAX_OBJECTS          16
+
+/* Rectangles one frame can emit without tiles; past this, the frame repaints the whole screen and counts an overflow */
+#define RENDER_MAX_RECTS            96
+
+/* SPI bytes to set up one LCD window (6 register writes, the GRAM index and the data start byte) */
+#define RENDER_WINDOW_BYTES         40
+
+/* SRAM the renderer's tables may take, counted in the application's RAM budget (checked in Renderer.c) */
+#if RENDER_USE_TILES
+#define RENDER_RAM_BYTES            3200
+#else
+#define RENDER_RAM_BYTES            1600
+#endif
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*
+ * Rectangle with inclusive bounds, like LCD_DrawRectangle
+ */
+typedef struct
+{
+    int16_t xMin;
+    int16_t xMax;
+    int16_t yMin;
+    int16_t yMax;
+} render_rect_t;
+
+/*
+ * Running totals of the compositor's work
+ */
+typedef struct
+{
+    uint32_t frames;
+    uint32_t windows;       // LCD windows written (one per dirty tile with tiles)
+    uint32_t pixels;        // pixels written
+    uint32_t skipped;       // objects left alone because they did not change
+    uint32_t overflows;     // frames that ran out of rectangles and repainted the whole screen
+} render_stats_t;
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+/*
+ * Forgets every object, for when the screen has just been cleared
+ * Param "backColor": colour uncovered pixels are filled with
+ */
+void Renderer_Reset(uint16_t backColor);
+
+/*
+ * Sets where an object should be drawn from the next frame on
+ * Param "object": slot of the object, below RENDER_MAX_OBJECTS
+ * Param "rect": bounds of the object
+ * Param "color": colour of the object
+ */
+void Renderer_Submit(uint8_t object, const render_rect_t* rect, uint16_t color);
+
+/*
+ * Removes an object from the screen from the next frame on
+ * Param "object": slot of the object, below RENDER_MAX_OBJECTS
+ */
+void Renderer_Hide(uint8_t object);
+
+/*
+ * Draws the changes submitted since the last frame
+ */
+void Renderer_Frame();
+
+/*
+ * Copies the running totals
+ * Param "stats": receives the totals
+ */
+void Renderer_GetStats(render_stats_t* stats);
+
+/*
+ * Returns the SPI bytes the compositor has sent so far
+ */
+uint32_t Renderer_SpiBytes();
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* RENDERER_H_ */
@@ -15,6 +15,14 @@
 #define USING_TP true
 #define HOST_OR_CLIENT Host
 
+/* SRAM the board and CC3100 drivers keep in statics: the BMI160 driver (3.9 KB),
+ * the LCD DMA tables and console (0.6 KB), g_StatMem and the spawn queue (0.5 KB) */
+#define DRIVER_RAM_BYTES (5 * 1024 + 512)
+
+/* The game's and the drivers' statics have to fit the SRAM G8RTOS leaves the application */
+G8RTOS_STATIC_ASSERT(RENDER_RAM_BYTES + LCDQUEUE_RAM_BYTES + BUSSTATS_RAM_BYTES + sizeof(gameState) + sizeof(frameStates) + sizeof(clientInfo)
+                     + DRIVER_RAM_BYTES <= G8RTOS_APP_RAM_BYTES, app_ram_budget);
+
 /**
  * main.c
  */
@@ -26,9 +34,18 @@ void main(void)
     // Can alternatively use TLV->RANDOM_NUM_1 for repeatable number generation.
     srand(time(NULL));
 
+    // All drawing goes through the render thread, which lives across games.
+    LCDQueue_Init();
+    G8RTOS_AddThread(&LCDQueue_RenderThread, RENDER_PRIO, "render");
+
     // Add the thread that bootstraps the game.
     G8RTOS_AddThread(&HostVsClient, 0, "host vs client");
 
+#if G8RTOS_USE_BENCHMARK
+    // Print the kernel hot path cycle counts once things settle
+    G8RTOS_AddThread(&G8RTOS_KernelBenchmarkThread, 254, "kernel benchmark");
+#endif
+
     // Launch the OS!
     G8RTOS_Launch();
 }
@@ -0,0 +1,1191 @@
+/*
+ * VirtualBoard.c
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "msp.h"
+#include "driverlib.h"
+#include "i2c_driver.h"
+#include "LCDLib.h"
+#include "BusStats.h"
+#include "VirtualBoard.h"
+
+/*********************************************** Defines *********************************************************************/
+
+/* GRAM lines (gate lines, screen x) and columns (source lines, screen y) */
+#define GRAM_LINES                  MAX_SCREEN_X
+#define GRAM_COLUMNS                MAX_SCREEN_Y
+
+/* ILI9325 values the BSP does not define */
+#define ILI9325_ID                  0x9325
+#define ENTRY_MODE_AM               0x0008
+#define ENTRY_MODE_ID0              0x0010
+#define ENTRY_MODE_ID1              0x0020
+#define GATE_SCAN_VLE               0x0002
+
+/* XPT2046 start bit and the channels TP_ReadXY converts */
+#define XPT2046_START               0x80
+#define XPT2046_CHANNEL             0x70
+
+/* LP3943 units sit at 0x60 + unit; LS0 is register 6, bit 4 of the pointer auto-increments */
+#define LP3943_ADDRESS              0x60
+#define LP3943_UNITS                3
+#define LP3943_LS0                  0x06
+#define LP3943_AUTO_INCREMENT       0x10
+
+/* TXBUF holds this while the virtual eUSCI has nothing left to send */
+#define TXBUF_EMPTY                 0xFFFF
+
+/* I2C devices on EUSCI_B1, at the addresses the drivers use */
+#define BMI160_ADDRESS              0x69
+#define BME280_ADDRESS              0x77
+#define OPT3001_ADDRESS             0x47
+#define TMP007_ADDRESS              0x40
+#define I2C_DEVICES                 4
+#define I2C_REGISTER_BYTES          512
+
+/* Longest raw register write a script line carries */
+#define EVENT_MAX_BYTES             16
+
+/*********************************************** Defines *********************************************************************/
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*
+ * A device on the sensor bus
+ *  - Byte-wide devices (Bosch) auto-increment through 8-bit registers
+ *  - Word-wide devices (TI) have 16-bit registers sent high byte first,
+ *    register r is held in bytes 2r and 2r + 1
+ */
+typedef struct
+{
+    uint8_t address;
+    bool wide;
+    uint8_t registers[I2C_REGISTER_BYTES];
+} i2c_device_t;
+
+typedef enum
+{
+    EVENT_TOUCH,
+    EVENT_RELEASE,
+    EVENT_JOYSTICK,
+    EVENT_BUTTON,
+    EVENT_ACCEL,
+    EVENT_GYRO,
+    EVENT_LIGHT,
+    EVENT_TEMP,
+    EVENT_BME280,
+    EVENT_I2C,
+    EVENT_PNG
+} event_type_t;
+
+/*
+ * One script line
+ */
+typedef struct
+{
+    uint32_t ms;
+    event_type_t type;
+    double value[3];
+    uint8_t bytes[EVENT_MAX_BYTES];
+    uint8_t byteCount;
+    char path[VIRTUAL_MAX_LINE];
+} virtual_event_t;
+
+/*
+ * Script commands, with the numbers each takes (-1: a register write, 0 for png: a path)
+ */
+typedef struct
+{
+    const char* name;
+    event_type_t type;
+    int8_t values;
+} event_syntax_t;
+
+static const event_syntax_t syntax[] =
+{
+    { "touch",    EVENT_TOUCH,    2 },
+    { "release",  EVENT_RELEASE,  0 },
+    { "joystick", EVENT_JOYSTICK, 2 },
+    { "button",   EVENT_BUTTON,   1 },
+    { "accel",    EVENT_ACCEL,    3 },
+    { "gyro",     EVENT_GYRO,     3 },
+    { "light",    EVENT_LIGHT,    1 },
+    { "temp",     EVENT_TEMP,     2 },
+    { "bme280",   EVENT_BME280,   3 },
+    { "i2c",      EVENT_I2C,      -1 },
+    { "png",      EVENT_PNG,      0 },
+};
+
+/* BME280 trimming values, the datasheet's example part, with typical humidity trims */
+static const uint16_t digT1 = 27504;
+static const int16_t digT2 = 26435, digT3 = -1000;
+static const uint16_t digP1 = 36477;
+static const int16_t digP2 = -10685, digP3 = 3024, digP4 = 2855, digP5 = 140, digP6 = -7, digP7 = 15500, digP8 = -14600, digP9 = 6000;
+static const uint8_t digH1 = 75, digH3 = 0;
+static const int16_t digH2 = 370, digH4 = 309, digH5 = 50;
+static const int8_t digH6 = 30;
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*********************************************** Public Variables ********************************************************************/
+
+DIO_PORT_Type VirtualBoard_Ports[11];
+volatile uint32_t VirtualBoard_BitBandDummy;
+CoreDebug_Type VirtualBoard_CoreDebug;
+
+/*********************************************** Public Variables ********************************************************************/
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Peripherals reached through VirtualBoard calls */
+static EUSCI_B_Type eusci[4];
+static ADC14_Type adc;
+static DWT_Type dwt;
+
+/* DWT: what the virtual cycles are ahead of CYCCNT (time it was stopped, software writes),
+ * and the CYCCNT handed out last, to spot writes */
+static uint64_t dwtOffset;
+static uint32_t dwtShown;
+
+/* ILI9325: GRAM, registers, address counter, and the frame in progress
+ * (bytes since the start byte, -1 before it; the start byte; the high byte of a word) */
+static uint16_t gram[GRAM_LINES][GRAM_COLUMNS];
+static uint16_t lcdRegisters[256];
+static uint16_t lcdIndex;
+static uint16_t addressH;
+static uint16_t addressV;
+static int32_t lcdCount;
+static uint8_t lcdStart;
+static uint8_t lcdHigh;
+static uint16_t lcdRead;
+
+/* XPT2046: pen position, and the conversion result shifting out */
+static bool penDown;
+static uint16_t penX;
+static uint16_t penY;
+static uint8_t touchResponse[2];
+static uint8_t touchNext;
+
+/* Byte the SPI bus received last */
+static uint8_t spiReceived;
+
+/* DMA channel 6: the transfer set up, and whether completion interrupts */
+static const uint8_t* dmaSource;
+static uint32_t dmaSize;
+static bool dmaInterrupt;
+
+/* Joystick deflection */
+static int16_t joystickX;
+static int16_t joystickY;
+
+/* LP3943s: registers, the LEDs lit, and the transfer in progress on EUSCI_B2
+ * (unit addressed, register pointer, -1 until the master sends it) */
+static uint8_t ledRegisters[LP3943_UNITS][16];
+static uint16_t leds[LP3943_UNITS];
+static uint8_t ledUnit;
+static int16_t ledPointer;
+
+/* Sensor bus */
+static i2c_device_t devices[I2C_DEVICES];
+
+/* Script and time */
+static virtual_event_t events[VIRTUAL_MAX_EVENTS];
+static uint32_t eventCount;
+static uint32_t nextEvent;
+static uint32_t now;
+
+static virtual_stats_t Stats;
+
+/* PNG checksums */
+static uint32_t crcTable[256];
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*********************************************** Externs *********************************************************************/
+
+/* LCDLib's DMA completion handler */
+extern void DMA_INT1_IRQHandler(void);
+
+/* Port 4 handler, if the program has one (touch panel and joystick button) */
+extern void PORT4_IRQHandler(void) __attribute__((weak));
+
+/*********************************************** Externs *********************************************************************/
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Moves an address counter one step inside its window
+ * Returns true when it wrapped to the other edge
+ */
+static bool WindowStep(uint16_t* address, bool increment, uint16_t start, uint16_t end)
+{
+    if (increment)
+    {
+        if (*address >= end) { *address = start; return true; }
+        ++*address;
+    }
+    else
+    {
+        if (*address <= start) { *address = end; return true; }
+        --*address;
+    }
+    return false;
+}
+
+/*
+ * GRAM write at the address counter, which then moves as the entry mode says
+ */
+static void ILI9325_WriteGRAM(uint16_t color)
+{
+    uint16_t entry = lcdRegisters[ENTRY_MODE];
+    bool incrementH = entry & ENTRY_MODE_ID0;
+    bool incrementV = entry & ENTRY_MODE_ID1;
+
+    if (addressV < GRAM_LINES && addressH < GRAM_COLUMNS) gram[addressV][addressH] = color;
+    ++Stats.pixels;
+
+    if (entry & ENTRY_MODE_AM)
+    {
+        if (WindowStep(&addressV, incrementV, lcdRegisters[VERT_ADDR_START_POS], lcdRegisters[VERT_ADDR_END_POS]))
+            WindowStep(&addressH, incrementH, lcdRegisters[HOR_ADDR_START_POS], lcdRegisters[HOR_ADDR_END_POS]);
+    }
+    else
+    {
+        if (WindowStep(&addressH, incrementH, lcdRegisters[HOR_ADDR_START_POS], lcdRegisters[HOR_ADDR_END_POS]))
+            WindowStep(&addressV, incrementV, lcdRegisters[VERT_ADDR_START_POS], lcdRegisters[VERT_ADDR_END_POS]);
+    }
+}
+
+static void ILI9325_WriteRegister(uint16_t value)
+{
+    if (lcdIndex == DATA_IN_GRAM)
+    {
+        ILI9325_WriteGRAM(value);
+        return;
+    }
+
+    ++Stats.registers;
+    if (lcdIndex < 256) lcdRegisters[lcdIndex] = value;
+
+    if (lcdIndex == GRAM_HORIZONTAL_ADDRESS_SET) addressH = value & 0xFF;
+    else if (lcdIndex == GRAM_VERTICAL_ADDRESS_SET) addressV = value & 0x1FF;
+}
+
+static uint16_t ILI9325_ReadRegister()
+{
+    if (lcdIndex == READ_ID_CODE) return ILI9325_ID;
+    if (lcdIndex == DATA_IN_GRAM)
+    {
+        uint16_t color = (addressV < GRAM_LINES && addressH < GRAM_COLUMNS) ? gram[addressV][addressH] : 0;
+        WindowStep(&addressV, true, lcdRegisters[VERT_ADDR_START_POS], lcdRegisters[VERT_ADDR_END_POS]);
+        return color;
+    }
+    return (lcdIndex < 256) ? lcdRegisters[lcdIndex] : 0;
+}
+
+/*
+ * One byte of an LCD frame: the start byte (RS, RW), then 16-bit words high byte first;
+ * a read answers a dummy byte before the first word
+ */
+static uint8_t ILI9325_Exchange(uint8_t byte)
+{
+    if (lcdCount < 0)
+    {
+        lcdStart = byte;
+        lcdCount = 0;
+        if (lcdStart == (SPI_START | SPI_WR | SPI_DATA) && lcdIndex == DATA_IN_GRAM) ++Stats.runs;
+        return 0;
+    }
+
+    // not a start byte the ILI9325 knows, ignored until chip select goes high
+    if ((lcdStart & ~(SPI_RD | SPI_DATA)) != SPI_START) return 0;
+
+    uint32_t position = lcdCount++;
+    if (lcdStart & SPI_RD)
+    {
+        if (!(lcdStart & SPI_DATA) || position == 0) return 0;
+
+        // words follow the dummy byte, each fetched as its high byte goes out
+        if ((position - 1) % 2 == 0)
+        {
+            lcdRead = ILI9325_ReadRegister();
+            return lcdRead >> 8;
+        }
+        return lcdRead & 0xFF;
+    }
+
+    if (position % 2 == 0)
+    {
+        lcdHigh = byte;
+        return 0;
+    }
+
+    uint16_t word = (lcdHigh << 8) | byte;
+    if (lcdStart & SPI_DATA) ILI9325_WriteRegister(word);
+    else lcdIndex = word;
+    return 0;
+}
+
+/*
+ * One byte to the touch controller: a control byte starts a conversion whose
+ * 12 bits shift out over the next two bytes
+ */
+static uint8_t XPT2046_Exchange(uint8_t byte)
+{
+    uint8_t response = (touchNext < 2) ? touchResponse[touchNext++] : 0;
+
+    if (byte & XPT2046_START)
+    {
+        // smallest reading TP_ReadXY turns back into the pen position
+        uint16_t raw = 0;
+        if (penDown && (byte & XPT2046_CHANNEL) == (CHX & XPT2046_CHANNEL)) raw = (penX * 4096 + MAX_SCREEN_X - 1) / MAX_SCREEN_X;
+        if (penDown && (byte & XPT2046_CHANNEL) == (CHY & XPT2046_CHANNEL)) raw = (penY * 4096 + MAX_SCREEN_Y - 1) / MAX_SCREEN_Y;
+
+        touchResponse[0] = raw >> 5;
+        touchResponse[1] = (raw << 3) & 0xFF;
+        touchNext = 0;
+    }
+
+    return response;
+}
+
+/*
+ * One byte on the LCD SPI bus, to whichever devices are selected (chip selects are low true)
+ */
+static uint8_t SPI_Exchange(uint8_t byte)
+{
+    bool lcdSelected = !(VirtualBoard_Ports[10].OUT & BIT4);
+    bool touchSelected = !(VirtualBoard_Ports[10].OUT & BIT5);
+    uint8_t lcd = 0, touch = 0;
+
+    if (lcdSelected) { ++Stats.lcdBytes; lcd = ILI9325_Exchange(byte); }
+    if (touchSelected)
+    {
+        if (!lcdSelected) ++Stats.touchBytes;
+        touch = XPT2046_Exchange(byte);
+    }
+
+    return lcdSelected ? lcd : touch;
+}
+
+/*
+ * Carries out what the program has asked of the LP3943 bus since its last access
+ *  - A start sends the address, TXBUF is sent and flagged empty again, a stop ends the transfer
+ */
+static void LP3943_Step()
+{
+    EUSCI_B_Type* bus = &eusci[2];
+    if (bus->CTLW0 & EUSCI_B_CTLW0_SWRST) return;
+
+    if (bus->CTLW0 & EUSCI_B_CTLW0_TXSTT)
+    {
+        ledUnit = bus->I2CSA - LP3943_ADDRESS;
+        ledPointer = -1;
+        bus->CTLW0 &= ~EUSCI_B_CTLW0_TXSTT;
+        bus->IFG |= EUSCI_B_IFG_TXIFG0;
+        ++Stats.i2cBytes;
+        ++Stats.i2cTransfers;
+    }
+
+    if (bus->TXBUF != TXBUF_EMPTY)
+    {
+        uint8_t byte = bus->TXBUF;
+        bus->TXBUF = TXBUF_EMPTY;
+        bus->IFG |= EUSCI_B_IFG_TXIFG0;
+        ++Stats.i2cBytes;
+
+        if (ledUnit < LP3943_UNITS)
+        {
+            if (ledPointer < 0) ledPointer = byte;
+            else
+            {
+                ledRegisters[ledUnit][ledPointer & 0x0F] = byte;
+                if (ledPointer & LP3943_AUTO_INCREMENT) ledPointer = LP3943_AUTO_INCREMENT | ((ledPointer + 1) & 0x0F);
+            }
+        }
+    }
+
+    if (bus->CTLW0 & EUSCI_B_CTLW0_TXSTP)
+    {
+        bus->CTLW0 &= ~EUSCI_B_CTLW0_TXSTP;
+        if (ledUnit >= LP3943_UNITS) return;
+
+        // two selector bits per LED, anything but 00 lights it
+        uint16_t lit = 0;
+        for (int led = 0; led < 16; ++led)
+        {
+            if ((ledRegisters[ledUnit][LP3943_LS0 + led / 4] >> ((led % 4) * 2)) & 0x3) lit |= 1 << led;
+        }
+
+        if (lit != leds[ledUnit])
+        {
+            static const char* names[LP3943_UNITS] = { "BLUE", "GREEN", "RED" };
+            char pattern[17];
+            for (int led = 0; led < 16; ++led) pattern[led] = (lit & (1 << led)) ? '*' : '.';
+            pattern[16] = 0;
+            printf("%7u ms  LEDs %-5s %s\n", now, names[ledUnit], pattern);
+        }
+        leds[ledUnit] = lit;
+    }
+}
+
+static i2c_device_t* I2C_Find(uint8_t address)
+{
+    for (int i = 0; i < I2C_DEVICES; ++i)
+    {
+        if (devices[i].address == address) return &devices[i];
+    }
+    return NULL;
+}
+
+/*
+ * Stores a 16-bit value in a register of a word-wide device
+ */
+static void I2C_SetWord(uint8_t address, uint8_t reg, uint16_t value)
+{
+    i2c_device_t* device = I2C_Find(address);
+    device->registers[reg * 2] = value >> 8;
+    device->registers[reg * 2 + 1] = value & 0xFF;
+}
+
+/*
+ * Datasheet floating point compensation of the BME280 (8.1), with the trimming values above
+ */
+static double BME280_Temperature(int32_t adc, double tFine)
+{
+    double var1 = (adc / 16384.0 - digT1 / 1024.0) * digT2;
+    double var2 = (adc / 131072.0 - digT1 / 8192.0) * (adc / 131072.0 - digT1 / 8192.0) * digT3;
+    (void)tFine;
+    return (var1 + var2) / 5120.0;
+}
+
+static double BME280_Pressure(int32_t adc, double tFine)
+{
+    double var1 = tFine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * digP6 / 32768.0;
+    var2 = var2 + var1 * digP5 * 2.0;
+    var2 = var2 / 4.0 + digP4 * 65536.0;
+    var1 = (digP3 * var1 * var1 / 524288.0 + digP2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * digP1;
+    if (var1 == 0) return 0;
+
+    double p = 1048576.0 - adc;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = digP9 * p * p / 2147483648.0;
+    var2 = p * digP8 / 32768.0;
+    return p + (var1 + var2 + digP7) / 16.0;
+}
+
+static double BME280_Humidity(int32_t adc, double tFine)
+{
+    double h = tFine - 76800.0;
+    h = (adc - (digH4 * 64.0 + digH5 / 16384.0 * h)) *
+        (digH2 / 65536.0 * (1.0 + digH6 / 67108864.0 * h * (1.0 + digH3 / 67108864.0 * h)));
+    h = h * (1.0 - digH1 * h / 524288.0);
+    if (h > 100.0) h = 100.0;
+    if (h < 0.0) h = 0.0;
+    return h;
+}
+
+/*
+ * Finds the raw reading a compensation turns into a value (they are monotonic over the ADC range)
+ */
+static int32_t BME280_Solve(double (*compensate)(int32_t, double), double value, double tFine, int32_t limit)
+{
+    int32_t low = 0;
+    int32_t high = limit;
+    bool rising = compensate(high, tFine) > compensate(low, tFine);
+
+    while (high - low > 1)
+    {
+        int32_t middle = low + (high - low) / 2;
+        if ((compensate(middle, tFine) < value) == rising) low = middle;
+        else high = middle;
+    }
+    return low;
+}
+
+static void BME280_Set(double temperature, double pressure, double humidity)
+{
+    uint8_t* registers = I2C_Find(BME280_ADDRESS)->registers;
+
+    int32_t adcT = BME280_Solve(&BME280_Temperature, temperature, 0, 0xFFFFF);
+    double tFine = BME280_Temperature(adcT, 0) * 5120.0;
+    int32_t adcP = BME280_Solve(&BME280_Pressure, pressure, tFine, 0xFFFFF);
+    int32_t adcH = BME280_Solve(&BME280_Humidity, humidity, tFine, 0xFFFF);
+
+    // 0xF7: pressure, temperature (20 bits, MSB first) and humidity (16 bits)
+    registers[0xF7] = adcP >> 12;
+    registers[0xF8] = (adcP >> 4) & 0xFF;
+    registers[0xF9] = (adcP & 0xF) << 4;
+    registers[0xFA] = adcT >> 12;
+    registers[0xFB] = (adcT >> 4) & 0xFF;
+    registers[0xFC] = (adcT & 0xF) << 4;
+    registers[0xFD] = adcH >> 8;
+    registers[0xFE] = adcH & 0xFF;
+}
+
+static void BME280_Trim()
+{
+    uint8_t* registers = I2C_Find(BME280_ADDRESS)->registers;
+    const int16_t words[12] = { (int16_t)digT1, digT2, digT3, (int16_t)digP1, digP2, digP3, digP4, digP5, digP6, digP7, digP8, digP9 };
+
+    // 0x88: T1..P9, little endian
+    for (int i = 0; i < 12; ++i)
+    {
+        registers[0x88 + i * 2] = (uint16_t)words[i] & 0xFF;
+        registers[0x89 + i * 2] = (uint16_t)words[i] >> 8;
+    }
+
+    registers[0xA1] = digH1;
+    registers[0xE1] = (uint16_t)digH2 & 0xFF;
+    registers[0xE2] = (uint16_t)digH2 >> 8;
+    registers[0xE3] = digH3;
+    registers[0xE4] = digH4 >> 4;
+    registers[0xE5] = (digH4 & 0x0F) | ((digH5 & 0x0F) << 4);
+    registers[0xE6] = digH5 >> 4;
+    registers[0xE7] = digH6;
+    registers[0xD0] = 0x60;
+}
+
+static void OPT3001_Set(double lux)
+{
+    // lux = 0.01 * 2^exponent * mantissa, with the finest exponent that fits
+    double mantissa = lux / 0.01;
+    uint16_t exponent = 0;
+    while (mantissa > 4095.0 && exponent < 11)
+    {
+        mantissa /= 2.0;
+        ++exponent;
+    }
+    if (mantissa > 4095.0) mantissa = 4095.0;
+    if (mantissa < 0.0) mantissa = 0.0;
+
+    I2C_SetWord(OPT3001_ADDRESS, 0x00, (exponent << 12) | (uint16_t)lround(mantissa));
+}
+
+static void TMP007_Set(double die, double object)
+{
+    // 14 bits of 1/32 degree, left justified
+    I2C_SetWord(TMP007_ADDRESS, 0x01, (uint16_t)((int16_t)lround(die * 32.0) << 2));
+    I2C_SetWord(TMP007_ADDRESS, 0x03, (uint16_t)((int16_t)lround(object * 32.0) << 2));
+}
+
+/*
+ * Sets three little endian 16-bit BMI160 data registers
+ */
+static void BMI160_Set(uint8_t reg, const double* value)
+{
+    uint8_t* registers = I2C_Find(BMI160_ADDRESS)->registers;
+    for (int i = 0; i < 3; ++i)
+    {
+        uint16_t raw = (uint16_t)(int16_t)value[i];
+        registers[reg + i * 2] = raw & 0xFF;
+        registers[reg + i * 2 + 1] = raw >> 8;
+    }
+}
+
+/*
+ * Drives an input of port 4 (pulled up, low while pressed), raising its interrupt on the configured edge
+ */
+static void SetPort4Input(uint8_t bit, bool high)
+{
+    DIO_PORT_Type* port = &VirtualBoard_Ports[4];
+    volatile uint8_t* in = (volatile uint8_t*)&port->IN;
+    if (((*in & bit) != 0) == high) return;
+
+    *in = high ? (*in | bit) : (*in & ~bit);
+
+    // IES set: interrupt on high to low
+    if (((port->IES & bit) != 0) != high)
+    {
+        port->IFG |= bit;
+        if ((port->IE & bit) && PORT4_IRQHandler != NULL) PORT4_IRQHandler();
+    }
+}
+
+static void Play(const virtual_event_t* event)
+{
+    switch (event->type)
+    {
+    case EVENT_TOUCH:
+        penX = event->value[0];
+        penY = event->value[1];
+        penDown = true;
+        SetPort4Input(BIT0, false);
+        break;
+    case EVENT_RELEASE:
+        penDown = false;
+        SetPort4Input(BIT0, true);
+        break;
+    case EVENT_JOYSTICK:
+        joystickX = event->value[0];
+        joystickY = event->value[1];
+        break;
+    case EVENT_BUTTON:
+        SetPort4Input(BIT3, event->value[0] == 0);
+        break;
+    case EVENT_ACCEL:
+        BMI160_Set(0x12, event->value);
+        break;
+    case EVENT_GYRO:
+        BMI160_Set(0x0C, event->value);
+        break;
+    case EVENT_LIGHT:
+        OPT3001_Set(event->value[0]);
+        break;
+    case EVENT_TEMP:
+        TMP007_Set(event->value[0], event->value[1]);
+        break;
+    case EVENT_BME280:
+        BME280_Set(event->value[0], event->value[1], event->value[2]);
+        break;
+    case EVENT_I2C:
+    {
+        i2c_device_t* device = I2C_Find(event->value[0]);
+        uint32_t offset = (uint32_t)event->value[1] * (device->wide ? 2 : 1);
+        for (int i = 0; i < event->byteCount; ++i) device->registers[(offset + i) % I2C_REGISTER_BYTES] = event->bytes[i];
+        break;
+    }
+    case EVENT_PNG:
+        if (VirtualBoard_SavePNG(event->path)) printf("%7u ms  saved %s\n", now, event->path);
+        else fprintf(stderr, "cannot write %s\n", event->path);
+        break;
+    }
+}
+
+/*
+ * Reads one script line into an event
+ * Returns false if it is not a valid line
+ */
+static bool ParseEvent(char* line, virtual_event_t* event)
+{
+    char* next;
+    event->ms = strtoul(line, &next, 10);
+    if (next == line) return false;
+
+    char* name = strtok(next, " \t\r\n");
+    if (name == NULL) return false;
+
+    const event_syntax_t* command = NULL;
+    for (size_t i = 0; i < sizeof(syntax) / sizeof(syntax[0]); ++i)
+    {
+        if (strcmp(name, syntax[i].name) == 0) command = &syntax[i];
+    }
+    if (command == NULL) return false;
+    event->type = command->type;
+
+    if (command->type == EVENT_PNG)
+    {
+        char* path = strtok(NULL, " \t\r\n");
+        if (path == NULL) return false;
+        strncpy(event->path, path, VIRTUAL_MAX_LINE - 1);
+        event->path[VIRTUAL_MAX_LINE - 1] = 0;
+        return true;
+    }
+
+    if (command->type == EVENT_I2C)
+    {
+        char* address = strtok(NULL, " \t\r\n");
+        char* reg = strtok(NULL, " \t\r\n");
+        if (address == NULL || reg == NULL) return false;
+        event->value[0] = strtol(address, NULL, 0);
+        event->value[1] = strtol(reg, NULL, 0);
+        if (I2C_Find(event->value[0]) == NULL) return false;
+
+        char* byte;
+        event->byteCount = 0;
+        while ((byte = strtok(NULL, " \t\r\n")) != NULL)
+        {
+            if (event->byteCount == EVENT_MAX_BYTES) return false;
+            event->bytes[event->byteCount++] = strtol(byte, NULL, 0);
+        }
+        return event->byteCount > 0;
+    }
+
+    for (int i = 0; i < command->values; ++i)
+    {
+        char* value = strtok(NULL, " \t\r\n");
+        if (value == NULL) return false;
+        event->value[i] = strtod(value, &next);
+        if (*next != 0) return false;
+    }
+    return strtok(NULL, " \t\r\n") == NULL;
+}
+
+static bool LoadScript(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+
+    char line[VIRTUAL_MAX_LINE];
+    uint32_t number = 0;
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), file) != NULL)
+    {
+        ++number;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = 0;
+        if (strspn(line, " \t\r\n") == strlen(line)) continue;
+
+        if (eventCount == VIRTUAL_MAX_EVENTS)
+        {
+            fprintf(stderr, "%s:%u: more than %u events\n", path, number, VIRTUAL_MAX_EVENTS);
+            valid = false;
+        }
+        else if (!ParseEvent(line, &events[eventCount]))
+        {
+            fprintf(stderr, "%s:%u: bad event\n", path, number);
+            valid = false;
+        }
+        else if (eventCount > 0 && events[eventCount].ms < events[eventCount - 1].ms)
+        {
+            fprintf(stderr, "%s:%u: events out of time order\n", path, number);
+            valid = false;
+        }
+        else ++eventCount;
+    }
+
+    fclose(file);
+    return valid;
+}
+
+static uint32_t PNG_Crc(uint32_t crc, const uint8_t* data, size_t length)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void PNG_Put32(uint8_t* out, uint32_t value)
+{
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static void PNG_Chunk(FILE* file, const char* type, const uint8_t* data, uint32_t length)
+{
+    uint8_t header[8];
+    PNG_Put32(header, length);
+    memcpy(header + 4, type, 4);
+
+    uint8_t crc[4];
+    PNG_Put32(crc, PNG_Crc(PNG_Crc(0, header + 4, 4), data, length));
+
+    fwrite(header, 1, 8, file);
+    if (length > 0) fwrite(data, 1, length, file);
+    fwrite(crc, 1, 4, file);
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Resets every device and loads a script
+ */
+bool VirtualBoard_Init(const char* scriptPath)
+{
+    memset(VirtualBoard_Ports, 0, sizeof(VirtualBoard_Ports));
+    memset(eusci, 0, sizeof(eusci));
+    memset(&adc, 0, sizeof(adc));
+    memset(&dwt, 0, sizeof(dwt));
+    memset(&VirtualBoard_CoreDebug, 0, sizeof(VirtualBoard_CoreDebug));
+    dwtOffset = 0;
+    dwtShown = 0;
+    memset(gram, 0, sizeof(gram));
+    memset(lcdRegisters, 0, sizeof(lcdRegisters));
+    memset(ledRegisters, 0, sizeof(ledRegisters));
+    memset(leds, 0, sizeof(leds));
+    memset(devices, 0, sizeof(devices));
+    memset(&Stats, 0, sizeof(Stats));
+
+    // window registers reset to the whole GRAM
+    lcdRegisters[HOR_ADDR_END_POS] = GRAM_COLUMNS - 1;
+    lcdRegisters[VERT_ADDR_END_POS] = GRAM_LINES - 1;
+    lcdIndex = 0;
+    addressH = 0;
+    addressV = 0;
+    lcdCount = -1;
+    touchNext = 2;
+    penDown = false;
+    joystickX = 0;
+    joystickY = 0;
+    dmaInterrupt = false;
+
+    // touch IRQ and joystick button are pulled up
+    *(volatile uint8_t*)&VirtualBoard_Ports[4].IN = BIT0 | BIT3;
+
+    eusci[2].TXBUF = TXBUF_EMPTY;
+    eusci[3].IFG = EUSCI_B_IFG_TXIFG0;
+
+    devices[0].address = BMI160_ADDRESS;
+    devices[0].registers[0x00] = 0xD1;
+    devices[1].address = BME280_ADDRESS;
+    BME280_Trim();
+    devices[2].address = OPT3001_ADDRESS;
+    devices[2].wide = true;
+    I2C_SetWord(OPT3001_ADDRESS, 0x01, 0xC810);
+    I2C_SetWord(OPT3001_ADDRESS, 0x7E, 0x5449);
+    I2C_SetWord(OPT3001_ADDRESS, 0x7F, 0x3001);
+    devices[3].address = TMP007_ADDRESS;
+    devices[3].wide = true;
+    I2C_SetWord(TMP007_ADDRESS, 0x04, 0x4000);
+    I2C_SetWord(TMP007_ADDRESS, 0x1F, 0x0078);
+
+    // a lit room on a level desk
+    const double level[3] = { 0, 0, 16384 };
+    BMI160_Set(0x12, level);
+    OPT3001_Set(250);
+    TMP007_Set(24.0, 22.0);
+    BME280_Set(24.0, 101325, 40);
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+        crcTable[i] = crc;
+    }
+
+    now = 0;
+    eventCount = 0;
+    nextEvent = 0;
+    if (scriptPath != NULL && !LoadScript(scriptPath)) return false;
+
+    // events at time 0 hold before the program starts
+    VirtualBoard_Advance(0);
+    return true;
+}
+
+/*
+ * Returns the virtual time in ms
+ */
+uint32_t VirtualBoard_Millis()
+{
+    return now;
+}
+
+/*
+ * Moves virtual time on, playing the script events that come due
+ */
+void VirtualBoard_Advance(uint32_t ms)
+{
+    now += ms;
+    while (nextEvent < eventCount && events[nextEvent].ms <= now) Play(&events[nextEvent++]);
+}
+
+/*
+ * Returns whether every script event has been played
+ */
+bool VirtualBoard_Finished()
+{
+    return nextEvent == eventCount;
+}
+
+/*
+ * Returns the colour shown at a screen position, with the scroll applied
+ */
+uint16_t VirtualBoard_GetPixel(uint16_t x, uint16_t y)
+{
+    uint16_t line = x;
+    if (lcdRegisters[GATE_SCAN_CONTROL_0X61] & GATE_SCAN_VLE) line = (x + lcdRegisters[GATE_SCAN_CONTROL_0X6A]) % GRAM_LINES;
+    return gram[line][y];
+}
+
+/*
+ * Writes what the screen shows as a PNG (8-bit RGB, stored deflate blocks)
+ */
+bool VirtualBoard_SavePNG(const char* path)
+{
+    const uint32_t row = 1 + MAX_SCREEN_X * 3;
+    const uint32_t rawSize = row * MAX_SCREEN_Y;
+    const uint32_t blocks = (rawSize + 0xFFFF - 1) / 0xFFFF;
+
+    uint8_t* raw = malloc(rawSize);
+    uint8_t* zlib = malloc(2 + rawSize + blocks * 5 + 4);
+    if (raw == NULL || zlib == NULL)
+    {
+        free(raw);
+        free(zlib);
+        return false;
+    }
+
+    // RGB565 widened by repeating the top bits
+    for (uint32_t y = 0; y < MAX_SCREEN_Y; ++y)
+    {
+        uint8_t* out = raw + y * row;
+        *out++ = 0;
+        for (uint32_t x = 0; x < MAX_SCREEN_X; ++x)
+        {
+            uint16_t color = VirtualBoard_GetPixel(x, y);
+            uint8_t r = color >> 11, g = (color >> 5) & 0x3F, b = color & 0x1F;
+            *out++ = (r << 3) | (r >> 2);
+            *out++ = (g << 2) | (g >> 4);
+            *out++ = (b << 3) | (b >> 2);
+        }
+    }
+
+    uint32_t length = 0;
+    zlib[length++] = 0x78;
+    zlib[length++] = 0x01;
+    uint32_t a = 1, b = 0;
+    for (uint32_t offset = 0; offset < rawSize; offset += 0xFFFF)
+    {
+        uint32_t size = (rawSize - offset > 0xFFFF) ? 0xFFFF : rawSize - offset;
+        zlib[length++] = (offset + size == rawSize);
+        zlib[length++] = size & 0xFF;
+        zlib[length++] = size >> 8;
+        zlib[length++] = ~size & 0xFF;
+        zlib[length++] = (~size >> 8) & 0xFF;
+        memcpy(zlib + length, raw + offset, size);
+        length += size;
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            a = (a + raw[offset + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    PNG_Put32(zlib + length, (b << 16) | a);
+    length += 4;
+
+    uint8_t header[13] = { 0 };
+    PNG_Put32(header, MAX_SCREEN_X);
+    PNG_Put32(header + 4, MAX_SCREEN_Y);
+    header[8] = 8;      // bits per channel
+    header[9] = 2;      // RGB
+
+    FILE* file = fopen(path, "wb");
+    if (file != NULL)
+    {
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, 8, file);
+        PNG_Chunk(file, "IHDR", header, sizeof(header));
+        PNG_Chunk(file, "IDAT", zlib, length);
+        PNG_Chunk(file, "IEND", NULL, 0);
+    }
+
+    free(raw);
+    free(zlib);
+    return file != NULL && fclose(file) == 0;
+}
+
+/*
+ * Returns the LEDs of an LP3943 unit that are not off, one bit per LED
+ */
+uint16_t VirtualBoard_GetLeds(uint8_t unit)
+{
+    return (unit < LP3943_UNITS) ? leds[unit] : 0;
+}
+
+/*
+ * Copies the running totals
+ */
+void VirtualBoard_GetStats(virtual_stats_t* stats)
+{
+    *stats = Stats;
+}
+
+/*
+ * Returns the time in us the buses would have taken for some traffic
+ */
+uint32_t VirtualBoard_SpiMicros(const virtual_stats_t* stats)
+{
+    return (uint64_t)(stats->lcdBytes + stats->touchBytes) * VIRTUAL_SPI_BYTE_CYCLES * 1000000 / VIRTUAL_SPI_HZ;
+}
+
+uint32_t VirtualBoard_I2CMicros(const virtual_stats_t* stats)
+{
+    return (uint64_t)stats->i2cBytes * VIRTUAL_I2C_BYTE_CYCLES * 1000000 / VIRTUAL_I2C_HZ;
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*********************************************** Virtual Peripherals ********************************************************************/
+
+/*
+ * Register blocks, handed out after the virtual board has caught up with the last access
+ */
+EUSCI_B_Type* VirtualBoard_EUSCI_B(uint8_t module)
+{
+    if (module == 2) LP3943_Step();
+    return &eusci[module];
+}
+
+ADC14_Type* VirtualBoard_ADC14()
+{
+    // a started sequence converts at once: MEM0 is x (A15), MEM1 is y (A14)
+    if (adc.CTL0 & ADC14_CTL0_SC)
+    {
+        adc.CTL0 &= ~ADC14_CTL0_SC;
+        adc.MEM[0] = joystickX + 0x1FFF;
+        adc.MEM[1] = joystickY + 0x1FFF;
+    }
+    return &adc;
+}
+
+DWT_Type* VirtualBoard_DWT()
+{
+    // virtual time, plus the time every byte so far has kept its bus busy
+    uint64_t cycles = (uint64_t)now * (VIRTUAL_CPU_HZ / 1000) +
+                      (uint64_t)(Stats.lcdBytes + Stats.touchBytes) * VIRTUAL_SPI_BYTE_CYCLES * (VIRTUAL_CPU_HZ / VIRTUAL_SPI_HZ) +
+                      (uint64_t)Stats.i2cBytes * VIRTUAL_I2C_BYTE_CYCLES * (VIRTUAL_CPU_HZ / VIRTUAL_I2C_HZ);
+
+    // like the hardware, CYCCNT only counts once TRCENA and CYCCNTENA are set, and keeps what is written to it
+    bool running = (VirtualBoard_CoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    if (!running || dwt.CYCCNT != dwtShown) dwtOffset = cycles - dwt.CYCCNT;
+
+    dwt.CYCCNT = (uint32_t)(cycles - dwtOffset);
+    dwtShown = dwt.CYCCNT;
+    return &dwt;
+}
+
+volatile uint8_t* VirtualBoard_Port10Out()
+{
+    // a chip select found high has ended the frame on its device
+    if (VirtualBoard_Ports[10].OUT & BIT4) lcdCount = -1;
+    if (VirtualBoard_Ports[10].OUT & BIT5) touchNext = 2;
+    return &VirtualBoard_Ports[10].OUT;
+}
+
+/*
+ * DriverLib SPI, EUSCI_B3 only
+ */
+void SPI_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData)
+{
+    if (moduleInstance == EUSCI_B3_BASE) spiReceived = SPI_Exchange(transmitData);
+}
+
+uint8_t SPI_receiveData(uint32_t moduleInstance)
+{
+    return (moduleInstance == EUSCI_B3_BASE) ? spiReceived : 0;
+}
+
+uint_fast8_t SPI_isBusy(uint32_t moduleInstance)
+{
+    (void)moduleInstance;
+    return 0;
+}
+
+uint32_t SPI_getTransmitBufferAddressForDMA(uint32_t moduleInstance)
+{
+    (void)moduleInstance;
+    return (uint32_t)(uintptr_t)&eusci[3].TXBUF;
+}
+
+/*
+ * DriverLib uDMA, channel 6 only: enabling the channel sends the whole transfer
+ * and, with the interrupt enabled, runs the completion handler before returning
+ */
+void DMA_enableModule(void) {}
+void DMA_setControlBase(void* controlTable) { (void)controlTable; }
+void DMA_assignChannel(uint32_t mapping) { (void)mapping; }
+void DMA_disableChannelAttribute(uint32_t channelNum, uint32_t attr) { (void)channelNum; (void)attr; }
+void DMA_setChannelControl(uint32_t channelStructIndex, uint32_t control) { (void)channelStructIndex; (void)control; }
+void DMA_assignInterrupt(uint32_t interruptNumber, uint32_t channel) { (void)interruptNumber; (void)channel; }
+void DMA_clearInterruptFlag(uint32_t intChannel) { (void)intChannel; }
+void DMA_enableInterrupt(uint32_t interruptNumber) { dmaInterrupt = (interruptNumber == DMA_INT1); }
+void Interrupt_setPriority(uint32_t interruptNumber, uint8_t priority) { (void)interruptNumber; (void)priority; }
+
+void DMA_setChannelTransfer(uint32_t channelStructIndex, uint32_t mode, void* srcAddr, void* dstAddr, uint32_t transferSize)
+{
+    (void)channelStructIndex;
+    (void)mode;
+    (void)dstAddr;
+    dmaSource = srcAddr;
+    dmaSize = transferSize;
+}
+
+void DMA_enableChannel(uint32_t channelNum)
+{
+    (void)channelNum;
+    for (uint32_t i = 0; i < dmaSize; ++i) SPI_Exchange(dmaSource[i]);
+    Stats.dmaBytes += dmaSize;
+    dmaSize = 0;
+
+    // the last byte has moved on to the shift register
+    eusci[3].IFG |= EUSCI_B_IFG_TXIFG0;
+    if (dmaInterrupt) DMA_INT1_IRQHandler();
+}
+
+/*
+ * Board delay (demo_sysctl.c), moves virtual time
+ */
+void DelayMs(uint32_t ulClockMS)
+{
+    VirtualBoard_Advance(ulClockMS);
+}
+
+/*
+ * Sensor bus (replaces i2c_driver.c): transfers complete at once on the register files above,
+ * and are counted in BusStats like the real driver's
+ */
+void initI2C(void) {}
+
+static bool I2C_Write(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCount)
+{
+    i2c_device_t* device = I2C_Find(ui8Addr);
+    ++Stats.i2cTransfers;
+    ++Stats.i2cBytes;
+    if (device == NULL) return false;
+
+    // tmp007.c hands over its coefficient values (0) as the data pointer, which reads flash on the
+    // MSP432; here they are written as zeros
+    uint32_t offset = ui8Reg * (device->wide ? 2 : 1);
+    for (uint32_t i = 0; i < ui8ByteCount; ++i) device->registers[(offset + i) % I2C_REGISTER_BYTES] = (Data != NULL) ? Data[i] : 0;
+    Stats.i2cBytes += 1 + ui8ByteCount;
+
+    // the OPT3001 always has a conversion ready (CRF, bit 7 of the configuration)
+    if (ui8Addr == OPT3001_ADDRESS) device->registers[0x01 * 2 + 1] |= 0x80;
+    return true;
+}
+
+static bool I2C_Read(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint32_t ui32ByteCount)
+{
+    i2c_device_t* device = I2C_Find(ui8Addr);
+    ++Stats.i2cTransfers;
+    ++Stats.i2cBytes;
+    if (device == NULL) return false;
+
+    uint32_t offset = ui8Reg * (device->wide ? 2 : 1);
+    for (uint32_t i = 0; i < ui32ByteCount; ++i) Data[i] = device->registers[(offset + i) % I2C_REGISTER_BYTES];
+    Stats.i2cBytes += 2 + ui32ByteCount;
+    return true;
+}
+
+bool writeI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCount)
+{
+    uint32_t start = BUSSTATS_NOW();
+    uint32_t bytes = Stats.i2cBytes;
+    bool acknowledged = I2C_Write(ui8Addr, ui8Reg, Data, ui8ByteCount);
+    BusStats_Count(BUS_SENSOR_I2C, Stats.i2cBytes - bytes, start);
+    return acknowledged;
+}
+
+bool readBurstI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint32_t ui32ByteCount)
+{
+    uint32_t start = BUSSTATS_NOW();
+    uint32_t bytes = Stats.i2cBytes;
+    bool acknowledged = I2C_Read(ui8Addr, ui8Reg, Data, ui32ByteCount);
+    BusStats_Count(BUS_SENSOR_I2C, Stats.i2cBytes - bytes, start);
+    return acknowledged;
+}
+
+bool readI2C(uint8_t ui8Addr, uint8_t ui8Reg, uint8_t *Data, uint8_t ui8ByteCount)
+{
+    return readBurstI2C(ui8Addr, ui8Reg, Data, ui8ByteCount);
+}
+
+/*********************************************** Virtual Peripherals ********************************************************************/
@@ -0,0 +1,131 @@
+/*
+ * VirtualBoard.h
+ *
+ * Host model of the board the BoardSupportPackage drives, for running it on Linux
+ *  - The LCD is an ILI9325 register model: index and data frames on the SPI
+ *    bus, window and address counter semantics, entry mode and the vertical
+ *    scroll, GRAM kept as RGB565 and dumped as PNG
+ *  - The touch panel (XPT2046), joystick ADC and button, LP3943 LED drivers
+ *    and the BMI160, OPT3001, TMP007 and BME280 register files answer the
+ *    real drivers on their buses; what they read is set by a script
+ *  - Time is virtual: it only moves when the program sleeps (DelayMs) or calls
+ *    VirtualBoard_Advance, so a run is the same every time
+ *  - Bus traffic is counted and turned into the time the real buses would take;
+ *    the DWT cycle counter runs with virtual time plus that bus time, so the
+ *    BusStats counters in the drivers read what they would on the board
+ *
+ * Script: one event per line, "<ms> <command> <args>", in time order, # starts a comment
+ *      touch <x> <y>           pen down at a screen position
+ *      release                 pen up
+ *      joystick <x> <y>        joystick deflection, -8191..8192 like GetJoystickCoordinates
+ *      button <0|1>            joystick button up or down
+ *      accel <x> <y> <z>       BMI160 accelerometer, raw LSB
+ *      gyro <x> <y> <z>        BMI160 gyroscope, raw LSB
+ *      light <lux>             OPT3001
+ *      temp <die> <object>     TMP007, degrees C
+ *      bme280 <t> <p> <h>      BME280, degrees C, Pa, %RH
+ *      i2c <addr> <reg> <b>... raw register bytes of an I2C device (hex or decimal)
+ *      png <path>              dumps the screen
+ */
+
+#ifndef VIRTUALBOARD_H_
+#define VIRTUALBOARD_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+/* CPU clock the DWT cycle counter runs at (MCLK after ClockSys_SetMaxFreq) */
+#define VIRTUAL_CPU_HZ              48000000
+
+/* Bus clocks the traffic is timed at: SMCLK on the LCD SPI (BRW = 0), fast mode I2C */
+#define VIRTUAL_SPI_HZ              12000000
+#define VIRTUAL_I2C_HZ              400000
+
+/* Clock cycles per byte: 8 on SPI, 8 data bits and the acknowledge on I2C */
+#define VIRTUAL_SPI_BYTE_CYCLES     8
+#define VIRTUAL_I2C_BYTE_CYCLES     9
+
+/* Script lines and events */
+#define VIRTUAL_MAX_LINE            128
+#define VIRTUAL_MAX_EVENTS          1024
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*
+ * Running totals of the bus traffic
+ */
+typedef struct
+{
+    uint32_t lcdBytes;      // SPI bytes while the LCD was selected
+    uint32_t touchBytes;    // SPI bytes while the touch panel was selected
+    uint32_t dmaBytes;      // part of the SPI bytes sent by the DMA channel
+    uint32_t pixels;        // GRAM pixels written
+    uint32_t runs;          // GRAM writes started (data frames after index 0x22)
+    uint32_t registers;     // other LCD register writes
+    uint32_t i2cBytes;      // I2C bytes, addresses included, on both buses
+    uint32_t i2cTransfers;
+} virtual_stats_t;
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+/*
+ * Resets every device and loads a script
+ * Param "scriptPath": script to play, or NULL for none
+ * Returns false if the script cannot be read or has a bad line (reported on stderr)
+ */
+bool VirtualBoard_Init(const char* scriptPath);
+
+/*
+ * Returns the virtual time in ms
+ */
+uint32_t VirtualBoard_Millis();
+
+/*
+ * Moves virtual time on, playing the script events that come due
+ * Param "ms": time to move on by
+ */
+void VirtualBoard_Advance(uint32_t ms);
+
+/*
+ * Returns whether every script event has been played
+ */
+bool VirtualBoard_Finished();
+
+/*
+ * Returns the colour shown at a screen position, with the scroll applied
+ */
+uint16_t VirtualBoard_GetPixel(uint16_t x, uint16_t y);
+
+/*
+ * Writes what the screen shows as a PNG
+ * Returns false if the file cannot be written
+ */
+bool VirtualBoard_SavePNG(const char* path);
+
+/*
+ * Returns the LEDs of an LP3943 unit (BLUE, GREEN, RED) that are not off, one bit per LED
+ */
+uint16_t VirtualBoard_GetLeds(uint8_t unit);
+
+/*
+ * Copies the running totals
+ */
+void VirtualBoard_GetStats(virtual_stats_t* stats);
+
+/*
+ * Returns the time in us the buses would have taken for some traffic
+ * Param "stats": traffic, e.g. the difference of two snapshots
+ */
+uint32_t VirtualBoard_SpiMicros(const virtual_stats_t* stats);
+uint32_t VirtualBoard_I2CMicros(const virtual_stats_t* stats);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* VIRTUALBOARD_H_ */
@@ -0,0 +1,430 @@
+/*
+ * demo.c
+ *
+ * Headless run of the board code on the virtual board
+ *  - Times a few LCDLib primitives, then plays a script through a small
+ *    paddle game drawn with the renderer: the joystick moves the paddle,
+ *    tilting the board pushes the ball, touching the screen moves it, the
+ *    light level is shown on the green LEDs and misses on the red ones
+ *  - Reports what drawing cost on the LCD bus, and on the host, and what the
+ *    BusStats counters in the drivers charged to each task and operation
+ *
+ * Usage: demo <script>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "msp.h"
+#include "LCDLib.h"
+#include "Joystick.h"
+#include "RGBLeds.h"
+#include "i2c_driver.h"
+#include "opt3001.h"
+#include "tmp007.h"
+#include "bmi160_support.h"
+#include "bme280_support.h"
+#include "Renderer.h"
+#include "BusStats.h"
+#include "VirtualBoard.h"
+
+/*********************************************** Defines *********************************************************************/
+
+/* Time between frames, ms */
+#define FRAME_MS                    16
+
+/* Time between sensor readings, ms */
+#define SENSOR_MS                   250
+
+/* Arena below the status line */
+#define ARENA_MIN_Y                 20
+#define ARENA_MAX_Y                 (MAX_SCREEN_Y - 1)
+
+#define PADDLE_LEN                  48
+#define PADDLE_WID                  4
+#define PADDLE_Y                    (ARENA_MAX_Y - 8)
+#define BALL_SIZE                   6
+
+/* Joystick deflection per pixel of paddle movement, and accelerometer LSB per pixel/frame of push */
+#define JOYSTICK_SCALER             1024
+#define ACCEL_SCALER                8192
+
+/* Tasks of the main loop, standing in for threads in BusStats */
+#define TASK_MAIN                   0
+#define TASK_SENSORS                1
+#define TASK_GAME                   2
+
+#define BACK_COLOR                  LCD_BLACK
+#define PADDLE_OBJECT               0
+#define BALL_OBJECT                 1
+
+/*********************************************** Defines *********************************************************************/
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*
+ * Cost of some drawing: bus traffic and host time
+ */
+typedef struct
+{
+    virtual_stats_t bus;
+    uint32_t hostNanos;
+} draw_cost_t;
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*********************************************** Private Variables ********************************************************************/
+
+static int16_t paddleX;
+static int16_t ballX, ballY;
+static int16_t ballVX, ballVY;
+static uint8_t misses;
+
+/* Task the loop is running, and names for the report */
+static uint32_t task;
+static const char* const taskNames[] = { "main", "sensors", "game" };
+
+/*********************************************** Private Variables ********************************************************************/
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * BusStats thread hook
+ */
+static uint32_t CurrentTask()
+{
+    return task;
+}
+
+static uint64_t HostNanos()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/*
+ * Snapshot before some drawing
+ */
+static void CostStart(draw_cost_t* cost)
+{
+    VirtualBoard_GetStats(&cost->bus);
+    cost->hostNanos = HostNanos();
+}
+
+/*
+ * Turns the snapshot into what the drawing since cost
+ */
+static void CostEnd(draw_cost_t* cost)
+{
+    virtual_stats_t now;
+    VirtualBoard_GetStats(&now);
+    cost->hostNanos = HostNanos() - cost->hostNanos;
+    cost->bus.lcdBytes = now.lcdBytes - cost->bus.lcdBytes;
+    cost->bus.touchBytes = now.touchBytes - cost->bus.touchBytes;
+    cost->bus.dmaBytes = now.dmaBytes - cost->bus.dmaBytes;
+    cost->bus.pixels = now.pixels - cost->bus.pixels;
+    cost->bus.runs = now.runs - cost->bus.runs;
+    cost->bus.registers = now.registers - cost->bus.registers;
+    cost->bus.i2cBytes = now.i2cBytes - cost->bus.i2cBytes;
+    cost->bus.i2cTransfers = now.i2cTransfers - cost->bus.i2cTransfers;
+}
+
+static void PrintCost(const char* name, const draw_cost_t* cost)
+{
+    printf("  %-24s %7u px %5u runs %7u B (%3u%% DMA) %7u us bus %6u us host\n", name,
+           cost->bus.pixels, cost->bus.runs, cost->bus.lcdBytes,
+           cost->bus.lcdBytes ? (uint32_t)((uint64_t)cost->bus.dmaBytes * 100 / cost->bus.lcdBytes) : 0,
+           VirtualBoard_SpiMicros(&cost->bus), cost->hostNanos / 1000);
+}
+
+/*
+ * Times the LCDLib primitives once each
+ */
+static void MeasurePrimitives()
+{
+    static const uint16_t pixels[16 * 16] = { 0 };
+    draw_cost_t cost;
+
+    printf("LCDLib primitives:\n");
+
+    CostStart(&cost);
+    LCD_Clear(BACK_COLOR);
+    CostEnd(&cost);
+    PrintCost("LCD_Clear", &cost);
+
+    bus_span_t span;
+    CostStart(&cost);
+    BusStats_Begin(&span, "LCD_DrawRectangle");
+    LCD_DrawRectangle(10, 109, 30, 129, LCD_BLUE);
+    BusStats_End(&span);
+    CostEnd(&cost);
+    PrintCost("LCD_DrawRectangle 100^2", &cost);
+
+    CostStart(&cost);
+    LCD_DrawPixels(120, 135, 30, 45, (const uint8_t*)pixels);
+    CostEnd(&cost);
+    PrintCost("LCD_DrawPixels 16^2", &cost);
+
+    CostStart(&cost);
+    LCD_Text(0, 140, (uint8_t*)"The quick brown fox jumps over the lazy", LCD_WHITE, BACK_COLOR);
+    CostEnd(&cost);
+    PrintCost("LCD_Text 39 chars", &cost);
+
+    CostStart(&cost);
+    LCD_DrawLine(0, 0, MAX_SCREEN_X - 1, MAX_SCREEN_Y - 1, LCD_GREEN);
+    CostEnd(&cost);
+    PrintCost("LCD_DrawLine diagonal", &cost);
+
+    CostStart(&cost);
+    LCD_DrawCircle(240, 80, 40, LCD_YELLOW, false);
+    CostEnd(&cost);
+    PrintCost("LCD_DrawCircle r40", &cost);
+
+    CostStart(&cost);
+    LCD_DrawCircle(240, 80, 30, LCD_RED, true);
+    CostEnd(&cost);
+    PrintCost("LCD_DrawCircle r30 filled", &cost);
+
+    if (VirtualBoard_SavePNG("primitives.png")) printf("  saved primitives.png\n");
+}
+
+/*
+ * Shows the light level on the green LEDs (one per doubling from 1 lux) and the sensors on the status line
+ */
+static void ReadSensors()
+{
+    uint16_t rawLux, rawDie, rawObject;
+    float lux = 0, die = 0, object = 0;
+    u32 pressure = 0, humidity = 0;
+    s32 temperature = 0;
+
+    bus_span_t span;
+    BusStats_Begin(&span, "sensorOpt3001Read");
+    if (sensorOpt3001Read(&rawLux)) sensorOpt3001Convert(rawLux, &lux);
+    BusStats_End(&span);
+    BusStats_Begin(&span, "sensorTmp007Read");
+    if (sensorTmp007Read(&rawDie, &rawObject)) sensorTmp007Convert(rawDie, rawObject, &object, &die);
+    BusStats_End(&span);
+    BusStats_Begin(&span, "bme280_read");
+    bme280_read_pressure_temperature_humidity(&pressure, &temperature, &humidity);
+    BusStats_End(&span);
+
+    uint16_t bar = 0;
+    for (float level = 1; level <= lux && bar != 0xFFFF; level *= 2) bar = (bar << 1) | 1;
+    LP3943_LedModeSet(GREEN, bar);
+
+    // one line of text, cut at the screen edge
+    char status[64];
+    snprintf(status, sizeof(status), "%5.0f lx %4.1f/%4.1fC %4u hPa %2u%% ",
+             lux, die, object, pressure / 100, humidity / 1024);
+    status[MAX_SCREEN_X / 8] = 0;
+    LCD_Text(0, 0, (uint8_t*)status, LCD_WHITE, BACK_COLOR);
+}
+
+static void ResetBall()
+{
+    ballX = MAX_SCREEN_X / 2;
+    ballY = ARENA_MIN_Y + 20;
+    ballVX = 3;
+    ballVY = 2;
+}
+
+/*
+ * Moves the paddle and ball, one frame
+ */
+static void Update()
+{
+    int16_t x, y;
+    GetJoystickCoordinates(&x, &y);
+    paddleX += x / JOYSTICK_SCALER;
+    if (paddleX < 0) paddleX = 0;
+    if (paddleX > MAX_SCREEN_X - PADDLE_LEN) paddleX = MAX_SCREEN_X - PADDLE_LEN;
+
+    struct bmi160_accel_t accel;
+    bus_span_t span;
+    BusStats_Begin(&span, "bmi160_read_accel_xyz");
+    bmi160_read_accel_xyz(&accel);
+    BusStats_End(&span);
+    ballVX += accel.x / ACCEL_SCALER;
+    if (ballVX > 6) ballVX = 6;
+    if (ballVX < -6) ballVX = -6;
+
+    // the pen drops the ball where it touches (the touch IRQ line is low true)
+    if (!(P4->IN & BIT0))
+    {
+        BusStats_Begin(&span, "TP_ReadXY");
+        Point p = TP_ReadXY();
+        BusStats_End(&span);
+        if (p.y >= ARENA_MIN_Y && p.y < PADDLE_Y - BALL_SIZE)
+        {
+            ballX = p.x;
+            ballY = p.y;
+        }
+    }
+
+    ballX += ballVX;
+    ballY += ballVY;
+    if (ballX < 0) { ballX = 0; ballVX = -ballVX; }
+    if (ballX > MAX_SCREEN_X - BALL_SIZE) { ballX = MAX_SCREEN_X - BALL_SIZE; ballVX = -ballVX; }
+    if (ballY < ARENA_MIN_Y) { ballY = ARENA_MIN_Y; ballVY = -ballVY; }
+
+    if (ballY + BALL_SIZE >= PADDLE_Y && ballVY > 0)
+    {
+        if (ballX + BALL_SIZE > paddleX && ballX < paddleX + PADDLE_LEN) ballVY = -ballVY;
+        else
+        {
+            misses = (misses + 1) % 17;
+            LP3943_LedModeSet(RED, (1 << misses) - 1);
+            ResetBall();
+        }
+    }
+}
+
+static void Draw()
+{
+    render_rect_t paddle = { paddleX, paddleX + PADDLE_LEN - 1, PADDLE_Y, PADDLE_Y + PADDLE_WID - 1 };
+    render_rect_t ball = { ballX, ballX + BALL_SIZE - 1, ballY, ballY + BALL_SIZE - 1 };
+    Renderer_Submit(PADDLE_OBJECT, &paddle, LCD_ORANGE);
+    Renderer_Submit(BALL_OBJECT, &ball, LCD_WHITE);
+
+    bus_span_t span;
+    BusStats_Begin(&span, "Renderer_Frame");
+    Renderer_Frame();
+    BusStats_End(&span);
+}
+
+static void PrintTraffic(const bus_traffic_t* bus)
+{
+    for (int i = 0; i < BUS_COUNT; ++i) printf(" %8u B %7u us", bus[i].bytes, bus[i].us);
+    printf("\n");
+}
+
+static const char* TaskName(uint32_t thread)
+{
+    return (thread == BUSSTATS_NO_THREAD) ? "start-up" : taskNames[thread];
+}
+
+/*
+ * Prints what BusStats charged to every task and operation
+ */
+static void PrintBusStats()
+{
+    static busstats_snapshot_t snapshot;
+    BusStats_Snapshot(&snapshot);
+
+    printf("Bus traffic (BusStats):\n  %-40s %6s %11s %21s %21s %21s\n",
+           "task/operation", "calls", "worst", "LCD SPI", "sensor I2C", "LED I2C");
+    printf("  %-40s %6s %11s", "total", "", "");
+    PrintTraffic(snapshot.total);
+    for (int i = 0; i < snapshot.threadCount; ++i)
+    {
+        printf("  %-40s %6s %11s", TaskName(snapshot.threads[i].thread), "", "");
+        PrintTraffic(snapshot.threads[i].bus);
+    }
+
+    for (int i = 0; i < snapshot.operationCount; ++i)
+    {
+        const bus_operation_stats_t* operation = &snapshot.operations[i];
+        char name[64];
+        snprintf(name, sizeof(name), "%s/%s", TaskName(operation->thread), operation->name);
+        printf("  %-40.40s %6u %8u us", name, operation->calls, operation->worstUs);
+        PrintTraffic(operation->bus);
+    }
+    if (snapshot.droppedSpans > 0) printf("  %u spans found no free operation slot\n", snapshot.droppedSpans);
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <script>\n", argv[0]);
+        return 1;
+    }
+    if (!VirtualBoard_Init(argv[1])) return 1;
+    BusStats_Init(VIRTUAL_CPU_HZ);
+
+    LCD_Init(true);
+    init_RGBLEDS();
+    Joystick_Init_Without_Interrupt();
+    initI2C();
+    sensorOpt3001Init();
+    sensorOpt3001Enable(true);
+    sensorTmp007Init();
+    sensorTmp007Enable(true);
+    bmi160_initialize_sensor();
+    bme280_initialize_sensor();
+    printf("%7u ms  board up\n", VirtualBoard_Millis());
+
+    // from here on traffic is charged to the task the loop is running
+    BusStats_SetThreadHook(CurrentTask);
+    task = TASK_MAIN;
+
+    MeasurePrimitives();
+
+    LCD_Clear(BACK_COLOR);
+    LCD_DrawHLine(0, MAX_SCREEN_X - 1, ARENA_MIN_Y - 2, LCD_GRAY);
+    Renderer_Reset(BACK_COLOR);
+    paddleX = (MAX_SCREEN_X - PADDLE_LEN) / 2;
+    ResetBall();
+
+    // frames until the script has played out
+    uint32_t frames = 0, worstMicros = 0, nextSensors = 0;
+    draw_cost_t total = { { 0 }, 0 };
+    virtual_stats_t start;
+    VirtualBoard_GetStats(&start);
+    printf("Frames:\n");
+
+    while (!VirtualBoard_Finished())
+    {
+        if (VirtualBoard_Millis() >= nextSensors)
+        {
+            task = TASK_SENSORS;
+            ReadSensors();
+            nextSensors += SENSOR_MS;
+        }
+
+        task = TASK_GAME;
+        Update();
+
+        draw_cost_t cost;
+        CostStart(&cost);
+        Draw();
+        CostEnd(&cost);
+
+        uint32_t micros = VirtualBoard_SpiMicros(&cost.bus);
+        if (micros > worstMicros) worstMicros = micros;
+        total.hostNanos += cost.hostNanos;
+        total.bus.pixels += cost.bus.pixels;
+        total.bus.runs += cost.bus.runs;
+        total.bus.lcdBytes += cost.bus.lcdBytes;
+        total.bus.dmaBytes += cost.bus.dmaBytes;
+        ++frames;
+
+        VirtualBoard_Advance(FRAME_MS);
+    }
+
+    virtual_stats_t end;
+    VirtualBoard_GetStats(&end);
+    end.i2cBytes -= start.i2cBytes;
+
+    render_stats_t render;
+    Renderer_GetStats(&render);
+
+    if (frames > 0)
+    {
+        printf("  %u frames, renderer %u windows %u skipped\n", frames, render.windows, render.skipped);
+        PrintCost("all frames", &total);
+        printf("  per frame %u px, %u us bus (worst %u us), %u us host\n",
+               total.bus.pixels / frames, VirtualBoard_SpiMicros(&total.bus) / frames, worstMicros,
+               total.hostNanos / 1000 / frames);
+        printf("  sensors and LEDs %u us of I2C per frame\n", VirtualBoard_I2CMicros(&end) / frames);
+    }
+
+    PrintBusStats();
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * driverlib.h
+ *
+ * Virtual board stand-in for the MSP432 DriverLib
+ *  - Only the SPI, DMA and interrupt calls the BoardSupportPackage makes
+ *  - SPI bytes go straight to the virtual LCD and touch controller, DMA
+ *    transfers are run to completion by the call that enables the channel
+ */
+
+#ifndef SIM_DRIVERLIB_H_
+#define SIM_DRIVERLIB_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include "msp.h"
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+/* uDMA */
+#define UDMA_ATTR_USEBURST          0x00000001
+#define UDMA_ATTR_ALTSELECT         0x00000002
+#define UDMA_ATTR_HIGH_PRIORITY     0x00000004
+#define UDMA_ATTR_REQMASK           0x00000008
+#define UDMA_PRI_SELECT             0x00000000
+#define UDMA_ALT_SELECT             0x00000008
+#define UDMA_SIZE_8                 0x00000000
+#define UDMA_SRC_INC_8              0x00000000
+#define UDMA_DST_INC_NONE           0xC0000000
+#define UDMA_ARB_1                  0x00000000
+#define UDMA_MODE_BASIC             0x00000001
+
+#define DMA_CH6_EUSCIB3TX0          0x01000006
+#define DMA_CHANNEL_6               6
+#define DMA_INT1                    INT_DMA_INT1
+
+/* Interrupt numbers as DriverLib counts them (NVIC number + 16) */
+#define INT_DMA_INT1                (DMA_INT1_IRQn + 16)
+#define INT_PORT4                   (PORT4_IRQn + 16)
+#define INT_EUSCIB1                 (EUSCIB1_IRQn + 16)
+
+#define MAP_Interrupt_setPriority   Interrupt_setPriority
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+
+/* SPI, only EUSCI_B3 (LCD and touch panel) is connected */
+void SPI_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData);
+uint8_t SPI_receiveData(uint32_t moduleInstance);
+uint_fast8_t SPI_isBusy(uint32_t moduleInstance);
+uint32_t SPI_getTransmitBufferAddressForDMA(uint32_t moduleInstance);
+
+/* uDMA, only channel 6 (EUSCI_B3 TX) is connected */
+void DMA_enableModule(void);
+void DMA_setControlBase(void* controlTable);
+void DMA_assignChannel(uint32_t mapping);
+void DMA_disableChannelAttribute(uint32_t channelNum, uint32_t attr);
+void DMA_setChannelControl(uint32_t channelStructIndex, uint32_t control);
+void DMA_setChannelTransfer(uint32_t channelStructIndex, uint32_t mode, void* srcAddr, void* dstAddr, uint32_t transferSize);
+void DMA_enableChannel(uint32_t channelNum);
+void DMA_assignInterrupt(uint32_t interruptNumber, uint32_t channel);
+void DMA_clearInterruptFlag(uint32_t intChannel);
+void DMA_enableInterrupt(uint32_t interruptNumber);
+
+void Interrupt_setPriority(uint32_t interruptNumber, uint8_t priority);
+
+/* Board millisecond delay (demo_sysctl.h), which RGBLeds.c uses without including it */
+extern void DelayMs(uint32_t ulClockMS);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* SIM_DRIVERLIB_H_ */
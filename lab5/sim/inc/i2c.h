@@ -0,0 +1,14 @@
+/*
+ * i2c.h
+ *
+ * Virtual board stand-in for the DriverLib I2C header RGBLeds.h includes;
+ * the LP3943 driver programs EUSCI_B2 registers directly, so nothing else is needed
+ */
+
+#ifndef SIM_I2C_H_
+#define SIM_I2C_H_
+
+#include "msp.h"
+#include "driverlib.h"
+
+#endif /* SIM_I2C_H_ */
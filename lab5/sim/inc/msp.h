@@ -0,0 +1,218 @@
+/*
+ * msp.h
+ *
+ * Virtual board stand-in for the MSP432P401R device header
+ *  - Declares only the peripherals the BoardSupportPackage touches, laid out
+ *    like the real registers
+ *  - Peripherals with behaviour (the SPI and I2C eUSCIs, ADC14, the LCD
+ *    chip selects on P10 and the DWT cycle counter) are reached through VirtualBoard calls, so every
+ *    register access gives the virtual board a chance to react, the way the
+ *    hardware would between two accesses
+ */
+
+#ifndef SIM_MSP_H_
+#define SIM_MSP_H_
+
+/*********************************************** Includes ********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+/*********************************************** Includes ********************************************************************/
+
+/*********************************************** Global Defines ********************************************************************/
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+/* TI compiler intrinsics and pragmas the drivers use */
+#define __delay_cycles(cycles)  ((void)(cycles))
+
+/* CMSIS interrupt masking and barriers: the host runs one thread and takes no interrupts */
+#define __NVIC_PRIO_BITS        3
+#define __get_BASEPRI()         (0u)
+#define __set_BASEPRI(basepri)  ((void)(basepri))
+#define __DMB()                 __sync_synchronize()
+
+#define BIT0    (0x0001)
+#define BIT1    (0x0002)
+#define BIT2    (0x0004)
+#define BIT3    (0x0008)
+#define BIT4    (0x0010)
+#define BIT5    (0x0020)
+#define BIT6    (0x0040)
+#define BIT7    (0x0080)
+#define BIT8    (0x0100)
+#define BIT9    (0x0200)
+#define BITA    (0x0400)
+#define BITB    (0x0800)
+#define BITC    (0x1000)
+#define BITD    (0x2000)
+#define BITE    (0x4000)
+#define BITF    (0x8000)
+
+/* eUSCI_B */
+#define EUSCI_B_CTLW0_SWRST         (0x0001)
+#define EUSCI_B_CTLW0_TXSTT         (0x0002)
+#define EUSCI_B_CTLW0_TXSTP         (0x0004)
+#define EUSCI_B_CTLW0_TXNACK        (0x0008)
+#define EUSCI_B_CTLW0_TR            (0x0010)
+#define EUSCI_B_CTLW0_UCSSEL_2      (0x0080)
+#define EUSCI_B_CTLW0_SYNC          (0x0100)
+#define EUSCI_B_CTLW0_MODE_0        (0x0000)
+#define EUSCI_B_CTLW0_MODE_3        (0x0600)
+#define EUSCI_B_CTLW0_MST           (0x0800)
+#define EUSCI_B_CTLW0_MSB           (0x2000)
+#define EUSCI_B_CTLW0_CKPL          (0x4000)
+#define EUSCI_B_CTLW0_CKPH          (0x8000)
+#define EUSCI_B_IFG_RXIFG0          (0x0001)
+#define EUSCI_B_IFG_TXIFG0          (0x0002)
+
+#define EUSCI_B0_BASE               (0x40002000)
+#define EUSCI_B1_BASE               (0x40002400)
+#define EUSCI_B2_BASE               (0x40002800)
+#define EUSCI_B3_BASE               (0x40002C00)
+
+/* DWT cycle counter */
+#define CoreDebug_DEMCR_TRCENA_Msk  (0x01000000)
+#define DWT_CTRL_CYCCNTENA_Msk      (0x00000001)
+
+/* ADC14 */
+#define ADC14_CTL0_SC               (0x00000001)
+#define ADC14_CTL0_ENC              (0x00000002)
+#define ADC14_CTL0_ON               (0x00000010)
+#define ADC14_CTL0_MSC              (0x00000080)
+#define ADC14_CTL0_BUSY             (0x00010000)
+#define ADC14_CTL0_CONSEQ_1         (0x00020000)
+#define ADC14_CTL0_SSEL__SMCLK      (0x00200000)
+#define ADC14_CTL0_SHP              (0x04000000)
+#define ADC14_CTL1_RES__14BIT       (0x00000030)
+#define ADC14_CTL1_CH0MAP           (0x00400000)
+#define ADC14_MCTLN_INCH_14         (0x0000000E)
+#define ADC14_MCTLN_INCH_15         (0x0000000F)
+#define ADC14_MCTLN_EOS             (0x00000080)
+
+/*********************************************** Global Defines ********************************************************************/
+
+/*********************************************** Data Structures ********************************************************************/
+
+typedef enum
+{
+    DMA_INT1_IRQn = 33,
+    DMA_INT0_IRQn = 34,
+    PORT4_IRQn = 38,
+    EUSCIB1_IRQn = 21,
+    EUSCIB3_IRQn = 23
+} IRQn_Type;
+
+typedef struct
+{
+    __IO uint16_t CTLW0;
+    __IO uint16_t CTLW1;
+    uint16_t RESERVED0;
+    __IO uint16_t BRW;
+    __IO uint16_t STATW;
+    __IO uint16_t TBCNT;
+    __IO uint16_t RXBUF;
+    __IO uint16_t TXBUF;
+    uint16_t RESERVED1[2];
+    __IO uint16_t I2COA0;
+    __IO uint16_t I2COA1;
+    __IO uint16_t I2COA2;
+    __IO uint16_t I2COA3;
+    __I uint16_t ADDRX;
+    __IO uint16_t ADDMASK;
+    __IO uint16_t I2CSA;
+    uint16_t RESERVED2[4];
+    __IO uint16_t IE;
+    __IO uint16_t IFG;
+    __I uint16_t IV;
+} EUSCI_B_Type;
+
+typedef struct
+{
+    __I uint8_t IN;
+    __IO uint8_t OUT;
+    __IO uint8_t DIR;
+    __IO uint8_t REN;
+    __IO uint8_t DS;
+    __IO uint8_t SEL0;
+    __IO uint8_t SEL1;
+    __IO uint8_t IES;
+    __IO uint8_t IE;
+    __IO uint8_t IFG;
+} DIO_PORT_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DHCSR;
+    __O  uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    __IO uint32_t CTL0;
+    __IO uint32_t CTL1;
+    __IO uint32_t LO0;
+    __IO uint32_t HI0;
+    __IO uint32_t LO1;
+    __IO uint32_t HI1;
+    __IO uint32_t MCTL[32];
+    __IO uint32_t MEM[32];
+} ADC14_Type;
+
+/*********************************************** Data Structures ********************************************************************/
+
+/*********************************************** Virtual Peripherals ********************************************************************/
+
+extern DIO_PORT_Type VirtualBoard_Ports[11];
+extern volatile uint32_t VirtualBoard_BitBandDummy;
+extern CoreDebug_Type VirtualBoard_CoreDebug;
+
+EUSCI_B_Type* VirtualBoard_EUSCI_B(uint8_t module);
+ADC14_Type* VirtualBoard_ADC14();
+DWT_Type* VirtualBoard_DWT();
+volatile uint8_t* VirtualBoard_Port10Out();
+
+#define EUSCI_B1    (VirtualBoard_EUSCI_B(1))
+#define EUSCI_B2    (VirtualBoard_EUSCI_B(2))
+#define EUSCI_B3    (VirtualBoard_EUSCI_B(3))
+#define ADC14       (VirtualBoard_ADC14())
+#define DWT         (VirtualBoard_DWT())
+#define CoreDebug   (&VirtualBoard_CoreDebug)
+
+#define P1          (&VirtualBoard_Ports[1])
+#define P2          (&VirtualBoard_Ports[2])
+#define P3          (&VirtualBoard_Ports[3])
+#define P4          (&VirtualBoard_Ports[4])
+#define P5          (&VirtualBoard_Ports[5])
+#define P6          (&VirtualBoard_Ports[6])
+#define P7          (&VirtualBoard_Ports[7])
+#define P8          (&VirtualBoard_Ports[8])
+#define P9          (&VirtualBoard_Ports[9])
+#define P10         (&VirtualBoard_Ports[10])
+
+/* P10.4 and P10.5 are the LCD and touch panel chip selects */
+#define P10OUT      (*VirtualBoard_Port10Out())
+#define P10DIR      (P10->DIR)
+#define P6SEL0      (P6->SEL0)
+#define P6SEL1      (P6->SEL1)
+
+/* Bit-band writes only toggle pins nothing listens to */
+#define BITBAND_PERI(reg, bit)  (VirtualBoard_BitBandDummy)
+
+/* Interrupt controller: nothing to configure on the host */
+#define NVIC_SetPriority(irq, priority)     ((void)(irq), (void)(priority))
+#define NVIC_EnableIRQ(irq)                 ((void)(irq))
+#define NVIC_DisableIRQ(irq)                ((void)(irq))
+
+/*********************************************** Virtual Peripherals ********************************************************************/
+
+#endif /* SIM_MSP_H_ */
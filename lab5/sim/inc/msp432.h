@@ -0,0 +1,12 @@
+/*
+ * msp432.h
+ *
+ * Virtual board stand-in, the sensor drivers include the device header by this name
+ */
+
+#ifndef SIM_MSP432_H_
+#define SIM_MSP432_H_
+
+#include "msp.h"
+
+#endif /* SIM_MSP432_H_ */
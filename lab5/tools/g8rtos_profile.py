@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+g8rtos_profile.py
+
+Symbolises a G8RTOS_ProfilerDump capture and prints a flat profile and a
+per-thread breakdown.
+
+The capture is the back channel UART log (any lines that are not profiler
+output are ignored). Symbols come from the TI linker map file (.map) or,
+with --elf, from the ELF output through an nm tool.
+
+Usage:
+    g8rtos_profile.py capture.log lab5.map
+    g8rtos_profile.py capture.log lab5.out --elf [--nm arm-none-eabi-nm]
+    g8rtos_profile.py capture.log lab5.map --callers
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+SAMPLE_LINE = re.compile(r'prof ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})')
+THREAD_LINE = re.compile(r'thread ([0-9a-fA-F]{8}) ([^"]*)')
+MAP_SYMBOL_LINE = re.compile(r'^([0-9a-fA-F]{8})\s+(\S+)\s*$')
+NM_SYMBOL_LINE = re.compile(r'^([0-9a-fA-F]+)\s+[tTwW]\s+(\S+)\s*$')
+
+
+def read_capture(path):
+    """Returns the samples as (thread id, pc, lr) tuples and a thread id -> name dict."""
+    samples = []
+    names = {}
+    with open(path, errors='replace') as capture:
+        for line in capture:
+            match = SAMPLE_LINE.search(line)
+            if match:
+                samples.append(tuple(int(field, 16) for field in match.groups()))
+                continue
+            match = THREAD_LINE.search(line)
+            if match:
+                names[int(match.group(1), 16)] = match.group(2).strip()
+    return samples, names
+
+
+def read_map_symbols(path):
+    """Reads the 'SORTED BY Symbol Address' table of a TI linker map file."""
+    symbols = []
+    in_table = False
+    with open(path, errors='replace') as map_file:
+        for line in map_file:
+            if 'SORTED BY Symbol Address' in line:
+                in_table = True
+                continue
+            if in_table:
+                if line.startswith('['):
+                    break
+                match = MAP_SYMBOL_LINE.match(line)
+                if match:
+                    symbols.append((int(match.group(1), 16), match.group(2)))
+    return symbols
+
+
+def read_elf_symbols(path, nm):
+    """Reads the code symbols of an ELF file with an nm tool."""
+    output = subprocess.run([nm, '-n', path], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        match = NM_SYMBOL_LINE.match(line)
+        if match:
+            symbols.append((int(match.group(1), 16), match.group(2)))
+    return symbols
+
+
+class Symboliser:
+    def __init__(self, symbols):
+        # Thumb symbols may carry the low bit, addresses are compared without it
+        table = sorted({(address & ~1, name) for address, name in symbols})
+        self.addresses = [address for address, _ in table]
+        self.names = [name for _, name in table]
+
+    def __call__(self, address):
+        index = bisect.bisect_right(self.addresses, address & ~1) - 1
+        if index < 0:
+            return '0x%08x' % address
+        return self.names[index]
+
+
+def thread_label(thread_id, names):
+    return '%s (0x%08x)' % (names.get(thread_id, '?'), thread_id)
+
+
+def print_table(title, counts, total, limit):
+    print(title)
+    print('  %7s  %6s  %s' % ('samples', '%', 'function'))
+    for name, count in counts.most_common(limit):
+        print('  %7d  %5.1f%%  %s' % (count, 100.0 * count / total, name))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Symbolise a G8RTOS profiler capture')
+    parser.add_argument('capture', help='back channel UART log holding the profiler dump')
+    parser.add_argument('symbols', help='linker map file, or ELF file with --elf')
+    parser.add_argument('--elf', action='store_true', help='read symbols from an ELF file with nm')
+    parser.add_argument('--nm', default='arm-none-eabi-nm', help='nm tool used with --elf')
+    parser.add_argument('--callers', action='store_true', help='attribute samples to the caller (stacked LR) instead of the PC')
+    parser.add_argument('--top', type=int, default=20, help='functions listed per table')
+    args = parser.parse_args()
+
+    samples, names = read_capture(args.capture)
+    if not samples:
+        sys.exit('no profiler samples in %s' % args.capture)
+
+    symbols = read_elf_symbols(args.symbols, args.nm) if args.elf else read_map_symbols(args.symbols)
+    if not symbols:
+        sys.exit('no symbols found in %s' % args.symbols)
+    symbolise = Symboliser(symbols)
+
+    flat = collections.Counter()
+    per_thread = collections.defaultdict(collections.Counter)
+    for thread_id, pc, lr in samples:
+        function = symbolise(lr if args.callers else pc)
+        flat[function] += 1
+        per_thread[thread_id][function] += 1
+
+    total = len(samples)
+    print('%d samples, %d threads\n' % (total, len(per_thread)))
+    print_table('Flat profile' + (' (by caller)' if args.callers else ''), flat, total, args.top)
+
+    for thread_id, counts in sorted(per_thread.items(), key=lambda item: -sum(item[1].values())):
+        thread_total = sum(counts.values())
+        print_table('Thread %s: %d samples (%.1f%%)' % (thread_label(thread_id, names), thread_total, 100.0 * thread_total / total),
+                    counts, thread_total, args.top)
+
+
+if __name__ == '__main__':
+    main()